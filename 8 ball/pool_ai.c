@@ -0,0 +1,319 @@
+#define _POSIX_C_SOURCE 200809L   // For clock_gettime
+
+#include "pool_ai.h"
+#include <math.h>        // For sqrtf, cosf, sinf, INFINITY
+#include <stdlib.h>      // For malloc, free
+#include <time.h>        // For clock_gettime
+
+#define AI_SPEEDS 3               // Speeds tried per aimed shot
+
+// Same six pockets as CheckPockets
+static const Vector2 aiPockets[6] = {
+    {RAIL_WIDTH, RAIL_WIDTH},
+    {TABLE_WIDTH*0.5f, RAIL_WIDTH},
+    {TABLE_WIDTH - RAIL_WIDTH, RAIL_WIDTH},
+    {RAIL_WIDTH, TABLE_HEIGHT - RAIL_WIDTH},
+    {TABLE_WIDTH*0.5f, TABLE_HEIGHT - RAIL_WIDTH},
+    {TABLE_WIDTH - RAIL_WIDTH, TABLE_HEIGHT - RAIL_WIDTH}
+};
+
+static const float aiSpeeds[AI_SPEEDS] = { 7.0f, 13.0f, 20.0f };
+
+// ---------------------- HELPERS ----------------------
+
+static double NowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// xorshift32; state must not be 0
+static unsigned int NextRandom(unsigned int *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static float RandomUnit(unsigned int *state) {
+    return (NextRandom(state) >> 8) / 16777216.0f;
+}
+
+// Independent stream per (seed, round, task), so a rollout's noise does
+// not depend on which thread ran it
+static unsigned int RolloutSeed(unsigned int seed, int round, int task) {
+    unsigned int x = seed ^ (2654435761u * (unsigned int)(round + 1)) ^
+                     (40503u * (unsigned int)(task + 1));
+    x ^= x >> 16;
+    x *= 0x45d9f3bu;
+    x ^= x >> 16;
+    return x ? x : 1u;
+}
+
+static Vector2 Rotate(Vector2 v, float angle) {
+    float c = cosf(angle), s = sinf(angle);
+    return (Vector2){ v.x * c - v.y * s, v.x * s + v.y * c };
+}
+
+// ---------------------- SCORING ----------------------
+
+// What the rules made of one shot, from the shooter's side: the 8-ball
+// outcome from CheckPockets, each newly pocketed object ball by whether
+// it was the shooter's to pot, and a scratch if ApplyScratch ran
+float ScoreShotResult(const Game *before, const Game *after, int shooter) {
+
+    if (after->state == GAME_WON) return AI_SCORE_WIN;
+    if (after->state == GAME_LOST) return -AI_SCORE_WIN;
+
+    float score = 0.0f;
+    for (int i = 1; i < after->ballCount; i++) {
+        if (!after->balls[i].pocketed || before->balls[i].pocketed) continue;
+        int owner = playerIndexForType(before, after->balls[i].type);
+        score += (owner < 0 || owner == shooter) ? AI_SCORE_POT
+                                                 : -AI_SCORE_FOUL_POT;
+    }
+    if (after->state == GAME_SCRATCH) score -= AI_SCORE_SCRATCH;
+    return score;
+}
+
+// ---------------------- CANDIDATES ----------------------
+
+// Object balls the shooter may aim at. The 8 only counts once the
+// shooter's group is cleared.
+static bool IsTarget(const Game *game, int shooter, int ball) {
+    const Ball *b = &game->balls[ball];
+    if (b->pocketed) return false;
+    if (b->type == BALL_EIGHT) {
+        const Player *p = &game->players[shooter];
+        return p->type != PLAYER_NONE && p->ballsRemaining == 0;
+    }
+    int owner = playerIndexForType(game, b->type);
+    return owner < 0 || owner == shooter;
+}
+
+// Cue ball direction that sends `ball` straight at `pocket`
+static Vector2 AimAt(const Game *game, Vector2 cue, int ball, Vector2 pocket) {
+
+    Vector2 target = game->balls[ball].position;
+    float dx = pocket.x - target.x, dy = pocket.y - target.y;
+    float len = sqrtf(dx*dx + dy*dy);
+    Vector2 ghost = target;
+    if (len > 0.001f) {
+        ghost.x -= dx / len * 2 * BALL_RADIUS;
+        ghost.y -= dy / len * 2 * BALL_RADIUS;
+    }
+    dx = ghost.x - cue.x;
+    dy = ghost.y - cue.y;
+    len = sqrtf(dx*dx + dy*dy);
+    if (len < 0.001f) return (Vector2){ 1, 0 };
+    return (Vector2){ dx / len, dy / len };
+}
+
+// Ball in hand: a free spot inside the rails
+static Vector2 RandomPlacement(const Game *game, unsigned int *state) {
+
+    const float margin = RAIL_WIDTH + BALL_RADIUS + 1;
+    for (int attempt = 0; attempt < 32; attempt++) {
+        Vector2 spot = {
+            margin + RandomUnit(state) * (TABLE_WIDTH - 2 * margin),
+            margin + RandomUnit(state) * (TABLE_HEIGHT - 2 * margin)
+        };
+        bool clear = true;
+        for (int i = 1; i < game->ballCount && clear; i++) {
+            clear = game->balls[i].pocketed ||
+                    Distance(spot, game->balls[i].position) > 2 * BALL_RADIUS + 1;
+        }
+        if (clear) return spot;
+    }
+    return game->cueBallPos;
+}
+
+// Indices of the balls the shooter may aim at; returns how many
+static int ListTargets(const Game *game, int shooter, int *targets) {
+    int count = 0;
+    for (int i = 1; i < game->ballCount; i++) {
+        if (IsTarget(game, shooter, i)) targets[count++] = i;
+    }
+    return count;
+}
+
+// A random shot for the shooter: usually a target aimed at a pocket, a
+// quarter of the time a blind one. With ball in hand the cue ball goes
+// to a random free spot first. state is an xorshift32 state, not 0.
+void SampleAIShot(const Game *game, int shooter, unsigned int *state,
+                  AIShot *shot) {
+
+    int targets[MAX_TABLE_BALLS];
+    int targetCount = ListTargets(game, shooter, targets);
+
+    shot->placed = game->state == GAME_SCRATCH;
+    shot->placement = shot->placed ? RandomPlacement(game, state)
+                                   : game->balls[0].position;
+    shot->shot.speed = 2.0f + RandomUnit(state) * (MAX_SHOT_SPEED - 2.0f);
+    if (targetCount > 0 && RandomUnit(state) < 0.75f) {
+        int t = targets[NextRandom(state) % (unsigned int)targetCount];
+        int p = NextRandom(state) % 6;
+        shot->shot.direction = AimAt(game, shot->placement, t, aiPockets[p]);
+    }
+    else {
+        float angle = RandomUnit(state) * 6.2831853f;
+        shot->shot.direction = (Vector2){ cosf(angle), sinf(angle) };
+    }
+}
+
+// Every target into every pocket at a few speeds from the default spot
+// comes first, a round's worth at a time. After that half of each round
+// perturbs the best shot so far and the rest aim at random targets and
+// pockets, with a share of blind shots in case nothing can be potted.
+static void GenerateCandidates(AISearch *search, int count) {
+
+    Game *game = &search->root;
+    bool placing = game->state == GAME_SCRATCH;
+    unsigned int state = RolloutSeed(search->seed, search->rounds, -1);
+
+    int targets[MAX_TABLE_BALLS];
+    int targetCount = ListTargets(game, search->shooter, targets);
+
+    int n = 0;
+    int aimedCount = targetCount * 6 * AI_SPEEDS;
+    Vector2 cue = placing ? game->cueBallPos : game->balls[0].position;
+    for (; n < count && search->nextAimed < aimedCount; n++) {
+        int k = search->nextAimed++;
+        AIShot *c = &search->candidates[n];
+        c->placed = placing;
+        c->placement = cue;
+        c->shot.direction = AimAt(game, cue, targets[k / (6 * AI_SPEEDS)],
+                                  aiPockets[k / AI_SPEEDS % 6]);
+        c->shot.speed = aiSpeeds[k % AI_SPEEDS];
+    }
+
+    if (n == 0 && search->bestScore > -INFINITY) {
+        for (; n < count / 2; n++) {
+            AIShot *c = &search->candidates[n];
+            *c = search->best;
+            c->shot.direction = Rotate(c->shot.direction,
+                                       (RandomUnit(&state) - 0.5f) * 0.05f);
+            c->shot.speed *= 0.85f + 0.3f * RandomUnit(&state);
+            if (c->shot.speed > MAX_SHOT_SPEED) c->shot.speed = MAX_SHOT_SPEED;
+        }
+    }
+
+    for (; n < count; n++)
+        SampleAIShot(game, search->shooter, &state, &search->candidates[n]);
+    search->candidateCount = count;
+}
+
+// ---------------------- SEARCH ----------------------
+
+void DefaultAIConfig(AIConfig *config) {
+    config->budget = 0.5f;
+    config->samples = 4;
+    config->aimError = 0.004f;
+    config->speedError = 0.05f;
+}
+
+// Starts a search from a table at rest. The table is copied, so the
+// game may carry on (drawing, animating the stick) while it runs.
+void BeginAISearch(AISearch *search, const Game *game,
+                   const AIConfig *config, unsigned int seed) {
+
+    search->root = *game;
+    search->config = *config;
+    if (search->config.samples < 1) search->config.samples = 1;
+    if (search->config.samples > AI_MAX_SAMPLES)
+        search->config.samples = AI_MAX_SAMPLES;
+    search->seed = seed ? seed : 1u;
+    search->shooter = game->currentPlayer;
+    search->candidateCount = 0;
+    search->nextAimed = 0;
+    search->rounds = 0;
+    search->evaluated = 0;
+    search->elapsed = 0.0;
+    search->done = false;
+
+    // Fallback if no round ever finishes: straight up the table
+    search->best.placed = game->state == GAME_SCRATCH;
+    search->best.placement = game->cueBallPos;
+    search->best.shot = (ShotParams){ { 1, 0 }, MAX_SHOT_SPEED * 0.5f };
+    search->bestScore = -INFINITY;
+}
+
+// One noisy playout of one candidate, on a private copy of the table
+static void RolloutTask(void *context, int index) {
+
+    AISearch *search = context;
+    const AIConfig *config = &search->config;
+    const AIShot *candidate = &search->candidates[index / config->samples];
+    unsigned int state = RolloutSeed(search->seed, search->rounds, index);
+
+    Game table = search->root;
+    if (candidate->placed && !PlaceCueBall(&table, candidate->placement)) {
+        search->rollouts[index] = -AI_SCORE_WIN;
+        return;
+    }
+
+    Vector2 direction = Rotate(candidate->shot.direction,
+                               (2 * RandomUnit(&state) - 1) * config->aimError);
+    float speed = candidate->shot.speed *
+                  (1 + (2 * RandomUnit(&state) - 1) * config->speedError);
+    SimulateShot(&table, direction, speed);
+    search->rollouts[index] = ScoreShotResult(&search->root, &table,
+                                              search->shooter);
+}
+
+// Runs whole rounds until `slice` seconds have gone or the budget is
+// spent, at least one round per call. Returns true once the search is
+// done; search->best is the shot to play.
+bool ContinueAISearch(AISearch *search, ThreadPool *pool, double slice) {
+
+    double start = NowSeconds();
+    int samples = search->config.samples;
+    int count = pool->workerCount * AI_CANDIDATES_PER_WORKER;
+
+    while (!search->done) {
+        double roundStart = NowSeconds();
+        GenerateCandidates(search, count);
+        RunParallel(pool, count * samples, RolloutTask, search);
+
+        for (int c = 0; c < count; c++) {
+            float total = 0.0f;
+            for (int s = 0; s < samples; s++)
+                total += search->rollouts[c * samples + s];
+            float score = total / samples;
+            if (score > search->bestScore) {
+                search->bestScore = score;
+                search->best = search->candidates[c];
+            }
+        }
+        search->rounds++;
+        search->evaluated += count;
+
+        double now = NowSeconds();
+        search->elapsed += now - roundStart;
+        if (search->elapsed >= search->config.budget) search->done = true;
+        if (now - start >= slice) break;
+    }
+    return search->done;
+}
+
+// Searches for the whole budget in one call. Returns false if the
+// search state could not be allocated.
+bool ChooseAIShot(ThreadPool *pool, const Game *game, const AIConfig *config,
+                  unsigned int seed, AIShot *shot) {
+
+    AISearch *search = malloc(sizeof *search);
+    if (search == NULL) return false;
+
+    BeginAISearch(search, game, config, seed);
+    while (!ContinueAISearch(search, pool, config->budget)) {}
+    *shot = search->best;
+    free(search);
+    return true;
+}
+
+// Plays a chosen shot on the real table, cue placement first
+void PlayAIShot(Game *game, const AIShot *shot) {
+    if (shot->placed && !PlaceCueBall(game, shot->placement))
+        PlaceCueBall(game, game->cueBallPos);
+    StrikeCueBall(game, shot->shot.direction, shot->shot.speed);
+}
@@ -0,0 +1,75 @@
+#ifndef POOL_AI_H
+#define POOL_AI_H
+
+// Monte Carlo computer opponent. Candidate shots are played out with the
+// real engine (SimulateShot, so UpdatePhysics, CheckPockets and the
+// end-of-shot rules) on copies of the table, spread over a thread pool,
+// and scored by what the rules made of them. Each candidate is played
+// several times with a little aim and speed error, so a shot that only
+// works when struck perfectly scores below one that is safe to miss by
+// a degree.
+//
+// A search runs in rounds. A round plays AI_CANDIDATES_PER_WORKER
+// candidates per pool worker, so a round takes about the same time on
+// any machine and more cores simply try more shots within the budget.
+// ContinueAISearch runs whole rounds until a time slice is used up,
+// which lets the caller look for new work between slices.
+
+#include "pool_threads.h"
+
+#define AI_CANDIDATES_PER_WORKER 2
+#define AI_MAX_CANDIDATES (MAX_WORKERS * AI_CANDIDATES_PER_WORKER)
+#define AI_MAX_SAMPLES 8          // Noisy rollouts per candidate
+
+// Scores, from the shooter's side
+#define AI_SCORE_WIN 1000.0f      // Legal 8-ball
+#define AI_SCORE_POT 10.0f        // Each legal object ball
+#define AI_SCORE_FOUL_POT 5.0f    // Each opponent ball, subtracted
+#define AI_SCORE_SCRATCH 30.0f    // Cue ball pocketed, subtracted
+
+typedef struct {
+    float budget;                 // Seconds of search per shot
+    int samples;                  // Rollouts per candidate, 1 to AI_MAX_SAMPLES
+    float aimError;               // Largest aim error per rollout, radians
+    float speedError;             // Largest speed error, fraction of speed
+} AIConfig;
+
+// A shot the computer can play: ball in hand first when placed is set
+typedef struct {
+    ShotParams shot;
+    bool placed;
+    Vector2 placement;
+} AIShot;
+
+typedef struct {
+    Game root;                    // Table being searched, balls at rest
+    AIConfig config;
+    unsigned int seed;
+    int shooter;                  // root.currentPlayer
+
+    // Current round
+    AIShot candidates[AI_MAX_CANDIDATES];
+    float rollouts[AI_MAX_CANDIDATES * AI_MAX_SAMPLES];
+    int candidateCount;
+    int nextAimed;                // Aimed shots handed out so far
+
+    AIShot best;
+    float bestScore;              // Mean rollout score of best
+    int rounds;
+    int evaluated;                // Candidates scored so far
+    double elapsed;               // Seconds spent searching
+    bool done;
+} AISearch;
+
+void DefaultAIConfig(AIConfig *config);
+void BeginAISearch(AISearch *search, const Game *game,
+                   const AIConfig *config, unsigned int seed);
+bool ContinueAISearch(AISearch *search, ThreadPool *pool, double slice);
+bool ChooseAIShot(ThreadPool *pool, const Game *game, const AIConfig *config,
+                  unsigned int seed, AIShot *shot);
+void SampleAIShot(const Game *game, int shooter, unsigned int *state,
+                  AIShot *shot);
+void PlayAIShot(Game *game, const AIShot *shot);
+float ScoreShotResult(const Game *before, const Game *after, int shooter);
+
+#endif // POOL_AI_H
@@ -0,0 +1,292 @@
+#define _POSIX_C_SOURCE 200809L   // For nanosleep
+
+#include "pool_ai_worker.h"
+#include <time.h>        // For nanosleep
+
+#define MAILBOX_MASK (AI_MAILBOX_SIZE - 1)
+
+// ---------------------- MAILBOXES ----------------------
+//
+// head and tail count messages ever popped and pushed. The producer
+// fills slot tail and then publishes it by storing tail + 1 (release);
+// the consumer reads slot head once it sees tail past it (acquire) and
+// hands the slot back by storing head + 1.
+
+static bool PushRequest(AIRequestBox *box, AIRequestKind kind,
+                        const Game *game, unsigned int id) {
+
+    unsigned int tail = atomic_load_explicit(&box->tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&box->head, memory_order_acquire);
+    if (tail - head == AI_MAILBOX_SIZE) return false;
+
+    AIRequest *slot = &box->slots[tail & MAILBOX_MASK];
+    slot->kind = kind;
+    slot->id = id;
+    slot->size = 0;
+    if (game != NULL) {
+        slot->size = SaveSnapshot(game, slot->snapshot, sizeof slot->snapshot);
+        if (slot->size == 0) return false;
+    }
+    atomic_store_explicit(&box->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+// The oldest request, left in place until PopRequest
+static const AIRequest *PeekRequest(AIRequestBox *box) {
+    unsigned int head = atomic_load_explicit(&box->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&box->tail, memory_order_acquire);
+    return head == tail ? NULL : &box->slots[head & MAILBOX_MASK];
+}
+
+static void PopRequest(AIRequestBox *box) {
+    unsigned int head = atomic_load_explicit(&box->head, memory_order_relaxed);
+    atomic_store_explicit(&box->head, head + 1, memory_order_release);
+}
+
+static bool PushResult(AIResultBox *box, const AIResult *result) {
+
+    unsigned int tail = atomic_load_explicit(&box->tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&box->head, memory_order_acquire);
+    if (tail - head == AI_MAILBOX_SIZE) return false;
+    box->slots[tail & MAILBOX_MASK] = *result;
+    atomic_store_explicit(&box->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+static bool PopResult(AIResultBox *box, AIResult *result) {
+
+    unsigned int head = atomic_load_explicit(&box->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&box->tail, memory_order_acquire);
+    if (head == tail) return false;
+    *result = box->slots[head & MAILBOX_MASK];
+    atomic_store_explicit(&box->head, head + 1, memory_order_release);
+    return true;
+}
+
+// ---------------------- SEARCH ----------------------
+
+// Steps a table until every ball is at rest, as the game loop would.
+// Returns false if the game ends or the shot never settles.
+static bool PlayToRest(Game *table) {
+
+    for (int steps = 0; table->ballsMoving || AreBallsMoving(table); steps++) {
+        if (steps == MAX_SIMULATION_STEPS ||
+            (table->state != GAME_PLAYING && table->state != GAME_SCRATCH))
+            return false;
+        StepSimulation(table);
+    }
+    return table->state != GAME_WON && table->state != GAME_LOST;
+}
+
+// Same balls, bit for bit, and the same rule state
+static bool SamePosition(const Game *a, const Game *b) {
+
+    if (a->ballCount != b->ballCount || a->currentPlayer != b->currentPlayer ||
+        a->state != b->state)
+        return false;
+    for (int p = 0; p < 2; p++) {
+        if (a->players[p].type != b->players[p].type ||
+            a->players[p].ballsRemaining != b->players[p].ballsRemaining)
+            return false;
+    }
+    for (int i = 0; i < a->ballCount; i++) {
+        if (a->balls[i].pocketed != b->balls[i].pocketed) return false;
+        if (a->balls[i].pocketed) continue;
+        if (a->balls[i].position.x != b->balls[i].position.x ||
+            a->balls[i].position.y != b->balls[i].position.y)
+            return false;
+    }
+    return a->state != GAME_SCRATCH ||
+           (a->cueBallPos.x == b->cueBallPos.x && a->cueBallPos.y == b->cueBallPos.y);
+}
+
+static void BeginSearch(AIWorker *worker, const Game *table) {
+
+    worker->root = *table;
+    worker->searching = true;
+    if (worker->tree)
+        worker->searching = BeginMCTSSearch(&worker->treeSearch, table,
+                                            worker->seed++);
+    else
+        BeginAISearch(&worker->shotSearch, table, &worker->config,
+                      worker->seed++);
+}
+
+static void HandleRequest(AIWorker *worker, const AIRequest *request) {
+
+    if (request->kind == AI_CANCEL) {
+        worker->searching = false;
+        worker->thinking = false;
+        return;
+    }
+    // A request for a shot is answered even when its table is unreadable
+    if (!LoadSnapshot(&worker->table, request->snapshot, request->size)) {
+        if (request->kind == AI_THINK) {
+            worker->searching = false;
+            worker->thinking = true;
+            worker->thinkId = request->id;
+            worker->failed = true;
+        }
+        return;
+    }
+
+    if (request->kind == AI_PONDER) {
+        worker->thinking = false;
+        worker->searching = false;
+        worker->pondered = PlayToRest(&worker->table);
+        if (worker->pondered) BeginSearch(worker, &worker->table);
+        return;
+    }
+
+    // Carry on if the pondered position is the one that came up
+    if (!(worker->searching && worker->pondered &&
+          SamePosition(&worker->root, &worker->table))) {
+        worker->pondered = false;
+        BeginSearch(worker, &worker->table);
+    }
+    worker->thinking = true;
+    worker->thinkId = request->id;
+    worker->failed = false;
+}
+
+static bool ContinueSearch(AIWorker *worker) {
+    if (worker->tree)
+        return ContinueMCTSSearch(&worker->treeSearch, &worker->pool,
+                                  AI_WORKER_SLICE);
+    return ContinueAISearch(&worker->shotSearch, &worker->pool, AI_WORKER_SLICE);
+}
+
+// Answers the waiting request. A search that could not start (no tree
+// arena) answers at once with a random shot from its table; an
+// unreadable table answers with failed set.
+static void PostResult(AIWorker *worker) {
+
+    AIResult result;
+    result.id = worker->thinkId;
+    result.pondered = worker->pondered;
+    result.failed = worker->failed;
+    if (worker->failed) {
+        result.seconds = 0.0;
+        result.shot = (AIShot){ 0 };
+    }
+    else if (!worker->searching) {
+        result.seconds = 0.0;
+        SampleAIShot(&worker->root, worker->root.currentPlayer,
+                     &worker->seed, &result.shot);
+    }
+    else if (worker->tree) {
+        result.seconds = worker->treeSearch.elapsed;
+        if (!BestMCTSShot(&worker->treeSearch, &result.shot))
+            SampleAIShot(&worker->root, worker->root.currentPlayer,
+                         &worker->seed, &result.shot);
+    }
+    else {
+        result.seconds = worker->shotSearch.elapsed;
+        result.shot = worker->shotSearch.best;
+    }
+
+    // A full mailbox is tried again on the next pass
+    if (PushResult(&worker->results, &result)) {
+        worker->thinking = false;
+        worker->searching = false;
+        worker->failed = false;
+    }
+}
+
+// Searches in short slices and reads the mailbox between them, so a
+// new request replaces the current search within AI_WORKER_SLICE
+static void *AIWorkerMain(void *arg) {
+
+    AIWorker *worker = arg;
+    const struct timespec idle = { 0, AI_IDLE_SLEEP_NS };
+
+    while (!atomic_load_explicit(&worker->stopping, memory_order_acquire)) {
+        const AIRequest *request;
+        while ((request = PeekRequest(&worker->requests)) != NULL) {
+            HandleRequest(worker, request);
+            PopRequest(&worker->requests);
+        }
+
+        bool done = worker->searching && ContinueSearch(worker);
+        if (worker->thinking && (done || !worker->searching)) PostResult(worker);
+        if (!worker->searching || (done && !worker->thinking))
+            nanosleep(&idle, NULL);
+    }
+    return NULL;
+}
+
+// ---------------------- GAME SIDE ----------------------
+
+// Starts the AI thread and its search pool, which leaves one core for
+// the game loop. tree picks MCTS over the one-shot search.
+bool StartAIWorker(AIWorker *worker, const AIConfig *config, bool tree) {
+
+    atomic_init(&worker->requests.head, 0);
+    atomic_init(&worker->requests.tail, 0);
+    atomic_init(&worker->results.head, 0);
+    atomic_init(&worker->results.tail, 0);
+    atomic_init(&worker->stopping, false);
+    worker->nextId = 0;
+    worker->tree = tree;
+    worker->config = *config;
+    worker->searching = false;
+    worker->thinking = false;
+    worker->failed = false;
+    worker->pondered = false;
+    worker->seed = 1u;
+    InitGame(&worker->table);
+
+    int threads = DefaultWorkerCount() - 1;
+    if (!CreateThreadPool(&worker->pool, threads > 1 ? threads : 1))
+        return false;
+
+    if (tree) {
+        MCTSConfig treeConfig;
+        DefaultMCTSConfig(&treeConfig);
+        treeConfig.budget = config->budget;
+        if (!CreateMCTSSearch(&worker->treeSearch, &treeConfig)) {
+            DestroyThreadPool(&worker->pool);
+            return false;
+        }
+    }
+
+    if (pthread_create(&worker->thread, NULL, AIWorkerMain, worker) != 0) {
+        if (tree) FreeMCTSSearch(&worker->treeSearch);
+        DestroyThreadPool(&worker->pool);
+        return false;
+    }
+    return true;
+}
+
+void StopAIWorker(AIWorker *worker) {
+    atomic_store_explicit(&worker->stopping, true, memory_order_release);
+    pthread_join(worker->thread, NULL);
+    if (worker->tree) FreeMCTSSearch(&worker->treeSearch);
+    DestroyThreadPool(&worker->pool);
+}
+
+// The other player has just shot: search where the balls will stop.
+// Best effort; returns false if the mailbox is full.
+bool PonderAIShot(AIWorker *worker, const Game *game) {
+    return PushRequest(&worker->requests, AI_PONDER, game, 0);
+}
+
+// Asks for a shot from a table at rest. The answer arrives through
+// PollAIResult carrying *id. Returns false if the mailbox is full.
+bool RequestAIShot(AIWorker *worker, const Game *game, unsigned int *id) {
+    if (!PushRequest(&worker->requests, AI_THINK, game, worker->nextId + 1))
+        return false;
+    *id = ++worker->nextId;
+    return true;
+}
+
+// Stops pondering or thinking. A result already on its way may still
+// arrive; its id tells it apart.
+bool CancelAIShot(AIWorker *worker) {
+    return PushRequest(&worker->requests, AI_CANCEL, NULL, 0);
+}
+
+// Takes the next finished shot, if any. Never blocks.
+bool PollAIResult(AIWorker *worker, AIResult *result) {
+    return PopResult(&worker->results, result);
+}
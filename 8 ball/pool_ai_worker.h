@@ -0,0 +1,92 @@
+#ifndef POOL_AI_WORKER_H
+#define POOL_AI_WORKER_H
+
+// The computer opponent on a thread of its own, so the game loop never
+// waits on a search. The game posts requests carrying a snapshot of the
+// table (pool_snapshot.c) and polls for chosen shots once per frame.
+// Both directions are single-producer, single-consumer rings with no
+// locks: only the game thread pushes requests and pops results, only
+// the AI thread does the reverse.
+//
+// While the other player's shot is still rolling, the AI thread can
+// ponder: it plays the snapshot to rest itself, which lands on the same
+// bits as the game because the snapshot keeps the collision order, and
+// starts searching that position. When the balls stop and the game asks
+// for a shot, a matching position carries on from the pondered search
+// instead of starting again.
+
+#include "pool_ai.h"
+#include "pool_mcts.h"
+#include "pool_snapshot.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define AI_MAILBOX_SIZE 8         // Messages per ring (a power of two)
+#define AI_WORKER_SLICE 0.005     // Seconds of search between mailbox checks
+#define AI_IDLE_SLEEP_NS 1000000  // Poll interval with nothing to search
+
+typedef enum {
+    AI_PONDER,                    // Other player's shot, may still be rolling
+    AI_THINK,                     // Computer to play from this table at rest
+    AI_CANCEL                     // Drop any search (restart, load)
+} AIRequestKind;
+
+typedef struct {
+    AIRequestKind kind;
+    unsigned int id;              // Echoed in the result of an AI_THINK
+    size_t size;
+    unsigned char snapshot[SNAPSHOT_SIZE_MAX];
+} AIRequest;
+
+typedef struct {
+    unsigned int id;              // Request answered
+    AIShot shot;
+    double seconds;               // Search time behind the shot
+    bool pondered;                // Carried on from a pondered search
+    bool failed;                  // Table unreadable: no shot, play one yourself
+} AIResult;
+
+typedef struct {
+    _Alignas(64) atomic_uint head;        // Next to read, consumer side
+    _Alignas(64) atomic_uint tail;        // Next to write, producer side
+    AIRequest slots[AI_MAILBOX_SIZE];
+} AIRequestBox;
+
+typedef struct {
+    _Alignas(64) atomic_uint head;
+    _Alignas(64) atomic_uint tail;
+    AIResult slots[AI_MAILBOX_SIZE];
+} AIResultBox;
+
+typedef struct {
+    AIRequestBox requests;        // Game thread to AI thread
+    AIResultBox results;          // AI thread to game thread
+    unsigned int nextId;          // Game thread only
+
+    // AI thread only
+    ThreadPool pool;
+    bool tree;                    // MCTS rather than the one-shot search
+    AIConfig config;
+    AISearch shotSearch;
+    MCTSSearch treeSearch;
+    Game table;                   // Scratch for decoding requests
+    Game root;                    // Position being searched
+    bool searching;
+    bool thinking;                // A request is waiting for this search
+    unsigned int thinkId;
+    bool failed;                  // Its table could not be loaded
+    bool pondered;
+    unsigned int seed;
+
+    pthread_t thread;
+    atomic_bool stopping;
+} AIWorker;
+
+bool StartAIWorker(AIWorker *worker, const AIConfig *config, bool tree);
+void StopAIWorker(AIWorker *worker);
+bool PonderAIShot(AIWorker *worker, const Game *game);
+bool RequestAIShot(AIWorker *worker, const Game *game, unsigned int *id);
+bool CancelAIShot(AIWorker *worker);
+bool PollAIResult(AIWorker *worker, AIResult *result);
+
+#endif // POOL_AI_WORKER_H
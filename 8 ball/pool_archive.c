@@ -0,0 +1,259 @@
+#define _POSIX_C_SOURCE 200809L   // For fseeko, fsync
+#define _FILE_OFFSET_BITS 64      // Archives past 2 GB
+
+#include "pool_archive.h"
+#include "pool_replay.h"
+#include <fcntl.h>       // For open
+#include <stdio.h>       // For FILE, fseeko
+#include <stdlib.h>      // For malloc, realloc, free
+#include <string.h>      // For memcmp
+#include <sys/mman.h>    // For mmap, munmap
+#include <sys/stat.h>    // For fstat
+#include <unistd.h>      // For close, fsync
+
+// ---------------------- READING ----------------------
+
+// Maps the file and checks that the header and index fit inside it.
+// Returns false if it is missing, truncated or not an archive.
+bool OpenArchive(ReplayArchive *archive, const char *path) {
+
+    *archive = (ReplayArchive){ NULL, 0, NULL, 0 };
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    void *data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(ArchiveHeader))
+        data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+
+    archive->data = data;
+    archive->size = st.st_size;
+
+    const ArchiveHeader *header = data;
+    if (memcmp(header->magic, "8BAR", 4) != 0 ||
+        header->version != ARCHIVE_VERSION ||
+        header->indexOffset % 8 != 0 ||
+        header->indexOffset > archive->size ||
+        header->gameCount > (archive->size - header->indexOffset) / sizeof(ArchiveGame)) {
+        CloseArchive(archive);
+        return false;
+    }
+
+    archive->games = (const ArchiveGame *)(archive->data + header->indexOffset);
+    archive->gameCount = header->gameCount;
+    return true;
+}
+
+void CloseArchive(ReplayArchive *archive) {
+    if (archive->data != NULL)
+        munmap((void *)archive->data, archive->size);
+    *archive = (ReplayArchive){ NULL, 0, NULL, 0 };
+}
+
+// NULL past the last game
+const ArchiveGame *GetArchiveGame(const ReplayArchive *archive, uint64_t game) {
+    return game < archive->gameCount ? &archive->games[game] : NULL;
+}
+
+// NULL past the game's last shot, or if its block runs off the file
+const ArchiveShot *GetArchiveShot(const ReplayArchive *archive, uint64_t game,
+                                  uint32_t shot) {
+
+    const ArchiveGame *g = GetArchiveGame(archive, game);
+    if (g == NULL || shot >= g->shotCount) return NULL;
+
+    uint64_t offset = g->blockOffset + (uint64_t)shot * sizeof(ArchiveShot);
+    if (offset + sizeof(ArchiveShot) > archive->size) return NULL;
+    return (const ArchiveShot *)(archive->data + offset);
+}
+
+// Puts the table at rest just before shot `shot` of game `game` (the
+// shot count for its final position) by playing the earlier shots from
+// the rack, at the rate the game was recorded at.
+bool LoadArchivePosition(const ReplayArchive *archive, uint64_t game,
+                         uint32_t shot, Game *table) {
+
+    const ArchiveGame *g = GetArchiveGame(archive, game);
+    if (g == NULL || shot > g->shotCount) return false;
+
+    InitGame(table);
+    SetPhysicsRate(table, g->physicsHz);
+
+    for (uint32_t i = 0; i < shot; i++) {
+        const ArchiveShot *s = GetArchiveShot(archive, game, i);
+        if (s == NULL) return false;
+
+        if (s->flags & SHOT_PLACED)
+            PlaceCueBall(table, (Vector2){ s->placeX, s->placeY });
+        StrikeCueBall(table, (Vector2){ s->dirX, s->dirY }, s->speed);
+
+        int steps = 0;
+        do {
+            StepSimulation(table);
+            steps++;
+        } while (table->ballsMoving && steps < MAX_SIMULATION_STEPS);
+    }
+    return true;
+}
+
+// ---------------------- APPENDING ----------------------
+
+typedef struct {
+    FILE *file;
+    uint64_t end;                 // Where the next byte goes
+    ArchiveGame *games;           // Old index, then the games added
+    uint64_t gameCount;
+    uint64_t capacity;
+} ArchiveAppend;
+
+static bool AddGame(ArchiveAppend *append, ArchiveGame game) {
+
+    if (append->gameCount == append->capacity) {
+        uint64_t capacity = append->capacity ? append->capacity * 2 : 64;
+        ArchiveGame *games = realloc(append->games, capacity * sizeof *games);
+        if (games == NULL) return false;
+        append->games = games;
+        append->capacity = capacity;
+    }
+    append->games[append->gameCount++] = game;
+    return true;
+}
+
+static uint16_t PocketedMask(const Game *table) {
+    uint16_t mask = 0;
+    for (int i = 0; i < table->ballCount && i < 16; i++) {
+        if (table->balls[i].pocketed) mask |= 1u << i;
+    }
+    return mask;
+}
+
+// Plays a replay shot by shot and writes one block per game in it. A
+// game starts at a break; shots recorded before the first break are
+// skipped, since their game cannot be rebuilt from the rack.
+static bool AppendReplay(ArchiveAppend *append, const char *path) {
+
+    static Game table;
+    ReplayReader reader;
+    if (!OpenReplay(&reader, path)) return false;
+
+    bool ok = true, inGame = false;
+    ArchiveGame game = { 0 };
+
+    for (int i = 0; i < reader.shotCount && ok; i++) {
+
+        // Keyframes also carry the restarts made while recording
+        if (i == 0 || reader.index[i].keyframeShot == (uint32_t)i)
+            ok = SeekReplay(&reader, &table, i);
+
+        bool placed;
+        Vector2 placement;
+        ShotParams params;
+        ok = ok && ReadReplayShot(&reader, i, &placed, &placement, &params);
+        if (!ok) break;
+
+        if (table.firstShot) {
+            if (inGame && !AddGame(append, game)) {
+                ok = false;
+                break;
+            }
+            game = (ArchiveGame){ append->end, 0, (uint16_t)reader.physicsHz, 0, 0 };
+            inGame = true;
+        }
+
+        ArchiveShot shot = {
+            params.direction.x, params.direction.y, params.speed,
+            placed ? placement.x : 0.0f, placed ? placement.y : 0.0f,
+            0, (placed ? SHOT_PLACED : 0) | (table.firstShot ? SHOT_BREAK : 0),
+            0, (uint8_t)table.currentPlayer, { 0 }
+        };
+
+        if (placed)
+            PlaceCueBall(&table, placement);
+        uint16_t before = PocketedMask(&table);
+        StrikeCueBall(&table, params.direction, params.speed);
+
+        int steps = 0;
+        do {
+            StepSimulation(&table);
+            steps++;
+        } while (table.ballsMoving && steps < MAX_SIMULATION_STEPS);
+
+        if (!inGame) continue;
+
+        shot.pocketed = PocketedMask(&table) & ~before;
+        if (table.state == GAME_SCRATCH) shot.flags |= SHOT_SCRATCH;
+        shot.result = (uint8_t)table.state;
+
+        game.shotCount++;
+        game.result = shot.result;
+        game.player = shot.player;
+        ok = fwrite(&shot, sizeof shot, 1, append->file) == 1;
+        append->end += sizeof shot;
+    }
+
+    if (ok && inGame)
+        ok = AddGame(append, game);
+    CloseReplay(&reader);
+    return ok;
+}
+
+// Adds every game in the replays to the archive, creating it if needed.
+// Nothing is added unless every replay could be read.
+bool AppendReplays(const char *archivePath, const char **replayPaths,
+                   int replayCount, uint64_t *gamesAdded) {
+
+    ArchiveAppend append = { fopen(archivePath, "r+b"), 0, NULL, 0, 0 };
+    ArchiveHeader header;
+    bool ok = true;
+
+    if (append.file == NULL) {
+        append.file = fopen(archivePath, "w+b");
+        if (append.file == NULL) return false;
+        header = (ArchiveHeader){ { '8', 'B', 'A', 'R' }, ARCHIVE_VERSION, 0, sizeof header };
+        ok = fwrite(&header, sizeof header, 1, append.file) == 1;
+        append.end = sizeof header;
+    }
+    else {
+        ok = fread(&header, sizeof header, 1, append.file) == 1 &&
+             memcmp(header.magic, "8BAR", 4) == 0 &&
+             header.version == ARCHIVE_VERSION;
+
+        // Anything after the old index is an append that never committed
+        append.capacity = ok ? header.gameCount : 0;
+        append.games = append.capacity ? malloc(append.capacity * sizeof *append.games) : NULL;
+        ok = ok && (append.capacity == 0 || append.games != NULL) &&
+             fseeko(append.file, (off_t)header.indexOffset, SEEK_SET) == 0 &&
+             fread(append.games, sizeof *append.games, header.gameCount,
+                   append.file) == header.gameCount;
+        append.gameCount = header.gameCount;
+        append.end = header.indexOffset + header.gameCount * sizeof(ArchiveGame);
+    }
+
+    uint64_t oldCount = append.gameCount;
+    ok = ok && fseeko(append.file, (off_t)append.end, SEEK_SET) == 0;
+    for (int i = 0; i < replayCount && ok; i++)
+        ok = AppendReplay(&append, replayPaths[i]);
+
+    // New index, then the header that makes it live
+    static const char padding[8];
+    uint64_t indexOffset = (append.end + 7) & ~(uint64_t)7;
+    ok = ok && fwrite(padding, 1, indexOffset - append.end, append.file) ==
+                   indexOffset - append.end;
+    ok = ok && (append.gameCount == 0 ||
+                fwrite(append.games, sizeof *append.games, append.gameCount,
+                       append.file) == append.gameCount);
+    ok = ok && fflush(append.file) == 0 && fsync(fileno(append.file)) == 0;
+
+    header.gameCount = append.gameCount;
+    header.indexOffset = indexOffset;
+    ok = ok && fseeko(append.file, 0, SEEK_SET) == 0 &&
+         fwrite(&header, sizeof header, 1, append.file) == 1;
+
+    ok = fclose(append.file) == 0 && ok;
+    free(append.games);
+    if (gamesAdded != NULL) *gamesAdded = ok ? append.gameCount - oldCount : 0;
+    return ok;
+}
@@ -0,0 +1,81 @@
+#ifndef POOL_ARCHIVE_H
+#define POOL_ARCHIVE_H
+
+// Many games in one file, for viewers and analytics. The file is mapped
+// read-only and every record has a fixed size, so game N, shot M is two
+// lookups and nothing else is read or parsed. Shots keep their inputs,
+// so any position can be rebuilt by playing the game up to it, and a
+// summary of what each shot did, so statistics need no simulation.
+//
+// File layout, little-endian, read in place:
+//   header  ArchiveHeader: "8BAR", u32 version, u64 game count,
+//           u64 index offset
+//   blocks  per game, its shots as consecutive ArchiveShot records
+//   index   one ArchiveGame per game, 8-byte aligned, at the end
+//
+// Appending writes new blocks and a new index after the old index, then
+// rewrites the header. A crash before that last write leaves the old
+// header pointing at the old, still complete index.
+
+#include "pool_sim.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "pool_archive reads its records in place and needs a little-endian host"
+#endif
+
+#define ARCHIVE_VERSION 1
+
+#define SHOT_PLACED 1             // Cue ball placed before the shot
+#define SHOT_SCRATCH 2            // Ended with the cue ball in hand
+#define SHOT_BREAK 4              // First shot of the game
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint64_t gameCount;
+    uint64_t indexOffset;
+} ArchiveHeader;
+
+typedef struct {
+    uint64_t blockOffset;         // First ArchiveShot of the game
+    uint32_t shotCount;
+    uint16_t physicsHz;           // Rate the game was played at
+    uint8_t result;               // GameState after the last shot
+    uint8_t player;               // Who took the last shot
+} ArchiveGame;
+
+typedef struct {
+    float dirX, dirY, speed;      // The strike
+    float placeX, placeY;         // Cue placement, if SHOT_PLACED
+    uint16_t pocketed;            // Balls 0-15 pocketed by the shot
+    uint8_t flags;                // SHOT_ flags
+    uint8_t result;               // GameState once the balls stopped
+    uint8_t player;               // Who took the shot
+    uint8_t spare[3];
+} ArchiveShot;
+
+_Static_assert(sizeof(ArchiveHeader) == 24, "ArchiveHeader is read in place");
+_Static_assert(sizeof(ArchiveGame) == 16, "ArchiveGame is read in place");
+_Static_assert(sizeof(ArchiveShot) == 28, "ArchiveShot is read in place");
+
+typedef struct {
+    const unsigned char *data;    // The whole file, mapped
+    size_t size;
+    const ArchiveGame *games;
+    uint64_t gameCount;
+} ReplayArchive;
+
+bool OpenArchive(ReplayArchive *archive, const char *path);
+void CloseArchive(ReplayArchive *archive);
+const ArchiveGame *GetArchiveGame(const ReplayArchive *archive, uint64_t game);
+const ArchiveShot *GetArchiveShot(const ReplayArchive *archive, uint64_t game,
+                                  uint32_t shot);
+bool LoadArchivePosition(const ReplayArchive *archive, uint64_t game,
+                         uint32_t shot, Game *table);
+
+bool AppendReplays(const char *archivePath, const char **replayPaths,
+                   int replayCount, uint64_t *gamesAdded);
+
+#endif // POOL_ARCHIVE_H
@@ -0,0 +1,186 @@
+// Replay archive tool.
+//
+//   gcc -std=c11 -O2 -pthread pool_archive_tool.c pool_archive.c
+//       pool_replay.c pool_sim.c pool_simd.c pool_profile.c pool_trace.c
+//       -o pool_archive -lm
+//
+//   ./pool_archive append games.8ba a.8br b.8br ...   add the games in replays
+//   ./pool_archive stats games.8ba                    totals over every game
+//   ./pool_archive show games.8ba N                   shots of game N
+//   ./pool_archive show games.8ba N M                 table before shot M
+
+#include "pool_archive.h"
+#include <inttypes.h>    // For PRIu64
+#include <stdio.h>       // For printf, fprintf
+#include <stdlib.h>      // For strtoull
+#include <string.h>      // For strcmp
+
+#define BREAK_HISTOGRAM 8         // Balls-on-the-break buckets, last is "or more"
+
+static const char *stateNames[] = { "start", "playing", "scratch", "won", "lost" };
+
+static const char *StateName(int state) {
+    return state >= 0 && state <= GAME_LOST ? stateNames[state] : "?";
+}
+
+static int CountBits(unsigned int mask) {
+    int count = 0;
+    for (; mask; mask &= mask - 1) count++;
+    return count;
+}
+
+// ---------------------- COMMANDS ----------------------
+
+static int Append(const char *path, const char **replays, int count) {
+
+    uint64_t added;
+    if (!AppendReplays(path, replays, count, &added)) {
+        fprintf(stderr, "append to %s failed; the archive is unchanged\n", path);
+        return 1;
+    }
+    printf("%" PRIu64 " games added to %s\n", added, path);
+    return 0;
+}
+
+// One pass over the mapped shot blocks; nothing is simulated
+static int Stats(const ReplayArchive *archive) {
+
+    uint64_t shots = 0, scratches = 0, won = 0, lost = 0;
+    uint64_t breaks = 0, breakScratches = 0, breakEights = 0;
+    uint64_t breakBalls[BREAK_HISTOGRAM] = { 0 };
+
+    for (uint64_t g = 0; g < archive->gameCount; g++) {
+        const ArchiveGame *game = GetArchiveGame(archive, g);
+        if (game->result == GAME_WON) won++;
+        if (game->result == GAME_LOST) lost++;
+
+        for (uint32_t i = 0; i < game->shotCount; i++) {
+            const ArchiveShot *shot = GetArchiveShot(archive, g, i);
+            if (shot == NULL) {
+                fprintf(stderr, "game %" PRIu64 " runs off the end of the file\n", g);
+                return 1;
+            }
+            shots++;
+            if (shot->flags & SHOT_SCRATCH) scratches++;
+            if (!(shot->flags & SHOT_BREAK)) continue;
+
+            // Object balls only; the cue ball is bit 0
+            int balls = CountBits(shot->pocketed & ~1u);
+            breaks++;
+            breakBalls[balls < BREAK_HISTOGRAM ? balls : BREAK_HISTOGRAM - 1]++;
+            if (shot->pocketed & 1) breakScratches++;
+            if (shot->pocketed & (1u << 8)) breakEights++;
+        }
+    }
+
+    uint64_t games = archive->gameCount;
+    printf("games            %" PRIu64 "\n", games);
+    printf("shots            %" PRIu64 " (%.1f per game)\n", shots,
+           games ? (double)shots / games : 0.0);
+    printf("scratches        %" PRIu64 " (%.2f%% of shots)\n", scratches,
+           shots ? 100.0 * scratches / shots : 0.0);
+    printf("won on the 8     %" PRIu64 "\n", won);
+    printf("lost on the 8    %" PRIu64 "\n", lost);
+    printf("unfinished       %" PRIu64 "\n", games - won - lost);
+    printf("breaks           %" PRIu64 ", %" PRIu64 " scratched, %" PRIu64
+           " potted the 8\n", breaks, breakScratches, breakEights);
+    for (int k = 0; k < BREAK_HISTOGRAM; k++) {
+        printf("  %d%s on break   %" PRIu64 "\n", k,
+               k == BREAK_HISTOGRAM - 1 ? "+" : " ", breakBalls[k]);
+    }
+    return 0;
+}
+
+static int ShowGame(const ReplayArchive *archive, uint64_t g) {
+
+    const ArchiveGame *game = GetArchiveGame(archive, g);
+    if (game == NULL) {
+        fprintf(stderr, "no game %" PRIu64 " (archive has %" PRIu64 ")\n",
+                g, archive->gameCount);
+        return 1;
+    }
+
+    printf("game %" PRIu64 ": %u shots at %u Hz, %s after player %d's shot\n", g,
+           game->shotCount, game->physicsHz, StateName(game->result),
+           game->player + 1);
+
+    for (uint32_t i = 0; i < game->shotCount; i++) {
+        const ArchiveShot *shot = GetArchiveShot(archive, g, i);
+        if (shot == NULL) return 1;
+        printf("%4u  P%d  dir (%6.3f, %6.3f)  speed %5.2f", i, shot->player + 1,
+               shot->dirX, shot->dirY, shot->speed);
+        if (shot->flags & SHOT_PLACED)
+            printf("  placed (%.1f, %.1f)", shot->placeX, shot->placeY);
+        if (shot->pocketed) {
+            printf("  potted");
+            for (int b = 0; b < 16; b++) {
+                if (shot->pocketed & (1u << b)) printf(" %d", b);
+            }
+        }
+        printf("  -> %s\n", StateName(shot->result));
+    }
+    return 0;
+}
+
+static int ShowPosition(const ReplayArchive *archive, uint64_t g, uint32_t shot) {
+
+    static Game table;
+    if (!LoadArchivePosition(archive, g, shot, &table)) {
+        fprintf(stderr, "no shot %u in game %" PRIu64 "\n", shot, g);
+        return 1;
+    }
+
+    printf("game %" PRIu64 " before shot %u: %s, player %d to play\n", g, shot,
+           StateName(table.state), table.currentPlayer + 1);
+    for (int i = 0; i < table.ballCount; i++) {
+        const Ball *ball = &table.balls[i];
+        if (ball->pocketed)
+            printf("  ball %2d  pocketed\n", ball->number);
+        else
+            printf("  ball %2d  (%.2f, %.2f)\n", ball->number,
+                   ball->position.x, ball->position.y);
+    }
+    return 0;
+}
+
+// ---------------------- MAIN ----------------------
+
+static int Usage(void) {
+    fprintf(stderr,
+            "usage: pool_archive append <archive> <replay>...\n"
+            "       pool_archive stats <archive>\n"
+            "       pool_archive show <archive> <game> [shot]\n");
+    return 2;
+}
+
+int main(int argc, char **argv) {
+
+    if (argc < 3) return Usage();
+
+    if (strcmp(argv[1], "append") == 0) {
+        if (argc < 4) return Usage();
+        return Append(argv[2], (const char **)argv + 3, argc - 3);
+    }
+
+    bool stats = strcmp(argv[1], "stats") == 0;
+    bool show = strcmp(argv[1], "show") == 0;
+    if ((!stats && !show) || (show && argc < 4)) return Usage();
+
+    ReplayArchive archive;
+    if (!OpenArchive(&archive, argv[2])) {
+        fprintf(stderr, "%s is not a readable archive\n", argv[2]);
+        return 1;
+    }
+
+    int status;
+    if (stats)
+        status = Stats(&archive);
+    else if (argc > 4)
+        status = ShowPosition(&archive, strtoull(argv[3], NULL, 10),
+                              (uint32_t)strtoul(argv[4], NULL, 10));
+    else
+        status = ShowGame(&archive, strtoull(argv[3], NULL, 10));
+
+    CloseArchive(&archive);
+    return status;
+}
@@ -0,0 +1,364 @@
+#include "pool_batch.h"
+#include <math.h>        // For sqrtf, fabsf
+#include <stdlib.h>      // For aligned_alloc, free
+
+// ---------------------- LAYOUT ----------------------
+//
+// A block holds BATCH_WIDTH tables. For every ball the block stores one
+// row of BATCH_WIDTH floats per field, so "ball i on every table" is a
+// single aligned vector and the step loops below run across tables:
+//
+//   - integration hands the whole block to IntegrateBallArrays;
+//   - collisions test each ball pair on all tables of the block at once;
+//   - pockets test each ball on all tables of the block at once.
+//
+// Each block is stepped until all of its tables are at rest, so a block
+// of short shots does not wait for a long one elsewhere in the batch.
+// Pocketed balls are parked mid-table with no speed (like StoreLane in
+// pool_sim.c) and masked out of collisions.
+//
+// Only physics runs here. The cue ball and 8-ball are reported as
+// pocketed like any other ball; scratch and win/loss rules are left to
+// the caller, who can apply them to a Game from the outcome.
+
+static const float pocketCentreX[6] = {
+    RAIL_WIDTH, TABLE_WIDTH*0.5f, TABLE_WIDTH - RAIL_WIDTH,
+    RAIL_WIDTH, TABLE_WIDTH*0.5f, TABLE_WIDTH - RAIL_WIDTH
+};
+static const float pocketCentreY[6] = {
+    RAIL_WIDTH, RAIL_WIDTH, RAIL_WIDTH,
+    TABLE_HEIGHT - RAIL_WIDTH, TABLE_HEIGHT - RAIL_WIDTH, TABLE_HEIGHT - RAIL_WIDTH
+};
+
+// ---------------------- ALLOCATION ----------------------
+
+// Allocates room for tableCount tables. Returns false if out of memory.
+bool CreateShotBatch(ShotBatch *batch, int tableCount) {
+
+    batch->capacity = 0;
+    batch->tableCount = 0;
+    batch->blockCount = 0;
+    batch->ballCount = 0;
+
+    int blocks = (tableCount + BATCH_WIDTH - 1) / BATCH_WIDTH;
+    if (blocks < 1) blocks = 1;
+
+    // sizeof(TableBlock) is a multiple of its 32-byte alignment
+    batch->blocks = aligned_alloc(32, (size_t)blocks * sizeof(TableBlock));
+    if (batch->blocks == NULL) return false;
+
+    batch->capacity = blocks * BATCH_WIDTH;
+    return true;
+}
+
+void FreeShotBatch(ShotBatch *batch) {
+    free(batch->blocks);
+    batch->blocks = NULL;
+    batch->capacity = 0;
+    batch->tableCount = 0;
+    batch->blockCount = 0;
+}
+
+// ---------------------- LOADING ----------------------
+
+// Copies one table into its lane, giving the cue ball a new velocity
+static void LoadLane(ShotBatch *batch, int table, const Ball *balls,
+                     Vector2 cueVelocity) {
+
+    TableBlock *block = &batch->blocks[table / BATCH_WIDTH];
+    int lane = table % BATCH_WIDTH;
+
+    for (int i = 0; i < batch->ballCount; i++) {
+        const Ball *ball = &balls[i];
+        Vector2 velocity = i == 0 ? cueVelocity : ball->velocity;
+
+        block->pocketX[i][lane] = ball->position.x;
+        block->pocketY[i][lane] = ball->position.y;
+        if (ball->pocketed) {
+            block->x[i][lane] = TABLE_WIDTH * 0.5f;
+            block->y[i][lane] = TABLE_HEIGHT * 0.5f;
+            block->vx[i][lane] = 0.0f;
+            block->vy[i][lane] = 0.0f;
+            block->pocketed[i][lane] = 1.0f;
+        }
+        else {
+            block->x[i][lane] = ball->position.x;
+            block->y[i][lane] = ball->position.y;
+            block->vx[i][lane] = velocity.x;
+            block->vy[i][lane] = velocity.y;
+            block->pocketed[i][lane] = 0.0f;
+        }
+    }
+}
+
+// Fills the unused lanes of the last block with tables that never move
+static void PadLastBlock(ShotBatch *batch) {
+
+    TableBlock *block = &batch->blocks[batch->blockCount - 1];
+
+    for (int table = batch->tableCount;
+         table < batch->blockCount * BATCH_WIDTH; table++) {
+        int lane = table % BATCH_WIDTH;
+        for (int i = 0; i < batch->ballCount; i++) {
+            block->x[i][lane] = TABLE_WIDTH * 0.5f;
+            block->y[i][lane] = TABLE_HEIGHT * 0.5f;
+            block->vx[i][lane] = 0.0f;
+            block->vy[i][lane] = 0.0f;
+            block->pocketed[i][lane] = 1.0f;
+            block->pocketX[i][lane] = TABLE_WIDTH * 0.5f;
+            block->pocketY[i][lane] = TABLE_HEIGHT * 0.5f;
+        }
+    }
+}
+
+static bool BeginLoad(ShotBatch *batch, const Game *game, int count) {
+
+    if (count < 1 || count > batch->capacity) return false;
+    if (game->ballCount > MAX_BALLS) return false;
+
+    batch->tableCount = count;
+    batch->blockCount = (count + BATCH_WIDTH - 1) / BATCH_WIDTH;
+    batch->ballCount = game->ballCount;
+    batch->stepScale = game->stepScale;
+    batch->stepFriction = game->stepFriction;
+    return true;
+}
+
+// Loads count tables as they are, balls already moving. All games must
+// have the same ball count; the first one sets the physics rate.
+bool LoadBatchTables(ShotBatch *batch, const Game *games, int count) {
+
+    if (!BeginLoad(batch, &games[0], count)) return false;
+
+    for (int t = 0; t < count; t++) {
+        if (games[t].ballCount != batch->ballCount) return false;
+        LoadLane(batch, t, games[t].balls, games[t].balls[0].velocity);
+    }
+    PadLastBlock(batch);
+    return true;
+}
+
+// Loads count copies of one table at rest, each struck with its own shot
+bool LoadBatchShots(ShotBatch *batch, const Game *game,
+                    const ShotParams *shots, int count) {
+
+    if (!BeginLoad(batch, game, count)) return false;
+
+    for (int t = 0; t < count; t++) {
+        float speed = shots[t].speed;
+        if (speed > MAX_SHOT_SPEED)
+            speed = MAX_SHOT_SPEED;
+        Vector2 cueVelocity = { shots[t].direction.x * speed,
+                                shots[t].direction.y * speed };
+        LoadLane(batch, t, game->balls, cueVelocity);
+    }
+    PadLastBlock(batch);
+    return true;
+}
+
+// ---------------------- BLOCK STEP ----------------------
+
+// True if ball i is rolling on any table of the block
+static bool RowMoving(const TableBlock *block, int i) {
+    int moving = 0;
+    for (int w = 0; w < BATCH_WIDTH; w++)
+        moving |= (block->vx[i][w] != 0.0f) | (block->vy[i][w] != 0.0f);
+    return moving != 0;
+}
+
+// Collision response for one ball pair on every table of the block.
+// Same response as ResolveBallPair in pool_sim.c, written as masked
+// arithmetic (hit is 1 or 0 per table) so the lane loop has no branches.
+static void ResolveBlockHits(float *restrict xi, float *restrict yi,
+                             float *restrict vxi, float *restrict vyi,
+                             float *restrict xj, float *restrict yj,
+                             float *restrict vxj, float *restrict vyj,
+                             const float *restrict hit) {
+
+    const float minDist = BALL_RADIUS * 2.0f;
+
+    for (int w = 0; w < BATCH_WIDTH; w++) {
+        float dx = xj[w] - xi[w];
+        float dy = yj[w] - yi[w];
+
+        // Lanes without a hit get a harmless unit distance
+        float dist = sqrtf((dx*dx + dy*dy) * hit[w] + (1.0f - hit[w]));
+        float nx = dx / dist;
+        float ny = dy / dist;
+
+        // Push balls apart equally
+        float overlap = hit[w] * 0.5f * (minDist - dist + 0.001f);
+        xi[w] -= nx * overlap;
+        yi[w] -= ny * overlap;
+        xj[w] += nx * overlap;
+        yj[w] += ny * overlap;
+
+        // Equal mass elastic collision: swapping the normal components
+        // is the same as moving their difference from one ball to the other
+        float exchange = hit[w] * ((vxj[w]*nx + vyj[w]*ny) -
+                                   (vxi[w]*nx + vyi[w]*ny));
+        vxi[w] += exchange * nx;
+        vyi[w] += exchange * ny;
+        vxj[w] -= exchange * nx;
+        vyj[w] -= exchange * ny;
+
+        // Clamp speeds to avoid unrealistic speed. excess is max(0, d)
+        // written without a compare, so scale is exactly 1 under the limit.
+        float d = sqrtf(vxi[w]*vxi[w] + vyi[w]*vyi[w]) - MAX_BALL_SPEED;
+        float scale = MAX_BALL_SPEED / (MAX_BALL_SPEED + 0.5f * (d + fabsf(d)));
+        vxi[w] *= scale;
+        vyi[w] *= scale;
+        d = sqrtf(vxj[w]*vxj[w] + vyj[w]*vyj[w]) - MAX_BALL_SPEED;
+        scale = MAX_BALL_SPEED / (MAX_BALL_SPEED + 0.5f * (d + fabsf(d)));
+        vxj[w] *= scale;
+        vyj[w] *= scale;
+    }
+}
+
+// Ball pair (i, j) on every table of the block. Returns true if any
+// table had a hit.
+static bool ResolveBlockPair(TableBlock *block, int i, int j) {
+
+    const float minDist = BALL_RADIUS * 2.0f;
+    float hit[BATCH_WIDTH];
+    int any = 0;
+
+    // Cheap overlap test first; most pairs touch on no table at all
+    for (int w = 0; w < BATCH_WIDTH; w++) {
+        float dx = block->x[j][w] - block->x[i][w];
+        float dy = block->y[j][w] - block->y[i][w];
+        float distSq = dx*dx + dy*dy;
+        int overlap = (distSq < minDist*minDist) & (distSq > 0.0001f*0.0001f) &
+                      (block->pocketed[i][w] == 0.0f) &
+                      (block->pocketed[j][w] == 0.0f);
+        hit[w] = overlap ? 1.0f : 0.0f;
+        any |= overlap;
+    }
+    if (!any) return false;
+
+    ResolveBlockHits(block->x[i], block->y[i], block->vx[i], block->vy[i],
+                     block->x[j], block->y[j], block->vx[j], block->vy[j],
+                     hit);
+    return true;
+}
+
+// Brute-force pair pass; with at most MAX_BALLS per table a grid would
+// cost more than it saves. Pairs resting on every table are skipped.
+static void CheckBlockCollisions(TableBlock *block, int ballCount,
+                                 bool *moving) {
+
+    for (int i = 0; i < ballCount; i++) {
+        for (int j = i + 1; j < ballCount; j++) {
+            if (!moving[i] && !moving[j]) continue;
+            if (ResolveBlockPair(block, i, j)) {
+                moving[i] = true;
+                moving[j] = true;
+            }
+        }
+    }
+}
+
+// Pocket test for ball i on every table of the block
+static void CheckBlockPockets(TableBlock *block, int i) {
+
+    float *restrict x = block->x[i], *restrict y = block->y[i];
+    float *restrict vx = block->vx[i], *restrict vy = block->vy[i];
+    float *restrict pocketed = block->pocketed[i];
+    float *restrict pocketX = block->pocketX[i], *restrict pocketY = block->pocketY[i];
+
+    int inside[BATCH_WIDTH] = {0};
+
+    for (int p = 0; p < 6; p++) {
+        for (int w = 0; w < BATCH_WIDTH; w++) {
+            float dx = x[w] - pocketCentreX[p];
+            float dy = y[w] - pocketCentreY[p];
+            inside[w] |= dx*dx + dy*dy < POCKET_RADIUS * POCKET_RADIUS;
+        }
+    }
+
+    for (int w = 0; w < BATCH_WIDTH; w++) {
+        int drop = inside[w] & (pocketed[w] == 0.0f);
+
+        // Remember the entry point, then park the ball like StoreLane
+        pocketX[w] = drop ? x[w] : pocketX[w];
+        pocketY[w] = drop ? y[w] : pocketY[w];
+        x[w] = drop ? TABLE_WIDTH * 0.5f : x[w];
+        y[w] = drop ? TABLE_HEIGHT * 0.5f : y[w];
+        vx[w] = drop ? 0.0f : vx[w];
+        vy[w] = drop ? 0.0f : vy[w];
+        pocketed[w] = drop ? 1.0f : pocketed[w];
+    }
+}
+
+// Steps one block until all of its tables are at rest and writes the
+// outcomes of its live tables
+static void RunBlock(const ShotBatch *batch, int blockIndex,
+                     ShotOutcome *outcomes) {
+
+    TableBlock *block = &batch->blocks[blockIndex];
+    int ballCount = batch->ballCount;
+    int steps[BATCH_WIDTH];
+    bool moving[MAX_BALLS];
+
+    // Every shot takes at least one step, as in SimulateShot
+    for (int w = 0; w < BATCH_WIDTH; w++)
+        steps[w] = 1;
+
+    for (int step = 1; step <= MAX_SIMULATION_STEPS; step++) {
+
+        // Move, apply friction, bounce off rails and limit speed
+        IntegrateBallArrays(&block->x[0][0], &block->y[0][0],
+                            &block->vx[0][0], &block->vy[0][0],
+                            ballCount * BATCH_WIDTH,
+                            batch->stepScale, batch->stepFriction);
+
+        for (int i = 0; i < ballCount; i++)
+            moving[i] = RowMoving(block, i);
+
+        // Ball-to-ball collision
+        CheckBlockCollisions(block, ballCount, moving);
+
+        // Check pocketing (a ball at rest everywhere cannot drop)
+        for (int i = 0; i < ballCount; i++) {
+            if (moving[i])
+                CheckBlockPockets(block, i);
+        }
+
+        // Tables with a ball still rolling need another step
+        int rolling[BATCH_WIDTH] = {0};
+        int anyRolling = 0;
+        for (int i = 0; i < ballCount; i++) {
+            for (int w = 0; w < BATCH_WIDTH; w++)
+                rolling[w] |= (block->vx[i][w] != 0.0f) | (block->vy[i][w] != 0.0f);
+        }
+        for (int w = 0; w < BATCH_WIDTH; w++) {
+            if (rolling[w] && step < MAX_SIMULATION_STEPS)
+                steps[w] = step + 1;
+            anyRolling |= rolling[w];
+        }
+        if (!anyRolling) break;
+    }
+
+    for (int w = 0; w < BATCH_WIDTH; w++) {
+        int table = blockIndex * BATCH_WIDTH + w;
+        if (table >= batch->tableCount) break;
+
+        ShotOutcome *outcome = &outcomes[table];
+        for (int i = 0; i < ballCount; i++) {
+            bool pocketed = block->pocketed[i][w] != 0.0f;
+            outcome->pocketed[i] = pocketed;
+            outcome->positions[i].x = pocketed ? block->pocketX[i][w] : block->x[i][w];
+            outcome->positions[i].y = pocketed ? block->pocketY[i][w] : block->y[i][w];
+        }
+        outcome->steps = steps[w];
+    }
+}
+
+// ---------------------- ENTRY POINT ----------------------
+
+// Plays every loaded table until it is at rest. outcomes needs one entry
+// per loaded table; only the first ballCount balls of each are written.
+void RunShotBatch(ShotBatch *batch, ShotOutcome *outcomes) {
+    for (int b = 0; b < batch->blockCount; b++)
+        RunBlock(batch, b, outcomes);
+}
@@ -0,0 +1,44 @@
+#ifndef POOL_BATCH_H
+#define POOL_BATCH_H
+
+// Batched shot simulator. Many tables are stepped in lockstep with the
+// data laid out ball-major and table-minor, so the per-step work runs
+// across tables (8 at a time) instead of across the balls of one table.
+// Meant for evaluating one position under thousands of candidate shots.
+
+#include "pool_sim.h"
+
+#define BATCH_WIDTH 8             // Tables stepped together in one block
+
+// BATCH_WIDTH tables side by side: element [ball][lane] is that ball on
+// table (block * BATCH_WIDTH + lane)
+typedef struct {
+    _Alignas(32) float x[MAX_BALLS][BATCH_WIDTH];
+    _Alignas(32) float y[MAX_BALLS][BATCH_WIDTH];
+    _Alignas(32) float vx[MAX_BALLS][BATCH_WIDTH];
+    _Alignas(32) float vy[MAX_BALLS][BATCH_WIDTH];
+    _Alignas(32) float pocketed[MAX_BALLS][BATCH_WIDTH];  // 1.0 once pocketed
+    _Alignas(32) float pocketX[MAX_BALLS][BATCH_WIDTH];   // Position at entry
+    _Alignas(32) float pocketY[MAX_BALLS][BATCH_WIDTH];
+} TableBlock;
+
+// All tables of a batch. Every table shares the ball count and the
+// physics rate of the Game it was loaded from.
+typedef struct {
+    int capacity;            // Tables allocated
+    int tableCount;          // Tables loaded
+    int blockCount;          // tableCount rounded up to whole blocks
+    int ballCount;           // Balls per table (at most MAX_BALLS)
+    float stepScale;         // Copied from Game
+    float stepFriction;
+    TableBlock *blocks;
+} ShotBatch;
+
+bool CreateShotBatch(ShotBatch *batch, int tableCount);
+void FreeShotBatch(ShotBatch *batch);
+bool LoadBatchTables(ShotBatch *batch, const Game *games, int count);
+bool LoadBatchShots(ShotBatch *batch, const Game *game,
+                    const ShotParams *shots, int count);
+void RunShotBatch(ShotBatch *batch, ShotOutcome *outcomes);
+
+#endif // POOL_BATCH_H
@@ -0,0 +1,1391 @@
+// Headless physics benchmarks.
+//
+//   gcc -std=c11 -O2 -pthread -DMAX_TABLE_BALLS=1024 pool_bench.c pool_sim.c
+//       pool_simd.c pool_profile.c pool_trace.c pool_batch.c pool_threads.c
+//       pool_trajectory.c pool_snapshot.c pool_zobrist.c pool_ai.c
+//       pool_mcts.c pool_ai_worker.c pool_physics_thread.c pool_events.c
+//       -o pool_bench -lm
+//
+// MAX_TABLE_BALLS must cover the largest synthetic table below.
+//
+//   ./pool_bench           everything below, as tables
+//   ./pool_bench --suite   the seeded scenario suite only
+//   ./pool_bench --json    the same suite as JSON, for diffing commits
+//   ./pool_bench --hash    fixed-point determinism check
+
+#define _POSIX_C_SOURCE 200809L   // For clock_gettime, nanosleep, pthread_kill
+
+#include "pool_ai.h"
+#include "pool_ai_worker.h"
+#include "pool_physics_thread.h"
+#include "pool_mcts.h"
+#include "pool_batch.h"
+#include "pool_events.h"
+#include "pool_threads.h"
+#include "pool_profile.h"
+#include "pool_trajectory.h"
+#include "pool_snapshot.h"
+#include "pool_zobrist.h"
+#include <math.h>        // For cosf, sinf
+#include <signal.h>      // For sigaction, pthread_kill
+#include <stdio.h>       // For printf
+#include <stdlib.h>      // For malloc, calloc, free, abs, llabs
+#include <string.h>      // For memcmp, strcmp
+#include <time.h>        // For clock_gettime, nanosleep
+
+#define BENCH_FRAMES 240          // Physics steps measured per table
+#define BENCH_SHOTS 4096          // Candidate shots per batch run
+#define BENCH_BATCH_TOLERANCE 0.5f // Batched positions agree within this (px)
+#define BENCH_POOL_SHOTS 2048     // Shots per thread pool run
+#define BENCH_HASH_BREAKS 3000    // Seeded breaks in the --hash check
+#define BENCH_ROLLS 2048          // Lone-ball shots in the roll benchmark
+#define BENCH_EVENT_BREAKS 32     // Break angles for the event solver
+#define BENCH_EVENT_SAFETIES 64   // Soft shots on a broken table for it
+#define BENCH_EVENT_HZ 1920       // Step rate it is compared against
+#define BENCH_TRAJECTORY_SHOTS 40 // Shots recorded frame by frame
+#define BENCH_SNAPSHOTS 100000    // Saves and loads timed per snapshot benchmark
+#define BENCH_HASH_SHOTS 400      // Shots hashed incrementally in the Zobrist check
+#define BENCH_PROBES (1 << 22)    // Transposition table stores and probes
+#define BENCH_AI_SHOTS 60         // Shots the computer plays against itself
+#define BENCH_AI_BUDGET 0.05f     // Seconds of search per shot
+#define BENCH_MCTS_SHOTS 20       // Shots the tree search plays against itself
+#define BENCH_MCTS_BUDGET 0.2f    // Seconds of tree search per shot
+#define BENCH_WORKER_SHOTS 10     // Computer shots in the threaded game loop
+#define BENCH_WORKER_SPEED 8      // Its table runs this many times real time
+#define BENCH_LOOP_SHOTS 4        // Shots through the stalling game loop
+#define BENCH_STALL_EVERY 30      // Every this many frames one is slow
+#define BENCH_STALL 0.1           // Seconds the slow frame takes
+#define BENCH_LONG_STALL 0.4      // Every fourth slow frame, past the catch-up
+#define SUITE_BREAKS 32           // Break angles in the scenario suite
+#define SUITE_SAFETIES 64         // Slow safety shots in the scenario suite
+#define SUITE_DENSE_RUNS 3        // Seeded layouts per dense table size
+#define SUITE_DENSE_STEPS 4000    // Step cap for a dense table to settle
+#define SUITE_REPEATS 5           // Runs per scenario; the fastest is kept
+
+// ---------------------- HELPERS ----------------------
+
+static double NowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Small deterministic generator so every run sees the same tables
+static unsigned int benchSeed = 12345u;
+
+static float RandomRange(float lo, float hi) {
+    benchSeed = benchSeed * 1664525u + 1013904223u;
+    return lo + (hi - lo) * ((benchSeed >> 8) / 16777216.0f);
+}
+
+// Fills the table with `count` balls at random positions and speeds
+static void LayoutRandomTable(Game *game, int count) {
+
+    if (count > MAX_TABLE_BALLS) count = MAX_TABLE_BALLS;
+
+    InitGame(game);
+    game->ballCount = count;
+    game->state = GAME_PLAYING;
+
+    for (int i = 0; i < count; i++) {
+        Ball *ball = &game->balls[i];
+        if (i >= MAX_BALLS) {
+            ball->type = (i % 2) ? BALL_SOLID : BALL_STRIPE;
+            ball->isStriped = (i % 2) == 0;
+            ball->number = i;
+        }
+        ball->pocketed = false;
+        ball->position.x = RandomRange(RAIL_WIDTH + BALL_RADIUS,
+                                       TABLE_WIDTH - RAIL_WIDTH - BALL_RADIUS);
+        ball->position.y = RandomRange(RAIL_WIDTH + BALL_RADIUS,
+                                       TABLE_HEIGHT - RAIL_WIDTH - BALL_RADIUS);
+        ball->velocity.x = RandomRange(-8.0f, 8.0f);
+        ball->velocity.y = RandomRange(-8.0f, 8.0f);
+    }
+    RebuildTableState(game);
+}
+
+// Steps the table until every ball is at rest or `limit` steps pass. A
+// game won or lost mid-roll is not stepped any more, so it stops there.
+static int RunToRest(Game *game, int limit) {
+    int steps = 0;
+    do {
+        StepSimulation(game);
+        steps++;
+    } while (game->ballsMoving && steps < limit &&
+             (game->state == GAME_PLAYING || game->state == GAME_SCRATCH));
+    return steps;
+}
+
+// ---------------------- BROADPHASE BENCHMARK ----------------------
+
+// Pair tests and time per step for the O(n^2) loop versus the grid,
+// measured on the same evolving table
+static void BenchBroadphase(int count) {
+
+    static Game game, scratch;
+    long brutePairs = 0, gridPairs = 0;
+    double bruteTime = 0.0, gridTime = 0.0;
+
+    LayoutRandomTable(&game, count);
+
+    for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+
+        scratch = game;
+        scratch.stats.pairTests = 0;
+        double start = NowSeconds();
+        CheckCollisionsBruteForce(&scratch);
+        bruteTime += NowSeconds() - start;
+        brutePairs += scratch.stats.pairTests;
+
+        scratch = game;
+        scratch.stats.pairTests = 0;
+        start = NowSeconds();
+        CheckCollisions(&scratch);
+        gridTime += NowSeconds() - start;
+        gridPairs += scratch.stats.pairTests;
+
+        UpdatePhysics(&game);
+    }
+
+    printf("%6d %14.1f %14.1f %14.0f %14.0f\n", count,
+           (double)brutePairs / BENCH_FRAMES,
+           (double)gridPairs / BENCH_FRAMES,
+           bruteTime / BENCH_FRAMES * 1e9,
+           gridTime / BENCH_FRAMES * 1e9);
+}
+
+// ---------------------- BATCH BENCHMARK ----------------------
+
+// Break shots fanned around the cue ball at a spread of speeds, played
+// one by one with SimulateShot and then all at once with RunShotBatch.
+// A batched shot agrees if it pockets the same balls and leaves the
+// others within BENCH_BATCH_TOLERANCE of SimulateShot.
+static void BenchBatch(void) {
+
+    static Game rack, scratch;
+    ShotParams *shots = malloc(BENCH_SHOTS * sizeof *shots);
+    ShotOutcome *outcomes = malloc(BENCH_SHOTS * sizeof *outcomes);
+    ShotOutcome *reference = malloc(BENCH_SHOTS * sizeof *reference);
+    ShotBatch batch;
+
+    if (shots == NULL || outcomes == NULL || reference == NULL ||
+        !CreateShotBatch(&batch, BENCH_SHOTS)) {
+        printf("Shot batch: out of memory\n");
+        free(shots);
+        free(outcomes);
+        free(reference);
+        return;
+    }
+
+    InitGame(&rack);
+    for (int k = 0; k < BENCH_SHOTS; k++) {
+        float angle = 6.2831853f * k / BENCH_SHOTS;
+        shots[k].direction = (Vector2){ cosf(angle), sinf(angle) };
+        shots[k].speed = 6.0f + (k % 17);
+    }
+
+    double start = NowSeconds();
+    for (int k = 0; k < BENCH_SHOTS; k++) {
+        scratch = rack;
+        int steps = SimulateShot(&scratch, shots[k].direction, shots[k].speed);
+        GetShotOutcome(&scratch, steps, &reference[k]);
+    }
+    double sequentialTime = NowSeconds() - start;
+
+    start = NowSeconds();
+    LoadBatchShots(&batch, &rack, shots, BENCH_SHOTS);
+    RunShotBatch(&batch, outcomes);
+    double batchTime = NowSeconds() - start;
+
+    // Each shot counts once, as a pocket mismatch if the pockets differ
+    int pocketMismatches = 0, positionMismatches = 0;
+    float worstError = 0.0f;
+    for (int k = 0; k < BENCH_SHOTS; k++) {
+        bool samePockets = true;
+        float shotError = 0.0f;
+        for (int i = 0; i < rack.ballCount; i++) {
+            if (outcomes[k].pocketed[i] != reference[k].pocketed[i]) {
+                samePockets = false;
+                continue;
+            }
+            if (reference[k].pocketed[i]) continue;
+            float error = Distance(outcomes[k].positions[i], reference[k].positions[i]);
+            if (error > shotError) shotError = error;
+        }
+        if (!samePockets) pocketMismatches++;
+        else if (shotError > BENCH_BATCH_TOLERANCE) positionMismatches++;
+        if (shotError > worstError) worstError = shotError;
+    }
+
+    printf("\nShot batch, %d break shots at %d Hz\n", BENCH_SHOTS, rack.physicsHz);
+    printf("%14s %14s %14s %14s\n", "mode", "shots/s", "pockets diff",
+           "positions diff");
+    printf("%14s %14.0f %14s %14s\n", "sequential", BENCH_SHOTS / sequentialTime,
+           "-", "-");
+    printf("%14s %14.0f %14d %14d\n", "batched", BENCH_SHOTS / batchTime,
+           pocketMismatches, positionMismatches);
+    printf("positions compared within %.1f px, worst difference %.1f px\n",
+           BENCH_BATCH_TOLERANCE, worstError);
+
+    FreeShotBatch(&batch);
+    free(shots);
+    free(outcomes);
+    free(reference);
+}
+
+// ---------------------- ROLL PREDICTION BENCHMARK ----------------------
+
+// A lone cue ball shot in every direction, stepped to rest and then
+// predicted with PredictRoll. Shots that end in a pocket are left out,
+// since the prediction ignores pockets.
+static void BenchRoll(void) {
+
+    static Game table, scratch;
+    InitGame(&table);
+    for (int i = 1; i < table.ballCount; i++)
+        table.balls[i].pocketed = true;
+    RebuildTableState(&table);
+
+    Vector2 start = table.balls[0].position;
+    int compared = 0, worstSteps = 0;
+    float worstError = 0.0f;
+    double steppedTime = 0.0, predictedTime = 0.0;
+
+    for (int k = 0; k < BENCH_ROLLS; k++) {
+        float angle = 6.2831853f * k / BENCH_ROLLS;
+        Vector2 direction = { cosf(angle), sinf(angle) };
+        float speed = 1.0f + (k % 19);
+
+        scratch = table;
+        double t0 = NowSeconds();
+        StrikeCueBall(&scratch, direction, speed);
+        int steps = 0;
+        do {
+            StepSimulation(&scratch);
+            steps++;
+        } while (scratch.ballsMoving && steps < MAX_SIMULATION_STEPS);
+        double t1 = NowSeconds();
+
+        RollPrediction roll;
+        PredictRoll(&table, start,
+                    (Vector2){ direction.x * speed, direction.y * speed }, &roll);
+        double t2 = NowSeconds();
+
+        if (scratch.balls[0].pocketed) continue;
+        steppedTime += t1 - t0;
+        predictedTime += t2 - t1;
+        compared++;
+
+        float error = Distance(scratch.balls[0].position, roll.stopPosition);
+        if (error > worstError) worstError = error;
+        int stepError = abs(steps - roll.stopStep);
+        if (stepError > worstSteps) worstSteps = stepError;
+    }
+
+    printf("\nRoll prediction, %d lone-ball shots at %d Hz\n",
+           compared, table.physicsHz);
+    printf("%14s %14s\n", "mode", "ns/shot");
+    printf("%14s %14.0f\n", "stepped", steppedTime / compared * 1e9);
+    printf("%14s %14.0f\n", "predicted", predictedTime / compared * 1e9);
+    printf("worst stop error %.4f px, %d step(s)\n", worstError, worstSteps);
+}
+
+// ---------------------- EVENT SOLVER BENCHMARK ----------------------
+
+typedef struct {
+    int shots;
+    long events;
+    long steps;
+    double eventTime;
+    double stepTime;
+    int samePockets;              // Shots that pocketed the same balls
+    int capped;                   // Shots that ran out of events
+    int compared;                 // Balls left on the table by both
+    double totalError;            // Position difference over those, px
+    float worstError;
+} EventRun;
+
+// One shot played by SimulateShotEvents and by SimulateShot at
+// BENCH_EVENT_HZ, from the same table
+static void CompareEventShot(const Game *table, Vector2 direction, float speed,
+                             EventRun *run) {
+
+    static Game evented, stepped;
+    evented = *table;
+    stepped = *table;
+    SetPhysicsRate(&stepped, BENCH_EVENT_HZ);
+
+    double start = NowSeconds();
+    int events = SimulateShotEvents(&evented, direction, speed);
+    double middle = NowSeconds();
+    run->steps += SimulateShot(&stepped, direction, speed);
+    run->stepTime += NowSeconds() - middle;
+    run->eventTime += middle - start;
+    run->shots++;
+
+    if (events < 0) {
+        run->capped++;
+        run->events += MAX_SHOT_EVENTS;
+        return;
+    }
+    run->events += events;
+
+    bool same = true;
+    for (int i = 0; i < table->ballCount; i++) {
+        if (evented.balls[i].pocketed != stepped.balls[i].pocketed) {
+            same = false;
+            continue;
+        }
+        if (evented.balls[i].pocketed) continue;
+        float error = Distance(evented.balls[i].position, stepped.balls[i].position);
+        run->totalError += error;
+        run->compared++;
+        if (error > run->worstError) run->worstError = error;
+    }
+    if (same) run->samePockets++;
+}
+
+static void PrintEventRun(const char *name, const EventRun *run) {
+    printf("%8s %6d %12.1f %12.1f %10.1f %10.1f %8d %10.2f %10.2f %7d\n",
+           name, run->shots, (double)run->events / run->shots,
+           (double)run->steps / run->shots,
+           run->eventTime / run->shots * 1e6, run->stepTime / run->shots * 1e6,
+           run->samePockets,
+           run->compared ? run->totalError / run->compared : 0.0,
+           run->worstError, run->capped);
+}
+
+// Breaks fanned over +-6 degrees and soft shots on a broken table, each
+// solved event by event and stepped at a high rate, where stepping
+// comes closest to the continuous motion the solver follows
+static void BenchEvents(void) {
+
+    static Game rack, broken;
+    EventRun breaks = { 0 }, safeties = { 0 };
+
+    InitGame(&rack);
+    for (int k = 0; k < BENCH_EVENT_BREAKS; k++) {
+        float angle = -0.105f + 0.21f * k / (BENCH_EVENT_BREAKS - 1);
+        CompareEventShot(&rack, (Vector2){ cosf(angle), sinf(angle) },
+                         MAX_SHOT_SPEED, &breaks);
+    }
+
+    InitGame(&broken);
+    SimulateShot(&broken, (Vector2){ 1, 0 }, MAX_SHOT_SPEED);
+    broken.state = GAME_PLAYING;
+    if (broken.balls[0].pocketed) {
+        broken.balls[0].pocketed = false;
+        broken.balls[0].position = broken.cueBallPos;
+        RebuildTableState(&broken);
+    }
+    benchSeed = 777u;
+    for (int k = 0; k < BENCH_EVENT_SAFETIES; k++) {
+        float angle = RandomRange(0.0f, 6.2831853f);
+        float speed = RandomRange(2.0f, 5.0f);
+        CompareEventShot(&broken, (Vector2){ cosf(angle), sinf(angle) }, speed,
+                         &safeties);
+    }
+
+    printf("\nEvent solver against SimulateShot at %d Hz\n", BENCH_EVENT_HZ);
+    printf("%8s %6s %12s %12s %10s %10s %8s %10s %10s %7s\n", "shots", "count",
+           "events/shot", "steps/shot", "event us", "step us", "same pk",
+           "mean px", "worst px", "capped");
+    PrintEventRun("break", &breaks);
+    PrintEventRun("safety", &safeties);
+}
+
+// Ghost-ball previews on a broken table: time per preview (roll plus
+// contact cast), and how often the predicted first ball is the one the
+// stepped engine actually hits first
+static void BenchAimPreview(void) {
+
+    static Game table, scratch;
+    InitGame(&table);
+    StrikeCueBall(&table, (Vector2){1, 0}, MAX_SHOT_SPEED);
+    RunToRest(&table, MAX_SIMULATION_STEPS);
+    table.state = GAME_PLAYING;
+    if (table.balls[0].pocketed) {
+        table.balls[0].pocketed = false;
+        table.balls[0].position = table.cueBallPos;
+        RebuildTableState(&table);
+    }
+
+    Vector2 start = table.balls[0].position;
+    int hits = 0, agree = 0;
+    double previewTime = 0.0;
+
+    for (int k = 0; k < BENCH_ROLLS; k++) {
+        float angle = 6.2831853f * k / BENCH_ROLLS;
+        Vector2 direction = { cosf(angle), sinf(angle) };
+        float speed = 1.0f + (k % 19);
+
+        double t0 = NowSeconds();
+        RollPrediction roll;
+        ContactPrediction contact;
+        PredictRoll(&table, start,
+                    (Vector2){ direction.x * speed, direction.y * speed }, &roll);
+        bool hit = PredictContact(&table, 0, &roll, &contact);
+        previewTime += NowSeconds() - t0;
+        if (hit) hits++;
+
+        // First object ball the stepped engine sets moving
+        scratch = table;
+        StrikeCueBall(&scratch, direction, speed);
+        int first = -1, steps = 0;
+        while (first < 0 && !scratch.balls[0].pocketed &&
+               steps < MAX_SIMULATION_STEPS) {
+            StepSimulation(&scratch);
+            steps++;
+            for (int n = 0; n < scratch.awakeCount && first < 0; n++) {
+                if (scratch.awakeList[n] != 0) first = scratch.awakeList[n];
+            }
+            if (!scratch.ballsMoving) break;
+        }
+        if (first == (hit ? contact.ball : -1)) agree++;
+    }
+
+    printf("\nAim preview, %d shots on a broken table (%d hit a ball)\n",
+           BENCH_ROLLS, hits);
+    printf("  %.0f ns per preview, first ball matches the engine in %.1f%%\n",
+           previewTime / BENCH_ROLLS * 1e9, 100.0 * agree / BENCH_ROLLS);
+}
+
+// ---------------------- SNAPSHOT BENCHMARK ----------------------
+
+// Saving and loading a break half a second in, and whether the loaded
+// table finishes the shot in the same bits
+static void BenchSnapshot(void) {
+
+    static Game game, fork;
+    static unsigned char buffer[SNAPSHOT_SIZE_MAX];
+
+    InitGame(&game);
+    StrikeCueBall(&game, (Vector2){1, 0}, MAX_SHOT_SPEED);
+    for (int k = 0; k < game.physicsHz / 2; k++)
+        StepSimulation(&game);
+
+    double start = NowSeconds();
+    size_t size = 0;
+    for (int k = 0; k < BENCH_SNAPSHOTS; k++)
+        size = SaveSnapshot(&game, buffer, sizeof buffer);
+    double saveTime = NowSeconds() - start;
+
+    start = NowSeconds();
+    for (int k = 0; k < BENCH_SNAPSHOTS; k++)
+        LoadSnapshot(&fork, buffer, size);
+    double loadTime = NowSeconds() - start;
+
+    int steps = 0;
+    bool same = true;
+    do {
+        StepSimulation(&game);
+        StepSimulation(&fork);
+        steps++;
+    } while (game.ballsMoving && steps < MAX_SIMULATION_STEPS);
+    for (int i = 0; i < game.ballCount; i++) {
+        same = same && game.balls[i].pocketed == fork.balls[i].pocketed &&
+               memcmp(&game.balls[i].position, &fork.balls[i].position,
+                      sizeof(Vector2)) == 0;
+    }
+
+    printf("\nSnapshots, a break mid-shot (%zu bytes, Game is %zu)\n",
+           size, sizeof(Game));
+    printf("  save %.0f ns, load %.0f ns\n",
+           saveTime / BENCH_SNAPSHOTS * 1e9, loadTime / BENCH_SNAPSHOTS * 1e9);
+    printf("  loaded table finishes the shot %s\n",
+           same ? "identically" : "DIFFERENTLY");
+}
+
+// ---------------------- TRAJECTORY CODEC BENCHMARK ----------------------
+
+// A game of seeded shots drawn at 60 frames per second, encoded as it is
+// played and then decoded: size against raw Vector2 frames, decode speed
+// and the largest position error
+static void BenchTrajectory(void) {
+
+    static Game game, playback;
+    static TrajectoryEncoder encoder;
+    static TrajectoryDecoder decoder;
+    FILE *file = tmpfile();
+    if (file == NULL) {
+        printf("\nTrajectory codec: no temporary file\n");
+        return;
+    }
+
+    InitGame(&game);
+    StartTrajectory(&encoder, file, &game, BASE_FRAME_HZ);
+    int stepsPerFrame = game.physicsHz / BASE_FRAME_HZ;
+    long frames = 0;
+    benchSeed = 31337u;
+
+    // Second pass replays the same seeded game to check every frame
+    for (int pass = 0; pass < 2; pass++) {
+        InitGame(&game);
+        benchSeed = 31337u;
+        float worst = 0.0f;
+        double decodeTime = 0.0;
+
+        if (pass == 1) {
+            rewind(file);
+            if (!OpenTrajectory(&decoder, file)) break;
+            InitGame(&playback);
+        }
+
+        for (int shot = 0; shot < BENCH_TRAJECTORY_SHOTS; shot++) {
+            if (game.state == GAME_WON || game.state == GAME_LOST)
+                InitGame(&game);
+            if (game.state == GAME_SCRATCH)
+                PlaceCueBall(&game, game.cueBallPos);
+
+            float angle = RandomRange(0.0f, 6.2831853f);
+            float speed = shot == 0 ? MAX_SHOT_SPEED : RandomRange(6.0f, 16.0f);
+            StrikeCueBall(&game, (Vector2){ cosf(angle), sinf(angle) }, speed);
+
+            int steps = 0;
+            do {
+                for (int k = 0; k < stepsPerFrame; k++, steps++)
+                    StepSimulation(&game);
+
+                if (pass == 0) {
+                    EncodeTrajectoryFrame(&encoder, &game);
+                    frames++;
+                    continue;
+                }
+
+                double start = NowSeconds();
+                bool ok = DecodeTrajectoryFrame(&decoder);
+                ApplyTrajectoryFrame(&decoder, &playback);
+                decodeTime += NowSeconds() - start;
+                if (!ok) worst = 1e9f;
+
+                for (int i = 0; i < game.ballCount; i++) {
+                    if (game.balls[i].pocketed != playback.balls[i].pocketed)
+                        worst = 1e9f;
+                    if (game.balls[i].pocketed) continue;
+                    float error = Distance(game.balls[i].position,
+                                           playback.balls[i].position);
+                    if (error > worst) worst = error;
+                }
+            } while (game.ballsMoving && steps < MAX_SIMULATION_STEPS);
+        }
+
+        if (pass == 1) {
+            long raw = frames * game.ballCount * (long)sizeof(Vector2);
+            printf("\nTrajectory codec, %d shots, %ld frames of %d balls\n",
+                   BENCH_TRAJECTORY_SHOTS, frames, game.ballCount);
+            printf("  raw %ld bytes, encoded %ld bytes (%.1fx, %.2f bytes/frame)\n",
+                   raw, encoder.bytes, (double)raw / encoder.bytes,
+                   (double)encoder.bytes / frames);
+            printf("  decode %.0f frames/s, worst error %.4f px\n",
+                   frames / decodeTime, worst);
+        }
+    }
+    fclose(file);
+}
+
+// ---------------------- THREAD POOL BENCHMARK ----------------------
+
+// Drag-to-shoot shots around the cue ball, as HandleInput would make
+// them, played on 1..64 threads. Every run must reproduce the outcomes
+// of the single-thread run exactly.
+static void BenchThreadPool(void) {
+
+    static Game rack;
+    static ThreadPool pool;
+    int threadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+    ShotParams *shots = malloc(BENCH_POOL_SHOTS * sizeof *shots);
+    ShotOutcome *reference = calloc(BENCH_POOL_SHOTS, sizeof *reference);
+    ShotOutcome *outcomes = calloc(BENCH_POOL_SHOTS, sizeof *outcomes);
+    double baseRate = 0.0;
+
+    if (shots == NULL || reference == NULL || outcomes == NULL) {
+        printf("Thread pool: out of memory\n");
+        free(shots);
+        free(reference);
+        free(outcomes);
+        return;
+    }
+
+    InitGame(&rack);
+    Vector2 cue = rack.balls[0].position;
+    for (int k = 0; k < BENCH_POOL_SHOTS; k++) {
+        float angle = 6.2831853f * k / BENCH_POOL_SHOTS;
+        float pull = 20.0f + (k % 15) * 10.0f;
+        Vector2 mouse = { cue.x + cosf(angle) * pull, cue.y + sinf(angle) * pull };
+        ShotFromDrag(cue, mouse, pull, &shots[k]);
+    }
+
+    printf("\nThread pool, %d shots, %d CPUs online\n",
+           BENCH_POOL_SHOTS, DefaultWorkerCount());
+    printf("%8s %14s %10s %10s\n", "threads", "shots/s", "speedup", "same");
+
+    for (int c = 0; c < 7; c++) {
+        if (!CreateThreadPool(&pool, threadCounts[c])) {
+            printf("%8d   could not start threads\n", threadCounts[c]);
+            break;
+        }
+        ShotOutcome *target = c == 0 ? reference : outcomes;
+        double start = NowSeconds();
+        SimulateShotsParallel(&pool, &rack, shots, target, BENCH_POOL_SHOTS);
+        double rate = BENCH_POOL_SHOTS / (NowSeconds() - start);
+        DestroyThreadPool(&pool);
+
+        if (c == 0) baseRate = rate;
+        bool same = memcmp(target, reference,
+                           BENCH_POOL_SHOTS * sizeof *reference) == 0;
+        printf("%8d %14.0f %9.2fx %10s\n", threadCounts[c], rate,
+               rate / baseRate, same ? "yes" : "NO");
+    }
+
+    free(shots);
+    free(reference);
+    free(outcomes);
+}
+
+// ---------------------- TRANSPOSITIONS ----------------------
+
+// Hammers a deliberately small table from every worker with keys that
+// collide in their buckets; each stored outcome is derived from its key,
+// so any hit that does not match is a torn or foreign entry
+typedef struct {
+    TranspositionTable *table;
+    atomic_int hits;
+    atomic_int wrong;
+} ProbeJob;
+
+static CachedOutcome OutcomeForKey(uint64_t key) {
+    return (CachedOutcome){ (float)(key & 0xffff), (uint16_t)(1 + (key >> 16) % 1000),
+                            (uint16_t)(key >> 32) };
+}
+
+static void ProbeTask(void *context, int index) {
+
+    ProbeJob *job = context;
+    int hits = 0, wrong = 0;
+    uint64_t x = (uint64_t)index * 0x9e3779b97f4a7c15ull;
+
+    for (int k = 0; k < BENCH_PROBES / 64; k++) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        uint64_t key = (x >> 16) % 50000 * 0xd6e8feb86659fd93ull;
+        CachedOutcome outcome, expected = OutcomeForKey(key);
+        if (k & 1) {
+            StoreTransposition(job->table, key, expected);
+        }
+        else if (ProbeTransposition(job->table, key, &outcome)) {
+            hits++;
+            if (memcmp(&outcome, &expected, sizeof outcome) != 0) wrong++;
+        }
+    }
+    atomic_fetch_add(&job->hits, hits);
+    atomic_fetch_add(&job->wrong, wrong);
+}
+
+static volatile uint64_t hashSink;   // Keeps the hashing from being optimized out
+
+// Plays the same seeded game with the hash kept up to date after every
+// step: incrementally (mode 1), by full rehash (mode 2) or not at all
+// (mode 0, the baseline). Mode 3 does both and counts disagreements.
+static double PlayHashedGame(int mode, long *steps, int *mismatches) {
+
+    static Game game;
+    static TableHash hash;
+    InitGame(&game);
+    InitTableHash(&hash, &game, ZOBRIST_GRID);
+    benchSeed = 2024u;
+    *steps = 0;
+    *mismatches = 0;
+    uint64_t sink = 0;
+
+    double start = NowSeconds();
+    for (int shot = 0; shot < BENCH_HASH_SHOTS; shot++) {
+        if (game.state == GAME_WON || game.state == GAME_LOST)
+            InitGame(&game);
+        if (game.state == GAME_SCRATCH)
+            PlaceCueBall(&game, game.cueBallPos);
+        float angle = RandomRange(0.0f, 6.2831853f);
+        StrikeCueBall(&game, (Vector2){ cosf(angle), sinf(angle) },
+                      RandomRange(4.0f, MAX_SHOT_SPEED));
+        int shotSteps = 0;
+        do {
+            StepSimulation(&game);
+            shotSteps++;
+            if (mode & 1) sink ^= UpdateTableHash(&hash, &game);
+            if (mode & 2) sink ^= HashTablePosition(&game, ZOBRIST_GRID);
+            if (mode == 3 && hash.hash != HashTablePosition(&game, ZOBRIST_GRID))
+                (*mismatches)++;
+        } while (game.ballsMoving && shotSteps < MAX_SIMULATION_STEPS);
+        *steps += shotSteps;
+    }
+    double seconds = NowSeconds() - start;
+    hashSink = sink;
+    return seconds;
+}
+
+// Incremental hashing checked against a full rehash over a seeded game,
+// then transposition table throughput and a lock-free stress test
+static void BenchZobrist(void) {
+
+    long steps;
+    int mismatches, unused;
+    PlayHashedGame(3, &steps, &mismatches);
+    double base = PlayHashedGame(0, &steps, &unused);
+    double incremental = PlayHashedGame(1, &steps, &unused) - base;
+    double full = PlayHashedGame(2, &steps, &unused) - base;
+
+    printf("\nZobrist hashing, %d shots (%ld steps) on a %.0f px grid\n",
+           BENCH_HASH_SHOTS, steps, ZOBRIST_GRID);
+    printf("  per step: update %.1f ns, full rehash %.1f ns, mismatches %d\n",
+           incremental / steps * 1e9, full / steps * 1e9, mismatches);
+
+    static TranspositionTable table;
+    if (!CreateTranspositionTable(&table, 64u << 20)) {
+        printf("  transposition table: out of memory\n");
+        return;
+    }
+    double start = NowSeconds();
+    for (uint64_t k = 0; k < BENCH_PROBES; k++)
+        StoreTransposition(&table, k * 0xd6e8feb86659fd93ull, OutcomeForKey(k));
+    double storeTime = NowSeconds() - start;
+
+    int found = 0;
+    CachedOutcome outcome;
+    start = NowSeconds();
+    for (uint64_t k = 0; k < BENCH_PROBES; k++)
+        found += ProbeTransposition(&table, k * 0xd6e8feb86659fd93ull, &outcome);
+    double probeTime = NowSeconds() - start;
+    FreeTranspositionTable(&table);
+
+    printf("  64 MB table: store %.1f ns, probe %.1f ns, %.1f%% of %d entries kept\n",
+           storeTime / BENCH_PROBES * 1e9, probeTime / BENCH_PROBES * 1e9,
+           100.0 * found / BENCH_PROBES, BENCH_PROBES);
+
+    static ThreadPool pool;
+    if (!CreateTranspositionTable(&table, 256u << 10)) return;
+    int threads = DefaultWorkerCount() > 8 ? DefaultWorkerCount() : 8;
+    if (!CreateThreadPool(&pool, threads)) {
+        FreeTranspositionTable(&table);
+        return;
+    }
+    ProbeJob job = { &table, 0, 0 };
+    RunParallel(&pool, 64, ProbeTask, &job);
+    printf("  shared 256 KB table, %d threads: %d hits, %d wrong\n",
+           pool.workerCount, atomic_load(&job.hits), atomic_load(&job.wrong));
+    DestroyThreadPool(&pool);
+    FreeTranspositionTable(&table);
+}
+
+// ---------------------- DETERMINISM CHECK ----------------------
+
+// Plays BENCH_HASH_BREAKS seeded breaks and hashes every end state. In
+// a -DSIM_FIXED_POINT build the hash must be the same for every
+// compiler, optimization level and instruction set on x86-64; run it
+// from differently built binaries and compare.
+static int CheckFixedHash(void) {
+
+#ifdef SIM_FIXED_POINT
+    static Game game;
+    uint64_t hash = 14695981039346656037ull;
+    long steps = 0;
+    double start = NowSeconds();
+
+    for (int seed = 0; seed < BENCH_HASH_BREAKS; seed++) {
+
+        // Integer cue velocities, so no float math feeds the inputs
+        unsigned int state = 2654435761u * (unsigned int)(seed + 1);
+        state = state * 1664525u + 1013904223u;
+        Fixed vx = (Fixed)(state >> 8) % (44 * FIXED_ONE) - 22 * FIXED_ONE;
+        state = state * 1664525u + 1013904223u;
+        Fixed vy = (Fixed)(state >> 8) % (44 * FIXED_ONE) - 22 * FIXED_ONE;
+
+        InitGame(&game);
+        StrikeCueBallFixed(&game, vx, vy);
+        int n = 0;
+        do {
+            StepSimulation(&game);
+            n++;
+        } while (game.ballsMoving && n < MAX_SIMULATION_STEPS);
+
+        steps += n;
+        hash = HashFixedState(&game, hash);
+    }
+
+    printf("Fixed-point determinism, %d seeded breaks at %d Hz\n",
+           BENCH_HASH_BREAKS, game.physicsHz);
+    printf("  hash  %016llx\n", (unsigned long long)hash);
+    printf("  steps %ld (%.0f ns/step)\n", steps,
+           (NowSeconds() - start) / steps * 1e9);
+    return 0;
+#else
+    printf("--hash needs a -DSIM_FIXED_POINT build (and pool_fixed.c)\n");
+    return 1;
+#endif
+}
+
+// ---------------------- COMPUTER OPPONENT BENCHMARK ----------------------
+
+// The computer plays both sides. Every shot it chooses is scored by the
+// rules as actually played, next to a random shot from the same position.
+static void BenchAI(void) {
+
+    static Game table, scratch;
+    static ThreadPool pool;
+    static AISearch search;
+    AIConfig config;
+    DefaultAIConfig(&config);
+    config.budget = BENCH_AI_BUDGET;
+
+    if (!CreateThreadPool(&pool, DefaultWorkerCount())) {
+        printf("\nComputer opponent: could not start threads\n");
+        return;
+    }
+
+    InitGame(&table);
+    double aiScore = 0.0, randomScore = 0.0, seconds = 0.0;
+    int aiScratches = 0, randomScratches = 0, evaluated = 0, games = 1;
+
+    for (int k = 0; k < BENCH_AI_SHOTS; k++) {
+        if (table.state == GAME_WON || table.state == GAME_LOST) {
+            InitGame(&table);
+            games++;
+        }
+        int shooter = table.currentPlayer;
+
+        // Random shot from the same spot for comparison
+        scratch = table;
+        if (scratch.state == GAME_SCRATCH)
+            PlaceCueBall(&scratch, scratch.cueBallPos);
+        float angle = RandomRange(0.0f, 6.2831853f);
+        SimulateShot(&scratch, (Vector2){ cosf(angle), sinf(angle) },
+                     RandomRange(2.0f, MAX_SHOT_SPEED));
+        randomScore += ScoreShotResult(&table, &scratch, shooter);
+        randomScratches += scratch.state == GAME_SCRATCH;
+
+        BeginAISearch(&search, &table, &config, 1u + (unsigned int)k);
+        while (!ContinueAISearch(&search, &pool, config.budget)) {}
+        evaluated += search.evaluated;
+        seconds += search.elapsed;
+
+        scratch = table;
+        PlayAIShot(&scratch, &search.best);
+        RunToRest(&scratch, MAX_SIMULATION_STEPS);
+        aiScore += ScoreShotResult(&table, &scratch, shooter);
+        aiScratches += scratch.state == GAME_SCRATCH;
+        table = scratch;
+    }
+    DestroyThreadPool(&pool);
+
+    printf("\nComputer opponent, %d shots over %d games at %.0f ms per shot, "
+           "%d threads\n", BENCH_AI_SHOTS, games, BENCH_AI_BUDGET * 1e3,
+           DefaultWorkerCount());
+    printf("  %.0f candidates/s (%d rollouts each)\n",
+           evaluated / seconds, config.samples);
+    printf("  %-8s %8.2f points per shot, %d scratches\n", "computer",
+           aiScore / BENCH_AI_SHOTS, aiScratches);
+    printf("  %-8s %8.2f points per shot, %d scratches\n", "random",
+           randomScore / BENCH_AI_SHOTS, randomScratches);
+}
+
+// The tree search plays itself, scored the same way as BenchAI, and
+// reports how fast the tree grows and what a node costs
+static void BenchMCTS(void) {
+
+    static Game table;
+    static ThreadPool pool;
+    static MCTSSearch search;
+    MCTSConfig config;
+    DefaultMCTSConfig(&config);
+    config.budget = BENCH_MCTS_BUDGET;
+
+    if (!CreateThreadPool(&pool, DefaultWorkerCount())) {
+        printf("\nTree search: could not start threads\n");
+        return;
+    }
+    if (!CreateMCTSSearch(&search, &config)) {
+        printf("\nTree search: out of memory\n");
+        DestroyThreadPool(&pool);
+        return;
+    }
+
+    InitGame(&table);
+    double score = 0.0, seconds = 0.0;
+    long long nodes = 0, iterations = 0, bytes = 0;
+    int scratches = 0, fullArenas = 0;
+
+    for (int k = 0; k < BENCH_MCTS_SHOTS; k++) {
+        if (table.state == GAME_WON || table.state == GAME_LOST)
+            InitGame(&table);
+        int shooter = table.currentPlayer;
+
+        BeginMCTSSearch(&search, &table, 1u + (unsigned int)k);
+        while (!ContinueMCTSSearch(&search, &pool, config.budget)) {}
+        nodes += atomic_load(&search.nodes);
+        iterations += atomic_load(&search.iterations);
+        bytes += (long long)atomic_load(&search.arena.used);
+        seconds += search.elapsed;
+        fullArenas += atomic_load(&search.full);
+
+        AIShot shot;
+        if (!BestMCTSShot(&search, &shot)) break;
+        Game before = table;
+        PlayAIShot(&table, &shot);
+        RunToRest(&table, MAX_SIMULATION_STEPS);
+        score += ScoreShotResult(&before, &table, shooter);
+        scratches += table.state == GAME_SCRATCH;
+    }
+    FreeMCTSSearch(&search);
+    DestroyThreadPool(&pool);
+
+    printf("\nTree search, %d shots at %.0f ms per shot, %d threads\n",
+           BENCH_MCTS_SHOTS, BENCH_MCTS_BUDGET * 1e3, DefaultWorkerCount());
+    printf("  %.0f nodes/s, %.0f iterations/s\n",
+           nodes / seconds, iterations / seconds);
+    printf("  %.0f arena bytes per node (%zu-byte struct), %.1f MB per "
+           "second of search, %d arenas filled\n", (double)bytes / nodes,
+           sizeof(MCTSNode), bytes / seconds / (1 << 20), fullArenas);
+    printf("  %.2f points per shot, %d scratches\n",
+           score / BENCH_MCTS_SHOTS, scratches);
+}
+
+// A 60 Hz game loop against the threaded computer: player 1 shoots at
+// random, player 2 is the AI thread. The table runs at
+// BENCH_WORKER_SPEED times real time to keep the run short. Reports how
+// long the loop's own work took per frame, frames that overran, and how
+// long the computer kept the table waiting with a pondered search
+// (every other shot) and without one.
+static void BenchAIWorker(void) {
+
+    static AIWorker worker;
+    static Game table;
+    AIConfig config;
+    DefaultAIConfig(&config);
+    config.budget = 0.1f;
+
+    if (!StartAIWorker(&worker, &config, false)) {
+        printf("\nAI thread: could not start\n");
+        return;
+    }
+
+    const double frame = 1.0 / BASE_FRAME_HZ;
+    InitGame(&table);
+    table.players[1].computer = true;
+    bool waiting = false;
+    unsigned int request = 0, fallbackSeed = 1u;
+    int computerShots = 0, pondered = 0, frames = 0, late = 0;
+    double requested = 0.0, waitPondered = 0.0, waitFresh = 0.0, worstWork = 0.0;
+
+    while (computerShots < BENCH_WORKER_SHOTS) {
+        double start = NowSeconds();
+
+        if (table.state == GAME_WON || table.state == GAME_LOST) {
+            InitGame(&table);
+            table.players[1].computer = true;
+            CancelAIShot(&worker);
+            waiting = false;
+        }
+        bool resting = !table.ballsMoving && !AreBallsMoving(&table);
+        if (resting && !table.players[table.currentPlayer].computer) {
+            if (table.state == GAME_SCRATCH)
+                PlaceCueBall(&table, table.cueBallPos);
+            float angle = RandomRange(0.0f, 6.2831853f);
+            StrikeCueBall(&table, (Vector2){ cosf(angle), sinf(angle) },
+                          RandomRange(4.0f, MAX_SHOT_SPEED));
+            if (computerShots % 2 == 0) PonderAIShot(&worker, &table);
+        }
+        else if (resting && !waiting && RequestAIShot(&worker, &table, &request)) {
+            waiting = true;
+            requested = start;
+        }
+
+        AIResult result;
+        while (PollAIResult(&worker, &result)) {
+            if (!waiting || result.id != request) continue;
+            waiting = false;
+            computerShots++;
+            if (result.pondered) {
+                pondered++;
+                waitPondered += start - requested;
+            }
+            else {
+                waitFresh += start - requested;
+            }
+            if (result.failed)
+                SampleAIShot(&table, table.currentPlayer, &fallbackSeed,
+                             &result.shot);
+            PlayAIShot(&table, &result.shot);
+        }
+
+        int steps = table.physicsHz / BASE_FRAME_HZ * BENCH_WORKER_SPEED;
+        for (int k = 0; k < steps; k++)
+            StepSimulation(&table);
+
+        double work = NowSeconds() - start;
+        if (work > worstWork) worstWork = work;
+        if (work < frame) {
+            double rest = frame - work;
+            struct timespec ts = { 0, (long)(rest * 1e9) };
+            nanosleep(&ts, NULL);
+        }
+        if (NowSeconds() - start > frame * 1.25) late++;
+        frames++;
+    }
+    StopAIWorker(&worker);
+
+    int fresh = computerShots - pondered;
+    printf("\nAI thread, %d computer shots at %.0f ms of search, %d frames "
+           "at %d Hz\n", computerShots, config.budget * 1e3, frames,
+           BASE_FRAME_HZ);
+    printf("  worst frame work %.2f ms, %d frames over %.1f ms\n",
+           worstWork * 1e3, late, frame * 1.25e3);
+    printf("  table waited %.1f ms after pondering (%d shots), %.1f ms "
+           "without (%d shots)\n",
+           pondered ? waitPondered / pondered * 1e3 : 0.0, pondered,
+           fresh ? waitFresh / fresh * 1e3 : 0.0, fresh);
+}
+
+// A 60 Hz loop in which every BENCH_STALL_EVERY-th frame takes
+// BENCH_STALL, as a slow draw would. Every fourth of those takes
+// BENCH_LONG_STALL instead, longer than either side makes up, and with
+// threaded set the physics thread stalls for as long, as it would if
+// the machine stopped both. threaded steps the table on the physics
+// thread and reads frames from it, as updated.c does with
+// --physics-thread; otherwise the loop steps it, clamped like
+// UpdateGame's frame time.
+typedef struct {
+    Game table;                   // Where the last shot stopped
+    int frames;
+    double worstUpdate;           // Longest the loop spent on physics
+    int longestBatch;             // Most steps made up back to back
+    long long steps;
+    long long dropped;
+    double seconds;
+} PhysicsLoop;
+
+// Runs on the physics thread, sent by pthread_kill
+static void StallPhysics(int signal) {
+    (void)signal;
+    struct timespec ts = { 0, (long)(BENCH_LONG_STALL * 1e9) };
+    nanosleep(&ts, NULL);
+}
+
+static void RunPhysicsLoop(bool threaded, PhysicsLoop *loop) {
+
+    static PhysicsThread physics;
+    Game *view = &loop->table;
+    const double frame = 1.0 / BASE_FRAME_HZ;
+    InitGame(view);
+    loop->frames = 0;
+    loop->worstUpdate = 0.0;
+    loop->longestBatch = 0;
+    loop->steps = 0;
+    loop->dropped = 0;
+    benchSeed = 2024u;
+
+    if (threaded && !StartPhysicsThread(&physics, view)) {
+        printf("  could not start the physics thread\n");
+        return;
+    }
+    struct sigaction stall = { 0 };
+    stall.sa_handler = StallPhysics;
+    sigaction(SIGUSR1, &stall, NULL);
+
+    int shots = 0;
+    bool tablePending = false, drawn = false;
+    ShotParams shot;
+    double begin = NowSeconds(), accumulator = 0.0, last = begin;
+    for (;;) {
+        double start = NowSeconds();
+
+        // Shots are played on the view and sent on, as PlayShot does. An
+        // input the ring has no room for is not played and is tried again
+        // next frame, and a new table is sent every frame until it goes.
+        if (threaded && tablePending)
+            tablePending = !SendPhysicsTable(&physics, view);
+        if (!view->ballsMoving && !AreBallsMoving(view)) {
+            if (view->state == GAME_WON || view->state == GAME_LOST) {
+                InitGame(view);
+                tablePending = threaded && !SendPhysicsTable(&physics, view);
+            }
+            if (shots == BENCH_LOOP_SHOTS) break;
+            if (!drawn) {
+                float angle = RandomRange(0.0f, 6.2831853f);
+                shot = (ShotParams){ { cosf(angle), sinf(angle) },
+                                     RandomRange(2.0f, 5.0f) };
+                drawn = true;
+            }
+            bool sent = !threaded || !tablePending;
+            if (sent && view->state == GAME_SCRATCH) {
+                sent = !threaded || SendPhysicsPlacement(&physics, view->cueBallPos);
+                if (sent) PlaceCueBall(view, view->cueBallPos);
+            }
+            if (sent && (!threaded || SendPhysicsShot(&physics, shot))) {
+                StrikeCueBall(view, shot.direction, shot.speed);
+                drawn = false;
+                shots++;
+            }
+        }
+
+        if (threaded && !tablePending) {
+            const PhysicsFrame *newest = ReadPhysicsFrame(&physics);
+            if (newest != NULL) *view = newest->table;
+        }
+        else {
+            accumulator += start - last;
+            if (accumulator > PHYSICS_MAX_CATCH_UP) {
+                loop->dropped += (long long)((accumulator - PHYSICS_MAX_CATCH_UP) *
+                                             view->physicsHz);
+                accumulator = PHYSICS_MAX_CATCH_UP;
+            }
+            int batch = 0;
+            while (accumulator >= 1.0 / view->physicsHz) {
+                StepSimulation(view);
+                accumulator -= 1.0 / view->physicsHz;
+                batch++;
+            }
+            loop->steps += batch;
+            if (batch > loop->longestBatch) loop->longestBatch = batch;
+        }
+        last = start;
+
+        double update = NowSeconds() - start;
+        if (update > loop->worstUpdate) loop->worstUpdate = update;
+        int frames = ++loop->frames;
+        double length = frames % BENCH_STALL_EVERY == 0 ? BENCH_STALL : frame;
+        if (frames % (4 * BENCH_STALL_EVERY) == 0) {
+            length = BENCH_LONG_STALL;
+            if (threaded) pthread_kill(physics.thread, SIGUSR1);
+        }
+        double rest = length - (NowSeconds() - start);
+        if (rest > 0.0) {
+            struct timespec ts = { (time_t)rest, (long)((rest - (time_t)rest) * 1e9) };
+            nanosleep(&ts, NULL);
+        }
+    }
+    loop->seconds = NowSeconds() - begin;
+
+    if (threaded) {
+        StopPhysicsThread(&physics);
+        loop->longestBatch = physics.longestBatch;
+        loop->steps = physics.steps;
+        loop->dropped = physics.dropped;
+    }
+}
+
+// The same shots through the stalling loop with and without the
+// physics thread. Both should stop on the same table bit for bit, and
+// drop the same steps after each long stall, give or take a frame.
+static void BenchPhysicsThread(void) {
+
+    static PhysicsLoop serial, threaded;
+    RunPhysicsLoop(false, &serial);
+    RunPhysicsLoop(true, &threaded);
+
+    bool same = true;
+    for (int i = 0; i < serial.table.ballCount; i++) {
+        same = same &&
+            serial.table.balls[i].pocketed == threaded.table.balls[i].pocketed &&
+            memcmp(&serial.table.balls[i].position, &threaded.table.balls[i].position,
+                   sizeof(Vector2)) == 0;
+    }
+
+    printf("\nPhysics thread, %d shots, a %.0f ms frame every %d at %d Hz "
+           "(%.0f ms every %d)\n", BENCH_LOOP_SHOTS, BENCH_STALL * 1e3,
+           BENCH_STALL_EVERY, BASE_FRAME_HZ, BENCH_LONG_STALL * 1e3,
+           4 * BENCH_STALL_EVERY);
+    printf("%10s %8s %12s %14s %10s %10s\n", "physics", "frames",
+           "steps/s", "worst update", "burst", "dropped");
+    const PhysicsLoop *loops[2] = { &serial, &threaded };
+    for (int k = 0; k < 2; k++) {
+        const PhysicsLoop *loop = loops[k];
+        printf("%10s %8d %12.1f %11.3f ms %10d %10lld\n",
+               k ? "thread" : "in loop", loop->frames, loop->steps / loop->seconds,
+               loop->worstUpdate * 1e3, loop->longestBatch, loop->dropped);
+    }
+    long long slack = (long long)(serial.frames / (4 * BENCH_STALL_EVERY)) *
+                      serial.table.physicsHz / BASE_FRAME_HZ;
+    printf("  same final table: %s\n", same ? "yes" : "NO");
+    printf("  same steps dropped: %s\n",
+           llabs(serial.dropped - threaded.dropped) <= slack ? "yes" : "NO");
+}
+
+// ---------------------- SCENARIO SUITE ----------------------
+//
+// Fixed, seeded scenarios whose numbers can be compared across commits.
+// Shots are stepped one UpdatePhysics at a time, without the
+// fast-forward SimulateShot uses, so ns/step is the real step cost.
+
+typedef struct {
+    const char *name;
+    int balls;
+    int shots;
+    long steps;
+    double seconds;
+} Scenario;
+
+// The ResetBalls rack broken at full speed, angles fanned over +-6 degrees
+static void RunBreaks(Scenario *s) {
+
+    static Game rack, table;
+    InitGame(&rack);
+    *s = (Scenario){ "break", rack.ballCount, SUITE_BREAKS, 0, 0.0 };
+
+    for (int k = 0; k < SUITE_BREAKS; k++) {
+        float angle = -0.105f + 0.21f * k / (SUITE_BREAKS - 1);
+        table = rack;
+        double start = NowSeconds();
+        StrikeCueBall(&table, (Vector2){ cosf(angle), sinf(angle) }, MAX_SHOT_SPEED);
+        s->steps += RunToRest(&table, MAX_SIMULATION_STEPS);
+        s->seconds += NowSeconds() - start;
+    }
+}
+
+// Soft shots in random directions into a settled, broken table
+static void RunSafeties(Scenario *s) {
+
+    static Game broken, table;
+    InitGame(&broken);
+    StrikeCueBall(&broken, (Vector2){1, 0}, MAX_SHOT_SPEED);
+    RunToRest(&broken, MAX_SIMULATION_STEPS);
+    broken.state = GAME_PLAYING;
+
+    // A scratch on the break leaves the cue ball to be placed
+    if (broken.balls[0].pocketed) {
+        broken.balls[0].pocketed = false;
+        broken.balls[0].position = broken.cueBallPos;
+        RebuildTableState(&broken);
+    }
+
+    *s = (Scenario){ "safety", broken.ballCount, SUITE_SAFETIES, 0, 0.0 };
+    benchSeed = 777u;
+
+    for (int k = 0; k < SUITE_SAFETIES; k++) {
+        float angle = RandomRange(0.0f, 6.2831853f);
+        float speed = RandomRange(2.0f, 5.0f);
+        table = broken;
+        double start = NowSeconds();
+        StrikeCueBall(&table, (Vector2){ cosf(angle), sinf(angle) }, speed);
+        s->steps += RunToRest(&table, MAX_SIMULATION_STEPS);
+        s->seconds += NowSeconds() - start;
+    }
+}
+
+// Synthetic tables with every ball moving, run until they settle
+static void RunDense(Scenario *s, const char *name, int count) {
+
+    static Game table;
+    *s = (Scenario){ name, count, SUITE_DENSE_RUNS, 0, 0.0 };
+    benchSeed = 4242u + (unsigned int)count;
+
+    for (int run = 0; run < SUITE_DENSE_RUNS; run++) {
+        LayoutRandomTable(&table, count);
+        table.ballsMoving = true;
+        double start = NowSeconds();
+        s->steps += RunToRest(&table, SUITE_DENSE_STEPS);
+        s->seconds += NowSeconds() - start;
+    }
+}
+
+static int RunSuite(bool json) {
+
+    static const struct { const char *name; int balls; } dense[] = {
+        { "dense64", 64 }, { "dense256", 256 }, { "dense1024", 1024 }
+    };
+    Scenario scenarios[5];
+    int count = 0;
+
+    // The scenarios are deterministic, so repeats only differ in time
+    for (int k = 0; k < 5; k++) {
+        int d = k - 2;
+        if (d >= 0 && dense[d].balls > MAX_TABLE_BALLS) {
+            fprintf(stderr, "%s skipped: build with -DMAX_TABLE_BALLS=%d\n",
+                    dense[d].name, dense[d].balls);
+            continue;
+        }
+
+        Scenario best, run;
+        for (int r = 0; r < SUITE_REPEATS; r++) {
+            if (k == 0) RunBreaks(&run);
+            else if (k == 1) RunSafeties(&run);
+            else RunDense(&run, dense[d].name, dense[d].balls);
+            if (r == 0 || run.seconds < best.seconds) best = run;
+        }
+        scenarios[count++] = best;
+    }
+
+    Game defaults;
+    InitGame(&defaults);
+#ifdef PROFILE_ENABLED
+    bool profiled = true;
+#else
+    bool profiled = false;
+#endif
+
+    if (json) {
+        printf("{\n  \"physicsHz\": %d,\n  \"profiler\": %s,\n  \"scenarios\": [\n",
+               defaults.physicsHz, profiled ? "true" : "false");
+        for (int i = 0; i < count; i++) {
+            Scenario *s = &scenarios[i];
+            printf("    {\"name\": \"%s\", \"balls\": %d, \"shots\": %d, "
+                   "\"steps\": %ld, \"nsPerStep\": %.1f, \"stepsPerShot\": %.1f, "
+                   "\"shotsPerSecond\": %.1f}%s\n",
+                   s->name, s->balls, s->shots, s->steps,
+                   s->seconds / s->steps * 1e9, (double)s->steps / s->shots,
+                   s->shots / s->seconds, i + 1 < count ? "," : "");
+        }
+        printf("  ]\n}\n");
+        return 0;
+    }
+
+    printf("\nScenario suite at %d Hz%s\n", defaults.physicsHz,
+           profiled ? " (profiler on; build with -DNDEBUG to compare)" : "");
+    printf("%10s %6s %6s %12s %14s %14s\n", "scenario", "balls", "shots",
+           "ns/step", "steps/shot", "shots/s");
+    for (int i = 0; i < count; i++) {
+        Scenario *s = &scenarios[i];
+        printf("%10s %6d %6d %12.1f %14.1f %14.1f\n", s->name, s->balls, s->shots,
+               s->seconds / s->steps * 1e9, (double)s->steps / s->shots,
+               s->shots / s->seconds);
+    }
+    return 0;
+}
+
+// ---------------------- MAIN ----------------------
+
+int main(int argc, char **argv) {
+
+    if (argc > 1 && strcmp(argv[1], "--hash") == 0)
+        return CheckFixedHash();
+    if (argc > 1 && strcmp(argv[1], "--suite") == 0)
+        return RunSuite(false);
+    if (argc > 1 && strcmp(argv[1], "--json") == 0)
+        return RunSuite(true);
+
+    int sizes[] = { 16, 64, 1024 };
+
+    printf("Collision broadphase, %d steps per table\n", BENCH_FRAMES);
+    printf("%6s %14s %14s %14s %14s\n", "balls",
+           "brute pairs", "grid pairs", "brute ns", "grid ns");
+
+    for (int s = 0; s < 3; s++) {
+        if (sizes[s] > MAX_TABLE_BALLS) {
+            printf("%6d   skipped: build with -DMAX_TABLE_BALLS=%d\n",
+                   sizes[s], sizes[s]);
+            continue;
+        }
+        BenchBroadphase(sizes[s]);
+    }
+
+    BenchBatch();
+    BenchRoll();
+    BenchEvents();
+    BenchAimPreview();
+    BenchTrajectory();
+    BenchSnapshot();
+    BenchZobrist();
+    BenchThreadPool();
+    BenchAI();
+    BenchMCTS();
+    BenchAIWorker();
+    BenchPhysicsThread();
+    return RunSuite(false);
+}
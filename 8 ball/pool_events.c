@@ -0,0 +1,264 @@
+#include "pool_events.h"
+#include <math.h>        // For sqrt, log
+
+// ---------------------- MOTION MODEL ----------------------
+//
+// Stepping multiplies velocity by FRICTION every 60 Hz frame. In the
+// limit of small steps that is v(t) = v0 * e^(-k t) with k = -ln(FRICTION)
+// and t measured in frames, so a ball has moved
+//
+//     p(t) = p0 + v0 * u(t),    u(t) = (1 - e^(-k t)) / k
+//
+// Every ball shares the same k, so u is a common "travel" parameter:
+// between events all relative motion is linear in u, and contact tests
+// become plain quadratics. A ball stops once its speed falls to
+// MIN_VELOCITY, i.e. after u = (1 - MIN_VELOCITY / |v0|) / k.
+
+// Pockets are entered slightly inside the radius so CheckPockets
+// (which uses a strict '<') always sees the ball as pocketed
+#define POCKET_ENTRY_EPSILON 0.01
+
+// Touching balls count as a contact only while they close in faster
+// than this (px per frame). Rounding leaves a resolved pair touching
+// with a closing rate of about zero, which would fire again at once.
+#define CONTACT_CLOSING_SPEED 1e-3
+
+static double FrictionRate(void) {
+    return -log((double)FRICTION);
+}
+
+// Smallest non-negative root of a*u^2 + b*u + c = 0 for a pair that is
+// closing in (b < 0). Returns -1 when they never reach the distance.
+// Already inside it counts only if -b is above minClosing.
+static double FirstContact(double a, double b, double c, double minClosing) {
+
+    if (a < 1e-12 || b >= 0.0) return -1.0;
+
+    // Already touching and still closing in
+    if (c <= 0.0) return -b > minClosing ? 0.0 : -1.0;
+
+    double disc = b*b - 4.0*a*c;
+    if (disc < 0.0) return -1.0;
+    return (-b - sqrt(disc)) / (2.0*a);
+}
+
+// ---------------------- EVENT SEARCH ----------------------
+
+// Keeps the earliest candidate seen so far
+static void ConsiderEvent(ShotEvent *best, ShotEventType type,
+                          double travel, int ball, int other) {
+    if (travel < 0.0) return;
+    if (best->type == EVENT_NONE || travel < best->travel) {
+        best->type = type;
+        best->travel = travel;
+        best->ball = ball;
+        best->other = other;
+    }
+}
+
+ShotEvent FindNextEvent(const Game *game) {
+
+    Vector2 pockets[] = {
+        {RAIL_WIDTH, RAIL_WIDTH},
+        {TABLE_WIDTH*0.5f, RAIL_WIDTH},
+        {TABLE_WIDTH - RAIL_WIDTH, RAIL_WIDTH},
+        {RAIL_WIDTH, TABLE_HEIGHT - RAIL_WIDTH},
+        {TABLE_WIDTH*0.5f, TABLE_HEIGHT - RAIL_WIDTH},
+        {TABLE_WIDTH - RAIL_WIDTH, TABLE_HEIGHT - RAIL_WIDTH}
+    };
+    double k = FrictionRate();
+    double minX = RAIL_WIDTH + BALL_RADIUS;
+    double maxX = TABLE_WIDTH - RAIL_WIDTH - BALL_RADIUS;
+    double minY = RAIL_WIDTH + BALL_RADIUS;
+    double maxY = TABLE_HEIGHT - RAIL_WIDTH - BALL_RADIUS;
+    double pocketRadius = POCKET_RADIUS - POCKET_ENTRY_EPSILON;
+    double contactDist = BALL_RADIUS * 2.0;
+    double minClosing = 2.0 * contactDist * CONTACT_CLOSING_SPEED;  // b = 2 d.w
+
+    ShotEvent best = { EVENT_NONE, 0.0, -1, -1 };
+
+    // Only awake balls can start an event
+    for (int n = 0; n < game->awakeCount; n++) {
+        int i = game->awakeList[n];
+        const Ball *ball = &game->balls[i];
+        if (ball->pocketed) continue;
+
+        double px = ball->position.x, py = ball->position.y;
+        double vx = ball->velocity.x, vy = ball->velocity.y;
+        double speed = sqrt(vx*vx + vy*vy);
+
+        // Stop (immediately for a ball woken with no speed)
+        double stop = speed > 0.0 ? (1.0 - MIN_VELOCITY / speed) / k : 0.0;
+        ConsiderEvent(&best, EVENT_BALL_STOP, stop > 0.0 ? stop : 0.0, i, -1);
+
+        // Rails (only the ones the ball is heading towards)
+        if (vx < 0.0) ConsiderEvent(&best, EVENT_RAIL_X, px > minX ? (minX - px) / vx : 0.0, i, -1);
+        if (vx > 0.0) ConsiderEvent(&best, EVENT_RAIL_X, px < maxX ? (maxX - px) / vx : 0.0, i, -1);
+        if (vy < 0.0) ConsiderEvent(&best, EVENT_RAIL_Y, py > minY ? (minY - py) / vy : 0.0, i, -1);
+        if (vy > 0.0) ConsiderEvent(&best, EVENT_RAIL_Y, py < maxY ? (maxY - py) / vy : 0.0, i, -1);
+
+        // Pockets
+        for (int p = 0; p < 6; p++) {
+            double dx = px - pockets[p].x;
+            double dy = py - pockets[p].y;
+            double a = vx*vx + vy*vy;
+            double b = 2.0 * (dx*vx + dy*vy);
+            double c = dx*dx + dy*dy - pocketRadius*pocketRadius;
+            ConsiderEvent(&best, EVENT_POCKET, FirstContact(a, b, c, 0.0), i, -1);
+        }
+
+        // Other balls. Pairs of two awake balls are tested once (j > i);
+        // a sleeping ball only gets tested from the awake side.
+        for (int j = 0; j < game->ballCount; j++) {
+            const Ball *other = &game->balls[j];
+            if (j == i || other->pocketed) continue;
+            if (game->awakeSlot[j] >= 0 && j < i) continue;
+
+            double dx = other->position.x - px;
+            double dy = other->position.y - py;
+            double wx = other->velocity.x - vx;
+            double wy = other->velocity.y - vy;
+            double a = wx*wx + wy*wy;
+            double b = 2.0 * (dx*wx + dy*wy);
+            double c = dx*dx + dy*dy - contactDist*contactDist;
+            ConsiderEvent(&best, EVENT_BALL_BALL, FirstContact(a, b, c, minClosing),
+                          i, j);
+        }
+    }
+    return best;
+}
+
+// ---------------------- ADVANCING ----------------------
+
+// The solver moves the float view; fixed-point builds keep the integer
+// state in step so CheckPockets and the end-of-shot rules see the balls
+// where they are
+static void LoadFixed(Game *game, int ball) {
+#ifdef SIM_FIXED_POINT
+    LoadFixedBall(game, ball);
+#else
+    (void)game;
+    (void)ball;
+#endif
+}
+
+// Pushes a resolved pair apart to exactly touching, half each, so
+// rounding cannot leave them overlapping
+static void SeparatePair(Ball *a, Ball *b) {
+
+    double dx = b->position.x - a->position.x;
+    double dy = b->position.y - a->position.y;
+    double dist = sqrt(dx*dx + dy*dy);
+    double overlap = BALL_RADIUS * 2.0 - dist;
+    if (overlap <= 0.0 || dist <= 1e-4) return;
+
+    double push = overlap * 0.5 / dist;
+    a->position.x -= (float)(dx * push);
+    a->position.y -= (float)(dy * push);
+    b->position.x += (float)(dx * push);
+    b->position.y += (float)(dy * push);
+}
+
+// Moves every ball along its decaying path by the travel parameter
+void AdvanceBalls(Game *game, double travel) {
+
+    if (travel <= 0.0) return;
+    double decay = 1.0 - FrictionRate() * travel;
+
+    for (int n = 0; n < game->awakeCount; n++) {
+        Ball *ball = &game->balls[game->awakeList[n]];
+        ball->position.x += (float)(ball->velocity.x * travel);
+        ball->position.y += (float)(ball->velocity.y * travel);
+        ball->velocity.x = (float)(ball->velocity.x * decay);
+        ball->velocity.y = (float)(ball->velocity.y * decay);
+        LoadFixed(game, game->awakeList[n]);
+    }
+}
+
+static void ApplyEvent(Game *game, const ShotEvent *event) {
+
+    Ball *ball = &game->balls[event->ball];
+
+    switch (event->type) {
+    case EVENT_BALL_STOP:
+        ball->velocity = (Vector2){0, 0};
+        LoadFixed(game, event->ball);
+        SleepBall(game, event->ball);
+        break;
+
+    case EVENT_RAIL_X:
+        ball->position.x = ball->velocity.x < 0.0f ?
+            RAIL_WIDTH + BALL_RADIUS :
+            TABLE_WIDTH - RAIL_WIDTH - BALL_RADIUS;
+        ball->velocity.x *= -0.86f;
+        LoadFixed(game, event->ball);
+        break;
+
+    case EVENT_RAIL_Y:
+        ball->position.y = ball->velocity.y < 0.0f ?
+            RAIL_WIDTH + BALL_RADIUS :
+            TABLE_HEIGHT - RAIL_WIDTH - BALL_RADIUS;
+        ball->velocity.y *= -0.86f;
+        LoadFixed(game, event->ball);
+        break;
+
+    case EVENT_POCKET:
+        // Shared rules decide what a pocketed ball means
+        CheckPockets(game);
+        if (ball->pocketed)
+            SleepBall(game, event->ball);
+        break;
+
+    case EVENT_BALL_BALL:
+        ResolveElasticCollision(ball, &game->balls[event->other]);
+        ClampBallSpeed(ball, MAX_BALL_SPEED);
+        ClampBallSpeed(&game->balls[event->other], MAX_BALL_SPEED);
+        SeparatePair(ball, &game->balls[event->other]);
+        LoadFixed(game, event->ball);
+        LoadFixed(game, event->other);
+        WakeBall(game, event->other);
+        break;
+
+    case EVENT_NONE:
+        break;
+    }
+}
+
+// ---------------------- SHOT ENTRY POINT ----------------------
+
+// Event-driven counterpart of SimulateShot: strikes the cue ball and
+// jumps from event to event until the table is at rest. Returns the
+// number of events processed, or -1 if MAX_SHOT_EVENTS ran out first;
+// the table is then left mid-shot, with no end-of-shot rules applied.
+int SimulateShotEvents(Game *game, Vector2 direction, float speed) {
+
+    StrikeCueBall(game, direction, speed);
+    game->ballsMoving = AreBallsMoving(game);
+
+    int events = 0;
+    while (events < MAX_SHOT_EVENTS &&
+           (game->state == GAME_PLAYING ||
+            game->state == GAME_SCRATCH)) {
+
+        ShotEvent next = FindNextEvent(game);
+        if (next.type == EVENT_NONE) break;
+
+        AdvanceBalls(game, next.travel);
+        ApplyEvent(game, &next);
+        events++;
+    }
+
+    // Balls jumped without going through the grid
+    RebuildTableState(game);
+    for (int i = 0; i < game->ballCount; i++)
+        game->previousPositions[i] = game->balls[i].position;
+    if (events == MAX_SHOT_EVENTS) return -1;
+
+    // Same end-of-shot rules as the stepped engine; a won or lost game
+    // freezes the table just like StepSimulation does
+    if (game->ballsMoving &&
+        (game->state == GAME_PLAYING || game->state == GAME_SCRATCH))
+        FinishShot(game);
+
+    return events;
+}
@@ -0,0 +1,35 @@
+#ifndef POOL_EVENTS_H
+#define POOL_EVENTS_H
+
+// Event-driven (time-of-impact) shot solver. Instead of stepping the
+// table at a fixed rate it computes, for the friction model, when the
+// next ball-ball contact, rail hit, pocket entry or stop happens and
+// jumps straight there.
+
+#include "pool_sim.h"
+
+#define MAX_SHOT_EVENTS 20000     // Safety cap for SimulateShotEvents
+
+// Kinds of event the solver can jump to
+typedef enum {
+    EVENT_NONE,
+    EVENT_BALL_STOP,     // Ball slows below MIN_VELOCITY
+    EVENT_RAIL_X,        // Ball reaches a left/right rail
+    EVENT_RAIL_Y,        // Ball reaches a top/bottom rail
+    EVENT_POCKET,        // Ball centre enters a pocket
+    EVENT_BALL_BALL      // Two balls touch
+} ShotEventType;
+
+// Next event found by the solver
+typedef struct {
+    ShotEventType type;
+    double travel;       // Distance parameter until the event (see pool_events.c)
+    int ball;            // Ball involved
+    int other;           // Second ball for EVENT_BALL_BALL
+} ShotEvent;
+
+int SimulateShotEvents(Game *game, Vector2 direction, float speed);
+ShotEvent FindNextEvent(const Game *game);
+void AdvanceBalls(Game *game, double travel);
+
+#endif // POOL_EVENTS_H
@@ -0,0 +1,294 @@
+// Fixed-point backend for the stepped physics, built with
+// -DSIM_FIXED_POINT (link this file only in that mode).
+//
+// Positions and velocities are Q16.16 integers. Per-step constants are
+// derived with integer arithmetic only (no powf, no libm), products are
+// rounded symmetrically so a mirrored shot stays mirrored, and square
+// roots are exact integer floors. Floats appear only at the edges:
+// FixedFromFloat for inputs (a placed cue ball, a float shot) and
+// FixedToFloat for the Ball view used by rules and drawing. Both are
+// exact scalings by 2^16 plus one IEEE rounding, which every x86-64
+// build performs the same way.
+
+#include "pool_sim.h"
+#include <math.h>        // For lrintf
+
+#ifndef SIM_FIXED_POINT
+#error "pool_fixed.c is only used in -DSIM_FIXED_POINT builds"
+#endif
+
+// Rail bounce and friction as Q0.32 fractions
+#define RAIL_BOUNCE_Q32 ((uint32_t)(0.86 * 4294967296.0))
+#define FRICTION_Q32 ((uint64_t)((double)FRICTION * 4294967296.0))
+
+#define FIXED_MIN_VELOCITY FIXED_FROM_CONST(MIN_VELOCITY)
+#define FIXED_MAX_BALL_SPEED (MAX_BALL_SPEED * FIXED_ONE)
+#define FIXED_MAX_SHOT_SPEED (MAX_SHOT_SPEED * FIXED_ONE)
+#define FIXED_RADIUS (BALL_RADIUS * FIXED_ONE)
+#define FIXED_MIN_X ((RAIL_WIDTH + BALL_RADIUS) * FIXED_ONE)
+#define FIXED_MAX_X ((TABLE_WIDTH - RAIL_WIDTH - BALL_RADIUS) * FIXED_ONE)
+#define FIXED_MIN_Y ((RAIL_WIDTH + BALL_RADIUS) * FIXED_ONE)
+#define FIXED_MAX_Y ((TABLE_HEIGHT - RAIL_WIDTH - BALL_RADIUS) * FIXED_ONE)
+
+// ---------------------- ARITHMETIC ----------------------
+
+float FixedToFloat(Fixed v) {
+    return (float)v * (1.0f / FIXED_ONE);
+}
+
+Fixed FixedFromFloat(float v) {
+    return (Fixed)lrintf(v * (float)FIXED_ONE);
+}
+
+// a / b rounded to nearest, halves away from zero (b > 0)
+static int64_t RoundDiv(int64_t a, int64_t b) {
+    return a >= 0 ? (a + b / 2) / b : -((-a + b / 2) / b);
+}
+
+// a >> shift rounded to nearest, halves away from zero
+static int64_t RoundShift(int64_t a, int shift) {
+    int64_t half = (int64_t)1 << (shift - 1);
+    return a >= 0 ? (a + half) >> shift : -((-a + half) >> shift);
+}
+
+static Fixed MulFixed(Fixed a, Fixed b) {
+    return (Fixed)RoundShift((int64_t)a * b, 16);
+}
+
+// v * f for a Q0.32 fraction f
+static Fixed ScaleFixed(Fixed v, uint32_t f) {
+    return (Fixed)RoundShift((int64_t)v * f, 32);
+}
+
+// Floor of the square root
+static uint32_t ISqrt64(uint64_t v) {
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > v) bit >>= 2;
+    while (bit != 0) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+// f^k in Q0.32, with 1.0 represented as 2^32
+static uint64_t PowQ32(uint64_t f, int k) {
+    uint64_t result = (uint64_t)1 << 32;
+    for (int i = 0; i < k; i++)
+        result = (result * f + ((uint64_t)1 << 31)) >> 32;
+    return result;
+}
+
+// Scales a velocity down to MAX_BALL_SPEED if it is faster
+static void ClampFixedSpeed(Fixed *vx, Fixed *vy, Fixed maxSpeed) {
+    uint64_t magSq = (uint64_t)((int64_t)*vx * *vx + (int64_t)*vy * *vy);
+    if (magSq <= (uint64_t)((int64_t)maxSpeed * maxSpeed)) return;
+
+    int64_t mag = ISqrt64(magSq);
+    *vx = (Fixed)RoundDiv((int64_t)*vx * maxSpeed, mag);
+    *vy = (Fixed)RoundDiv((int64_t)*vy * maxSpeed, mag);
+}
+
+// ---------------------- STATE ----------------------
+
+// Derives the per-step friction from physicsHz (a multiple of
+// BASE_FRAME_HZ): the largest Q0.32 f with f^stepsPerFrame <= FRICTION,
+// found by bisection instead of powf
+void SetFixedStepRate(Game *game) {
+
+    int k = game->physicsHz / BASE_FRAME_HZ;
+    uint64_t lo = FRICTION_Q32;
+    uint64_t hi = 0xffffffffu;
+
+    while (lo < hi) {
+        uint64_t mid = (lo + hi + 1) / 2;
+        if (PowQ32(mid, k) <= FRICTION_Q32) lo = mid;
+        else hi = mid - 1;
+    }
+    game->fixed.stepsPerFrame = k;
+    game->fixed.stepFriction = (uint32_t)lo;
+}
+
+// Takes a ball's position and velocity from its float view (after a
+// reset or a direct edit)
+void LoadFixedBall(Game *game, int ball) {
+    game->fixed.x[ball] = FixedFromFloat(game->balls[ball].position.x);
+    game->fixed.y[ball] = FixedFromFloat(game->balls[ball].position.y);
+    LoadFixedVelocity(game, ball);
+}
+
+void LoadFixedVelocity(Game *game, int ball) {
+    game->fixed.vx[ball] = FixedFromFloat(game->balls[ball].velocity.x);
+    game->fixed.vy[ball] = FixedFromFloat(game->balls[ball].velocity.y);
+}
+
+// Refreshes the float view of a ball from the integer state
+void SyncBallView(Game *game, int ball) {
+    game->balls[ball].position.x = FixedToFloat(game->fixed.x[ball]);
+    game->balls[ball].position.y = FixedToFloat(game->fixed.y[ball]);
+    game->balls[ball].velocity.x = FixedToFloat(game->fixed.vx[ball]);
+    game->balls[ball].velocity.y = FixedToFloat(game->fixed.vy[ball]);
+}
+
+// Launches the cue ball with an integer velocity, clamped to
+// MAX_SHOT_SPEED like StrikeCueBall
+void StrikeCueBallFixed(Game *game, Fixed vx, Fixed vy) {
+
+    ClampFixedSpeed(&vx, &vy, FIXED_MAX_SHOT_SPEED);
+    game->fixed.vx[0] = vx;
+    game->fixed.vy[0] = vy;
+    SyncBallView(game, 0);
+    WakeBall(game, 0);
+    game->state = GAME_PLAYING;
+    game->firstShot = false;
+}
+
+// ---------------------- PHYSICS ----------------------
+
+// Integer counterpart of the IntegrateLanes kernel, for awake balls
+void IntegrateFixed(Game *game) {
+
+    FixedState *s = &game->fixed;
+    int k = s->stepsPerFrame;
+
+    for (int n = 0; n < game->awakeCount; n++) {
+        int i = game->awakeList[n];
+
+        // Update position
+        s->x[i] += (Fixed)RoundDiv(s->vx[i], k);
+        s->y[i] += (Fixed)RoundDiv(s->vy[i], k);
+
+        // Apply friction
+        s->vx[i] = ScaleFixed(s->vx[i], s->stepFriction);
+        s->vy[i] = ScaleFixed(s->vy[i], s->stepFriction);
+
+        // Stop tiny velocities
+        if (s->vx[i] > -FIXED_MIN_VELOCITY && s->vx[i] < FIXED_MIN_VELOCITY) s->vx[i] = 0;
+        if (s->vy[i] > -FIXED_MIN_VELOCITY && s->vy[i] < FIXED_MIN_VELOCITY) s->vy[i] = 0;
+
+        // Rail collision (bounce effect)
+        if (s->x[i] < FIXED_MIN_X) {
+            s->x[i] = FIXED_MIN_X;
+            s->vx[i] = -ScaleFixed(s->vx[i], RAIL_BOUNCE_Q32);
+        }
+        if (s->x[i] > FIXED_MAX_X) {
+            s->x[i] = FIXED_MAX_X;
+            s->vx[i] = -ScaleFixed(s->vx[i], RAIL_BOUNCE_Q32);
+        }
+        if (s->y[i] < FIXED_MIN_Y) {
+            s->y[i] = FIXED_MIN_Y;
+            s->vy[i] = -ScaleFixed(s->vy[i], RAIL_BOUNCE_Q32);
+        }
+        if (s->y[i] > FIXED_MAX_Y) {
+            s->y[i] = FIXED_MAX_Y;
+            s->vy[i] = -ScaleFixed(s->vy[i], RAIL_BOUNCE_Q32);
+        }
+
+        // Limit maximum speed
+        ClampFixedSpeed(&s->vx[i], &s->vy[i], FIXED_MAX_BALL_SPEED);
+
+        SyncBallView(game, i);
+    }
+}
+
+// Integer counterpart of ResolveBallPair: push apart, exchange the
+// normal velocity components, clamp. The same exchange is added to one
+// ball and taken from the other, so momentum is conserved exactly.
+bool ResolveBallPairFixed(Game *game, int i, int j) {
+
+    FixedState *s = &game->fixed;
+    const Fixed minDist = 2 * FIXED_RADIUS;
+
+    int64_t dx = s->x[j] - s->x[i];
+    int64_t dy = s->y[j] - s->y[i];
+    int64_t distSq = dx*dx + dy*dy;
+
+    game->stats.pairTests++;
+
+    if (distSq >= (int64_t)minDist * minDist || distSq == 0)
+        return false;
+
+    Fixed dist = (Fixed)ISqrt64((uint64_t)distSq);
+    if (dist == 0) return false;
+
+    // Normal direction between balls
+    Fixed nx = (Fixed)RoundDiv(dx * FIXED_ONE, dist);
+    Fixed ny = (Fixed)RoundDiv(dy * FIXED_ONE, dist);
+
+    // Push balls apart equally
+    Fixed overlap = (minDist - dist + FIXED_FROM_CONST(0.001)) / 2;
+    Fixed pushX = MulFixed(nx, overlap);
+    Fixed pushY = MulFixed(ny, overlap);
+    s->x[i] -= pushX;
+    s->y[i] -= pushY;
+    s->x[j] += pushX;
+    s->y[j] += pushY;
+
+    // Equal mass elastic collision: swap the normal components
+    int64_t vnI = (int64_t)s->vx[i] * nx + (int64_t)s->vy[i] * ny;
+    int64_t vnJ = (int64_t)s->vx[j] * nx + (int64_t)s->vy[j] * ny;
+    Fixed exchange = (Fixed)RoundShift(vnJ - vnI, 16);
+    Fixed exchangeX = MulFixed(exchange, nx);
+    Fixed exchangeY = MulFixed(exchange, ny);
+    s->vx[i] += exchangeX;
+    s->vy[i] += exchangeY;
+    s->vx[j] -= exchangeX;
+    s->vy[j] -= exchangeY;
+
+    // Clamp speeds to avoid unrealistic speed
+    ClampFixedSpeed(&s->vx[i], &s->vy[i], FIXED_MAX_BALL_SPEED);
+    ClampFixedSpeed(&s->vx[j], &s->vy[j], FIXED_MAX_BALL_SPEED);
+
+    SyncBallView(game, i);
+    SyncBallView(game, j);
+    WakeBall(game, i);
+    WakeBall(game, j);
+
+    game->stats.collisionsResolved++;
+    return true;
+}
+
+// Ball centre strictly inside the pocket radius. Pocket centres are
+// whole pixels, so the float constants convert exactly.
+bool BallInPocketFixed(const Game *game, int ball, Vector2 pocket) {
+    int64_t dx = game->fixed.x[ball] - (int64_t)pocket.x * FIXED_ONE;
+    int64_t dy = game->fixed.y[ball] - (int64_t)pocket.y * FIXED_ONE;
+    int64_t radius = (int64_t)POCKET_RADIUS * FIXED_ONE;
+    return dx*dx + dy*dy < radius * radius;
+}
+
+// ---------------------- HASHING ----------------------
+
+// FNV-1a over the integer state, byte by byte so the result does not
+// depend on the host's endianness
+static uint64_t HashWord(uint64_t hash, uint32_t word) {
+    for (int b = 0; b < 4; b++) {
+        hash ^= (word >> (8 * b)) & 0xffu;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Folds the table (integer state, pocketed flags, turn and game state)
+// into a running hash. Start with 14695981039346656037 (FNV offset).
+uint64_t HashFixedState(const Game *game, uint64_t hash) {
+
+    for (int i = 0; i < game->ballCount; i++) {
+        hash = HashWord(hash, (uint32_t)game->fixed.x[i]);
+        hash = HashWord(hash, (uint32_t)game->fixed.y[i]);
+        hash = HashWord(hash, (uint32_t)game->fixed.vx[i]);
+        hash = HashWord(hash, (uint32_t)game->fixed.vy[i]);
+        hash = HashWord(hash, game->balls[i].pocketed);
+    }
+    hash = HashWord(hash, (uint32_t)game->currentPlayer);
+    hash = HashWord(hash, (uint32_t)game->state);
+    return hash;
+}
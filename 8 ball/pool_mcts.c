@@ -0,0 +1,338 @@
+#define _POSIX_C_SOURCE 200809L   // For clock_gettime
+
+#include "pool_mcts.h"
+#include <math.h>        // For sqrtf, logf, tanhf
+#include <stdlib.h>      // For aligned_alloc, free
+#include <time.h>        // For clock_gettime
+
+#define NODE_ALIGN 64             // Nodes never share a cache line
+#define MCTS_MAX_DEPTH 64         // Longest path one iteration walks
+#define MCTS_SCORE_SCALE 20.0f    // Path score that maps to about 0.88
+
+#define TABLE_FIRST_SHOT 1
+#define TABLE_ASSIGNED 2
+
+static double NowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// ---------------------- ARENA ----------------------
+
+bool CreateNodeArena(NodeArena *arena, size_t bytes) {
+
+    bytes = (bytes + NODE_ALIGN - 1) / NODE_ALIGN * NODE_ALIGN;
+    if (bytes == 0) return false;
+    arena->base = aligned_alloc(NODE_ALIGN, bytes);
+    if (arena->base == NULL) return false;
+    arena->size = bytes;
+    atomic_init(&arena->used, 0);
+    return true;
+}
+
+void FreeNodeArena(NodeArena *arena) {
+    free(arena->base);
+    arena->base = NULL;
+}
+
+// Drops everything allocated so far. Not safe while a search runs.
+void ResetNodeArena(NodeArena *arena) {
+    atomic_store_explicit(&arena->used, 0, memory_order_relaxed);
+}
+
+// Carves bytes (rounded up to NODE_ALIGN) off the arena; safe from any
+// number of threads at once. Returns NULL once the arena is full.
+void *ArenaAlloc(NodeArena *arena, size_t bytes) {
+
+    bytes = (bytes + NODE_ALIGN - 1) / NODE_ALIGN * NODE_ALIGN;
+    size_t offset = atomic_fetch_add_explicit(&arena->used, bytes,
+                                              memory_order_relaxed);
+    if (offset + bytes > arena->size) return NULL;
+    return arena->base + offset;
+}
+
+// ---------------------- COMPACT TABLES ----------------------
+
+static void PackTable(const Game *game, CompactTable *table) {
+
+    table->pocketed = 0;
+    for (int i = 0; i < game->ballCount; i++) {
+        table->position[i] = game->balls[i].position;
+        if (game->balls[i].pocketed) table->pocketed |= (uint16_t)(1u << i);
+    }
+    table->cueBallPos = game->cueBallPos;
+    table->player = (uint8_t)game->currentPlayer;
+    table->state = (uint8_t)game->state;
+    for (int p = 0; p < 2; p++) {
+        table->types[p] = (uint8_t)game->players[p].type;
+        table->remaining[p] = (uint8_t)game->players[p].ballsRemaining;
+    }
+    table->flags = (game->firstShot ? TABLE_FIRST_SHOT : 0) |
+                   (game->assignedTypes ? TABLE_ASSIGNED : 0);
+}
+
+// Lays a compact table over a copy of the root, whose names, physics
+// rate and ball numbering are the same for every node
+static void UnpackTable(const CompactTable *table, Game *game) {
+
+    for (int i = 0; i < game->ballCount; i++) {
+        game->balls[i].position = table->position[i];
+        game->balls[i].velocity = (Vector2){ 0, 0 };
+        game->balls[i].pocketed = (table->pocketed >> i) & 1;
+    }
+    game->cueBallPos = table->cueBallPos;
+    game->currentPlayer = table->player;
+    game->state = (GameState)table->state;
+    for (int p = 0; p < 2; p++) {
+        game->players[p].type = (PlayerType)table->types[p];
+        game->players[p].ballsRemaining = table->remaining[p];
+    }
+    game->firstShot = (table->flags & TABLE_FIRST_SHOT) != 0;
+    game->assignedTypes = (table->flags & TABLE_ASSIGNED) != 0;
+    game->ballsMoving = false;
+    RebuildTableState(game);
+}
+
+static bool IsTerminal(const CompactTable *table) {
+    return table->state == GAME_WON || table->state == GAME_LOST;
+}
+
+// ---------------------- TREE ----------------------
+
+static MCTSNode *NewNode(MCTSSearch *search, MCTSNode *parent) {
+
+    MCTSNode *node = ArenaAlloc(&search->arena, sizeof *node);
+    if (node == NULL) {
+        atomic_store_explicit(&search->full, true, memory_order_relaxed);
+        return NULL;
+    }
+    node->parent = parent;
+    node->shotScore = 0.0f;
+    atomic_init(&node->visits, 0);
+    atomic_init(&node->virtualLoss, 0);
+    atomic_init(&node->value, 0);
+    atomic_init(&node->claimed, 0);
+    for (int k = 0; k < MCTS_BRANCHING; k++)
+        atomic_init(&node->children[k], NULL);
+    atomic_fetch_add_explicit(&search->nodes, 1, memory_order_relaxed);
+    return node;
+}
+
+// Plays one sampled shot from node; the table is left on the result
+static MCTSNode *Expand(MCTSSearch *search, MCTSNode *node, Game *table,
+                        Game *before, unsigned int *rng) {
+
+    MCTSNode *child = NewNode(search, node);
+    if (child == NULL) return NULL;
+
+    UnpackTable(&node->table, table);
+    int shooter = table->currentPlayer;
+    SampleAIShot(table, shooter, rng, &child->shot);
+    *before = *table;
+    if (child->shot.placed) PlaceCueBall(table, child->shot.placement);
+    SimulateShot(table, child->shot.shot.direction, child->shot.shot.speed);
+
+    child->shotScore = ScoreShotResult(before, table, shooter);
+    PackTable(table, &child->table);
+    return child;
+}
+
+// UCT over the children built so far. A child's virtual losses count as
+// visits that the chooser lost.
+static MCTSNode *SelectChild(const MCTSSearch *search, MCTSNode *node) {
+
+    bool forRoot = node->table.player == search->root.currentPlayer;
+    float parentVisits = (float)atomic_load_explicit(&node->visits, memory_order_relaxed) +
+                         atomic_load_explicit(&node->virtualLoss, memory_order_relaxed);
+    float logVisits = logf(parentVisits + 1.0f);
+    MCTSNode *best = NULL;
+    float bestScore = -1.0f;
+
+    for (int k = 0; k < MCTS_BRANCHING; k++) {
+        MCTSNode *child = atomic_load_explicit(&node->children[k], memory_order_acquire);
+        if (child == NULL) continue;
+
+        int visits = atomic_load_explicit(&child->visits, memory_order_relaxed);
+        int pending = atomic_load_explicit(&child->virtualLoss, memory_order_relaxed);
+        float wins = (float)atomic_load_explicit(&child->value, memory_order_relaxed) /
+                     MCTS_VALUE_ONE;
+        if (!forRoot) wins = visits - wins;
+        float n = (float)(visits + pending);
+        float score = n > 0 ? wins / n + search->config.exploration *
+                                         sqrtf(logVisits / n)
+                            : 1e9f;
+        if (score > bestScore) {
+            bestScore = score;
+            best = child;
+        }
+    }
+    return best;
+}
+
+// Random shots on from a new leaf. Returns their score, root player's side.
+static float Playout(const MCTSSearch *search, Game *table, Game *before,
+                     unsigned int *rng) {
+
+    float total = 0.0f;
+    for (int s = 0; s < MCTS_PLAYOUT_SHOTS; s++) {
+        if (table->state == GAME_WON || table->state == GAME_LOST) break;
+        int shooter = table->currentPlayer;
+        AIShot shot;
+        SampleAIShot(table, shooter, rng, &shot);
+        *before = *table;
+        if (shot.placed) PlaceCueBall(table, shot.placement);
+        SimulateShot(table, shot.shot.direction, shot.shot.speed);
+        float score = ScoreShotResult(before, table, shooter);
+        total += shooter == search->root.currentPlayer ? score : -score;
+    }
+    return total;
+}
+
+// Select down the tree, expand one child, play out, back up
+static void RunIteration(MCTSSearch *search, Game *table, Game *before,
+                         unsigned int *rng) {
+
+    MCTSNode *path[MCTS_MAX_DEPTH];
+    int depth = 0;
+    int rootPlayer = search->root.currentPlayer;
+    float total = 0.0f;
+    bool played = false;          // table holds the last node's position
+    MCTSNode *node = search->rootNode;
+
+    for (;;) {
+        path[depth++] = node;
+        atomic_fetch_add_explicit(&node->virtualLoss, 1, memory_order_relaxed);
+        if (node->parent != NULL) {
+            total += node->parent->table.player == rootPlayer ? node->shotScore
+                                                              : -node->shotScore;
+        }
+        if (played || IsTerminal(&node->table) || depth == MCTS_MAX_DEPTH) break;
+
+        // Claim the next unbuilt child, if any are left
+        if (atomic_load_explicit(&node->claimed, memory_order_relaxed) < MCTS_BRANCHING) {
+            int k = atomic_fetch_add_explicit(&node->claimed, 1, memory_order_relaxed);
+            if (k < MCTS_BRANCHING) {
+                MCTSNode *child = Expand(search, node, table, before, rng);
+                if (child == NULL) break;
+                atomic_store_explicit(&node->children[k], child, memory_order_release);
+                node = child;
+                played = true;
+                continue;
+            }
+        }
+
+        // All claimed; others may still be building theirs
+        MCTSNode *next = SelectChild(search, node);
+        if (next == NULL) break;
+        node = next;
+    }
+
+    if (!IsTerminal(&node->table)) {
+        if (!played) UnpackTable(&node->table, table);
+        total += Playout(search, table, before, rng);
+    }
+
+    float result = 0.5f + 0.5f * tanhf(total / MCTS_SCORE_SCALE);
+    long long value = (long long)(result * MCTS_VALUE_ONE);
+    for (int d = 0; d < depth; d++) {
+        atomic_fetch_add_explicit(&path[d]->visits, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&path[d]->value, value, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&path[d]->virtualLoss, 1, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&search->iterations, 1, memory_order_relaxed);
+}
+
+// ---------------------- SEARCH ----------------------
+
+void DefaultMCTSConfig(MCTSConfig *config) {
+    config->budget = 0.5f;
+    config->arenaBytes = 64u << 20;
+    config->exploration = 0.7f;
+}
+
+bool CreateMCTSSearch(MCTSSearch *search, const MCTSConfig *config) {
+    search->config = *config;
+    search->rootNode = NULL;
+    search->done = true;
+    return CreateNodeArena(&search->arena, config->arenaBytes);
+}
+
+void FreeMCTSSearch(MCTSSearch *search) {
+    FreeNodeArena(&search->arena);
+}
+
+// Starts a decision from a table at rest, dropping the previous tree.
+// Returns false if the table has more than MAX_BALLS balls.
+bool BeginMCTSSearch(MCTSSearch *search, const Game *game, unsigned int seed) {
+
+    if (game->ballCount > MAX_BALLS) return false;
+
+    ResetNodeArena(&search->arena);
+    search->root = *game;
+    search->seed = seed ? seed : 1u;
+    search->elapsed = 0.0;
+    search->done = false;
+    atomic_init(&search->iterations, 0);
+    atomic_init(&search->nodes, 0);
+    atomic_init(&search->full, false);
+
+    search->rootNode = NewNode(search, NULL);
+    if (search->rootNode == NULL) return false;
+    PackTable(game, &search->rootNode->table);
+    return true;
+}
+
+static void SearchTask(void *context, int index) {
+
+    MCTSSearch *search = context;
+    Game table = search->root;
+    Game before;
+    unsigned int rng = search->seed * 2654435761u ^
+                       (unsigned int)(index + 1) * 40503u ^
+                       (unsigned int)atomic_load(&search->iterations);
+    if (rng == 0) rng = 1;
+
+    while (NowSeconds() < search->deadline &&
+           !atomic_load_explicit(&search->full, memory_order_relaxed))
+        RunIteration(search, &table, &before, &rng);
+}
+
+// Every worker runs iterations until `slice` seconds have gone or the
+// budget is spent. Returns true once the search is done, including
+// when the arena has filled up.
+bool ContinueMCTSSearch(MCTSSearch *search, ThreadPool *pool, double slice) {
+
+    if (search->done) return true;
+
+    double start = NowSeconds();
+    double remaining = search->config.budget - search->elapsed;
+    search->deadline = start + (slice < remaining ? slice : remaining);
+    RunParallel(pool, pool->workerCount, SearchTask, search);
+
+    search->elapsed += NowSeconds() - start;
+    if (search->elapsed >= search->config.budget ||
+        atomic_load_explicit(&search->full, memory_order_relaxed))
+        search->done = true;
+    return search->done;
+}
+
+// The most visited shot from the root. Returns false before any root
+// child has been built.
+bool BestMCTSShot(const MCTSSearch *search, AIShot *shot) {
+
+    const MCTSNode *best = NULL;
+    int bestVisits = -1;
+    for (int k = 0; k < MCTS_BRANCHING; k++) {
+        const MCTSNode *child = atomic_load(&search->rootNode->children[k]);
+        if (child == NULL) continue;
+        int visits = atomic_load(&child->visits);
+        if (visits > bestVisits) {
+            bestVisits = visits;
+            best = child;
+        }
+    }
+    if (best == NULL) return false;
+    *shot = best->shot;
+    return true;
+}
@@ -0,0 +1,97 @@
+#ifndef POOL_MCTS_H
+#define POOL_MCTS_H
+
+// Monte Carlo Tree Search over shot sequences, for safety play and
+// run-outs the one-shot search in pool_ai.c cannot see. Each node is a
+// table at rest after a shot; its children are MCTS_BRANCHING shots
+// sampled with SampleAIShot for whoever is to play there. A node stores
+// only what differs between positions at rest: ball positions, the
+// pocketed set and the rule state, unpacked onto a copy of the root
+// table whenever a shot has to be played from it.
+//
+// Nodes come from a bump arena that is reset at the start of every
+// decision, so a search makes no malloc calls and frees the whole tree
+// in one store. Every pool worker runs iterations at once. A worker
+// takes a child to expand by bumping the node's claim counter, so each
+// child is built exactly once, and marks the nodes on its path with a
+// virtual loss until it has backed up its result, which steers the
+// other workers down different lines.
+//
+// Values are kept from the root player's side, as fixed-point sums so
+// they can be added atomically. A path's value squashes the scores of
+// its shots (ScoreShotResult, the opponent's counted against) and of a
+// short random playout into [0, 1].
+
+#include "pool_ai.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MCTS_BRANCHING 12         // Shots sampled per position
+#define MCTS_PLAYOUT_SHOTS 2      // Random shots after a new leaf
+#define MCTS_VALUE_ONE 65536      // Fixed-point 1.0 in value sums
+
+// Bump allocator shared by the search threads
+typedef struct {
+    unsigned char *base;
+    size_t size;
+    atomic_size_t used;
+} NodeArena;
+
+// A table at rest, without the Game fields that stay the same
+typedef struct {
+    Vector2 position[MAX_BALLS];
+    Vector2 cueBallPos;
+    uint16_t pocketed;            // Bit per ball
+    uint8_t player;               // To shoot
+    uint8_t state;                // GameState
+    uint8_t types[2];             // PlayerType per player
+    uint8_t remaining[2];         // ballsRemaining per player
+    uint8_t flags;                // firstShot, assignedTypes
+} CompactTable;
+
+typedef struct MCTSNode {
+    struct MCTSNode *parent;
+    CompactTable table;           // Position after the shot
+    AIShot shot;                  // Shot from the parent that led here
+    float shotScore;              // ScoreShotResult for the parent's shooter
+    atomic_int visits;
+    atomic_int virtualLoss;       // Threads below this node right now
+    atomic_llong value;           // Root player's results, MCTS_VALUE_ONE each
+    atomic_int claimed;           // Children handed out to expand
+    _Atomic(struct MCTSNode *) children[MCTS_BRANCHING];
+} MCTSNode;
+
+typedef struct {
+    float budget;                 // Seconds of search per decision
+    size_t arenaBytes;            // Node memory
+    float exploration;            // UCT constant
+} MCTSConfig;
+
+typedef struct {
+    Game root;                    // Table being searched, balls at rest
+    MCTSConfig config;
+    NodeArena arena;
+    MCTSNode *rootNode;
+    unsigned int seed;
+    double deadline;              // Search clock, seconds
+    double elapsed;
+    atomic_int iterations;
+    atomic_int nodes;
+    atomic_bool full;             // Arena ran out; the search stops
+    bool done;
+} MCTSSearch;
+
+bool CreateNodeArena(NodeArena *arena, size_t bytes);
+void FreeNodeArena(NodeArena *arena);
+void ResetNodeArena(NodeArena *arena);
+void *ArenaAlloc(NodeArena *arena, size_t bytes);
+
+void DefaultMCTSConfig(MCTSConfig *config);
+bool CreateMCTSSearch(MCTSSearch *search, const MCTSConfig *config);
+void FreeMCTSSearch(MCTSSearch *search);
+bool BeginMCTSSearch(MCTSSearch *search, const Game *game, unsigned int seed);
+bool ContinueMCTSSearch(MCTSSearch *search, ThreadPool *pool, double slice);
+bool BestMCTSShot(const MCTSSearch *search, AIShot *shot);
+
+#endif // POOL_MCTS_H
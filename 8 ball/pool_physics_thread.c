@@ -0,0 +1,213 @@
+#define _POSIX_C_SOURCE 200809L   // For clock_gettime, clock_nanosleep
+
+#include "pool_physics_thread.h"
+#include "pool_trace.h"
+#include <time.h>        // For clock_gettime, clock_nanosleep
+
+#define QUEUE_MASK (PHYSICS_QUEUE_SIZE - 1)
+#define FRAME_INDEX 3u
+
+double PhysicsClock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void SleepUntil(double seconds) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)seconds;
+    ts.tv_nsec = (long)((seconds - (double)ts.tv_sec) * 1e9);
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) {}
+}
+
+// ---------------------- COMMAND QUEUE ----------------------
+//
+// Same ring as the AI mailboxes: tail counts commands pushed and is
+// stored (release) once the slot is filled, head counts commands played
+// and hands the slot back.
+
+static PhysicsCommand *ReserveCommand(PhysicsCommandQueue *queue) {
+
+    unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (tail - head == PHYSICS_QUEUE_SIZE) return NULL;
+    return &queue->slots[tail & QUEUE_MASK];
+}
+
+static void PushCommand(PhysicsThread *physics) {
+    PhysicsCommandQueue *queue = &physics->commands;
+    unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    physics->sent++;
+}
+
+// Plays every waiting command on the physics table
+static void ApplyCommands(PhysicsThread *physics) {
+
+    PhysicsCommandQueue *queue = &physics->commands;
+    unsigned int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+
+    for (; head != tail; head++) {
+        const PhysicsCommand *command = &queue->slots[head & QUEUE_MASK];
+        Game *table = &physics->table;
+        switch (command->kind) {
+        case PHYSICS_SHOT:
+            StrikeCueBall(table, command->shot.direction, command->shot.speed);
+            break;
+        case PHYSICS_PLACE:
+            PlaceCueBall(table, command->position);
+            break;
+        case PHYSICS_TABLE:
+            LoadSnapshot(table, command->snapshot, command->size);
+            break;
+        }
+        physics->applied++;
+        atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    }
+}
+
+// ---------------------- TRIPLE BUFFER ----------------------
+
+// Copies the table into the back frame and swaps it for the waiting one
+static void PublishFrame(PhysicsThread *physics, double time) {
+
+    PhysicsFrame *frame = &physics->frames[physics->back];
+    frame->table = physics->table;
+    frame->applied = physics->applied;
+    frame->time = time;
+
+    unsigned int old = atomic_exchange_explicit(&physics->latest,
+                                                physics->back | PHYSICS_FRAME_NEW,
+                                                memory_order_acq_rel);
+    physics->back = old & FRAME_INDEX;
+}
+
+// The newest frame, once it has caught up with every command sent, and
+// NULL while there is nothing newer. The frame stays valid until the
+// next call.
+const PhysicsFrame *ReadPhysicsFrame(PhysicsThread *physics) {
+
+    if (!(atomic_load_explicit(&physics->latest, memory_order_relaxed) &
+          PHYSICS_FRAME_NEW))
+        return NULL;
+    unsigned int old = atomic_exchange_explicit(&physics->latest, physics->front,
+                                                memory_order_acq_rel);
+    physics->front = old & FRAME_INDEX;
+
+    const PhysicsFrame *frame = &physics->frames[physics->front];
+    return frame->applied == physics->sent ? frame : NULL;
+}
+
+// ---------------------- PHYSICS THREAD ----------------------
+
+// Steps on a fixed schedule. After a stall longer than
+// PHYSICS_MAX_CATCH_UP only that much is made up and the rest of the
+// missed steps are dropped, as the game loop clamps a long frame.
+static void *PhysicsMain(void *arg) {
+
+    PhysicsThread *physics = arg;
+    double next = PhysicsClock();
+
+    while (!atomic_load_explicit(&physics->stopping, memory_order_acquire)) {
+        double step = 1.0 / physics->table.physicsHz;
+        double now = PhysicsClock();
+        if (now - next > PHYSICS_MAX_CATCH_UP) {
+            long long missed =
+                (long long)((now - next - PHYSICS_MAX_CATCH_UP) / step);
+            physics->dropped += missed;
+            next += missed * step;
+        }
+
+        ApplyCommands(physics);
+        if (next <= now) {
+            TRACE_BEGIN("PhysicsSteps");
+            double last = next;
+            int batch = 0;
+            while (next <= now) {
+                for (int i = 0; i < physics->table.ballCount; i++)
+                    physics->table.previousPositions[i] =
+                        physics->table.balls[i].position;
+                StepSimulation(&physics->table);
+                physics->steps++;
+                batch++;
+                last = next;
+                next += step;
+            }
+            if (batch > physics->longestBatch) physics->longestBatch = batch;
+            PublishFrame(physics, last);
+            TRACE_END("PhysicsSteps");
+        }
+        SleepUntil(next);
+    }
+    return NULL;
+}
+
+// ---------------------- GAME SIDE ----------------------
+
+// Starts stepping a copy of game. Every frame starts out as that copy,
+// so the first read has a table even before the first step.
+bool StartPhysicsThread(PhysicsThread *physics, const Game *game) {
+
+    atomic_init(&physics->commands.head, 0);
+    atomic_init(&physics->commands.tail, 0);
+    atomic_init(&physics->stopping, false);
+    physics->table = *game;
+    physics->sent = 0;
+    physics->applied = 0;
+    physics->steps = 0;
+    physics->dropped = 0;
+    physics->longestBatch = 0;
+
+    double now = PhysicsClock();
+    for (int f = 0; f < 3; f++) {
+        physics->frames[f].table = *game;
+        physics->frames[f].applied = 0;
+        physics->frames[f].time = now;
+    }
+    physics->front = 0;
+    physics->back = 1;
+    atomic_init(&physics->latest, 2u);
+
+    return pthread_create(&physics->thread, NULL, PhysicsMain, physics) == 0;
+}
+
+void StopPhysicsThread(PhysicsThread *physics) {
+    atomic_store_explicit(&physics->stopping, true, memory_order_release);
+    pthread_join(physics->thread, NULL);
+}
+
+// The senders return false if the queue is full and the command is not
+// sent. The game must then not play it on its own copy either, or the
+// next frame read would undo it.
+bool SendPhysicsShot(PhysicsThread *physics, ShotParams shot) {
+    PhysicsCommand *command = ReserveCommand(&physics->commands);
+    if (command == NULL) return false;
+    command->kind = PHYSICS_SHOT;
+    command->shot = shot;
+    PushCommand(physics);
+    return true;
+}
+
+bool SendPhysicsPlacement(PhysicsThread *physics, Vector2 position) {
+    PhysicsCommand *command = ReserveCommand(&physics->commands);
+    if (command == NULL) return false;
+    command->kind = PHYSICS_PLACE;
+    command->position = position;
+    PushCommand(physics);
+    return true;
+}
+
+bool SendPhysicsTable(PhysicsThread *physics, const Game *game) {
+    PhysicsCommand *command = ReserveCommand(&physics->commands);
+    if (command == NULL) return false;
+    command->kind = PHYSICS_TABLE;
+    command->size = SaveSnapshot(game, command->snapshot, sizeof command->snapshot);
+    if (command->size == 0) return false;
+    PushCommand(physics);
+    return true;
+}
@@ -0,0 +1,83 @@
+#ifndef POOL_PHYSICS_THREAD_H
+#define POOL_PHYSICS_THREAD_H
+
+// The table stepped on a thread of its own at the fixed physics rate,
+// so a slow frame on the game thread no longer holds up the balls and a
+// burst of physics no longer holds up drawing.
+//
+// After each batch of steps the physics thread copies its table into a
+// triple buffer: one frame it is writing, one the game thread is
+// reading, and the newest finished one waiting between them. Handing a
+// frame over is a single atomic exchange on either side, so neither
+// thread waits and the reader always gets a whole step.
+//
+// The game thread plays shots, cue placements and whole tables (restart,
+// load) on its own copy straight away, so the next frame already sees
+// them, and sends them to the physics thread through a single-producer,
+// single-consumer ring. Frames carry the number of commands applied
+// before them; the game thread only takes a frame that has caught up
+// with everything it sent.
+
+#include "pool_sim.h"
+#include "pool_snapshot.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define PHYSICS_QUEUE_SIZE 16         // Commands in flight (a power of two)
+#define PHYSICS_MAX_CATCH_UP 0.25     // Seconds of steps made up after a stall
+#define PHYSICS_FRAME_NEW 4u          // Flag on latest: not read yet
+
+typedef enum {
+    PHYSICS_SHOT,
+    PHYSICS_PLACE,                    // Cue ball in hand
+    PHYSICS_TABLE                     // Replace the table (restart, load)
+} PhysicsCommandKind;
+
+typedef struct {
+    PhysicsCommandKind kind;
+    ShotParams shot;
+    Vector2 position;
+    size_t size;
+    unsigned char snapshot[SNAPSHOT_SIZE_MAX];
+} PhysicsCommand;
+
+typedef struct {
+    _Alignas(64) atomic_uint head;    // Next to read, physics side
+    _Alignas(64) atomic_uint tail;    // Next to write, game side
+    PhysicsCommand slots[PHYSICS_QUEUE_SIZE];
+} PhysicsCommandQueue;
+
+typedef struct {
+    Game table;                       // After the step
+    unsigned int applied;             // Commands played before it
+    double time;                      // Physics clock at the step, seconds
+} PhysicsFrame;
+
+typedef struct {
+    PhysicsCommandQueue commands;
+    PhysicsFrame frames[3];
+    _Alignas(64) atomic_uint latest;  // Newest frame, | PHYSICS_FRAME_NEW
+    unsigned int sent;                // Game thread only
+    unsigned int front;               // Frame the game thread holds
+
+    // Physics thread only
+    Game table;
+    unsigned int applied;
+    unsigned int back;                // Frame being written
+    long long steps;                  // Run since start
+    long long dropped;                // Skipped after stalls
+    int longestBatch;                 // Most steps run back to back
+
+    pthread_t thread;
+    atomic_bool stopping;
+} PhysicsThread;
+
+bool StartPhysicsThread(PhysicsThread *physics, const Game *game);
+void StopPhysicsThread(PhysicsThread *physics);
+bool SendPhysicsShot(PhysicsThread *physics, ShotParams shot);
+bool SendPhysicsPlacement(PhysicsThread *physics, Vector2 position);
+bool SendPhysicsTable(PhysicsThread *physics, const Game *game);
+const PhysicsFrame *ReadPhysicsFrame(PhysicsThread *physics);
+double PhysicsClock(void);
+
+#endif // POOL_PHYSICS_THREAD_H
@@ -0,0 +1,146 @@
+#define _POSIX_C_SOURCE 200809L   // For clock_gettime
+
+#include "pool_profile.h"
+
+#ifndef NDEBUG
+
+#include <stdlib.h>      // For qsort
+#include <time.h>        // For clock_gettime
+
+// The time stamp counter costs a few nanoseconds to read; elsewhere the
+// monotonic clock is used directly and a tick is a nanosecond
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>   // For __rdtsc
+#define PROFILE_USE_TSC 1
+#endif
+
+typedef struct {
+    // Frame in progress
+    uint64_t phaseTicks[PROFILE_PHASE_COUNT];
+    int counters[PROFILE_COUNTER_COUNT];
+
+    // Finished frames, oldest overwritten first
+    float phaseHistory[PROFILE_PHASE_COUNT][PROFILE_HISTORY];
+    float counterHistory[PROFILE_COUNTER_COUNT][PROFILE_HISTORY];
+    int frames;                   // Frames filed so far
+
+    // Tick rate, measured against the monotonic clock since the first frame
+    bool calibrated;
+    uint64_t baseTicks;
+    uint64_t baseNanos;
+    double ticksPerMicro;
+} Profiler;
+
+static _Thread_local Profiler profiler;
+
+static uint64_t MonotonicNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t ProfileNow(void) {
+#ifdef PROFILE_USE_TSC
+    return __rdtsc();
+#else
+    return MonotonicNanos();
+#endif
+}
+
+void ProfileAddTime(ProfilePhase phase, uint64_t ticks) {
+    profiler.phaseTicks[phase] += ticks;
+}
+
+void ProfileAddCount(ProfileCounter counter, int amount) {
+    profiler.counters[counter] += amount;
+}
+
+// Files the current frame into the history and starts the next one. The
+// first frame only starts the tick calibration and is dropped.
+void ProfileEndFrame(void) {
+
+    uint64_t nanos = MonotonicNanos();
+    uint64_t ticks = ProfileNow();
+
+    if (!profiler.calibrated) {
+        profiler.calibrated = true;
+        profiler.baseTicks = ticks;
+        profiler.baseNanos = nanos;
+        profiler.ticksPerMicro = 1000.0;
+    }
+    else {
+#ifdef PROFILE_USE_TSC
+        if (nanos > profiler.baseNanos)
+            profiler.ticksPerMicro = (double)(ticks - profiler.baseTicks) * 1000.0 /
+                                     (double)(nanos - profiler.baseNanos);
+#endif
+        int slot = profiler.frames % PROFILE_HISTORY;
+        for (int p = 0; p < PROFILE_PHASE_COUNT; p++)
+            profiler.phaseHistory[p][slot] =
+                (float)(profiler.phaseTicks[p] / profiler.ticksPerMicro);
+        for (int c = 0; c < PROFILE_COUNTER_COUNT; c++)
+            profiler.counterHistory[c][slot] = (float)profiler.counters[c];
+        profiler.frames++;
+    }
+
+    for (int p = 0; p < PROFILE_PHASE_COUNT; p++)
+        profiler.phaseTicks[p] = 0;
+    for (int c = 0; c < PROFILE_COUNTER_COUNT; c++)
+        profiler.counters[c] = 0;
+}
+
+int GetProfileFrames(void) {
+    return profiler.frames;
+}
+
+static int CompareFloats(const void *a, const void *b) {
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+static void SummarizeHistory(const float *history, ProfileStats *stats) {
+
+    int count = profiler.frames < PROFILE_HISTORY ? profiler.frames : PROFILE_HISTORY;
+    if (count == 0) {
+        *stats = (ProfileStats){0};
+        return;
+    }
+
+    float sorted[PROFILE_HISTORY];
+    float sum = 0.0f;
+    for (int i = 0; i < count; i++) {
+        sorted[i] = history[i];
+        sum += history[i];
+    }
+    qsort(sorted, count, sizeof sorted[0], CompareFloats);
+
+    // Nearest-rank percentile
+    int rank = (count * 99 + 99) / 100 - 1;
+
+    stats->last = history[(profiler.frames - 1) % PROFILE_HISTORY];
+    stats->min = sorted[0];
+    stats->avg = sum / count;
+    stats->p99 = sorted[rank];
+}
+
+void GetPhaseStats(ProfilePhase phase, ProfileStats *stats) {
+    SummarizeHistory(profiler.phaseHistory[phase], stats);
+}
+
+void GetCounterStats(ProfileCounter counter, ProfileStats *stats) {
+    SummarizeHistory(profiler.counterHistory[counter], stats);
+}
+
+const char *ProfilePhaseName(ProfilePhase phase) {
+    static const char *names[] = {
+        "input", "physics", "collide", "pockets", "draw"
+    };
+    return names[phase];
+}
+
+const char *ProfileCounterName(ProfileCounter counter) {
+    static const char *names[] = { "steps", "pairs", "hits" };
+    return names[counter];
+}
+
+#endif // NDEBUG
@@ -0,0 +1,71 @@
+#ifndef POOL_PROFILE_H
+#define POOL_PROFILE_H
+
+// Frame profiler for the hot paths. Phase timers accumulate into the
+// current frame, ProfileEndFrame files the frame away, and the last
+// PROFILE_HISTORY frames give min / avg / p99 per phase and per counter.
+// Everything compiles out when NDEBUG is defined. State is per thread,
+// so headless jobs on worker threads never touch the game's numbers.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PROFILE_HISTORY 240       // Frames kept for the rolling stats
+
+// Timed phases. Physics includes collisions and pockets.
+typedef enum {
+    PROFILE_INPUT,
+    PROFILE_PHYSICS,
+    PROFILE_COLLISIONS,
+    PROFILE_POCKETS,
+    PROFILE_DRAW,
+    PROFILE_PHASE_COUNT
+} ProfilePhase;
+
+// Per-frame totals
+typedef enum {
+    PROFILE_STEPS,                // Physics steps run
+    PROFILE_PAIR_TESTS,           // From SimStats
+    PROFILE_COLLISIONS_RESOLVED,  // From SimStats
+    PROFILE_COUNTER_COUNT
+} ProfileCounter;
+
+// Microseconds for phases, plain counts for counters
+typedef struct {
+    float last;                   // Most recent frame
+    float min;
+    float avg;
+    float p99;
+} ProfileStats;
+
+#ifndef NDEBUG
+
+#define PROFILE_ENABLED 1
+
+uint64_t ProfileNow(void);
+void ProfileAddTime(ProfilePhase phase, uint64_t ticks);
+void ProfileAddCount(ProfileCounter counter, int amount);
+void ProfileEndFrame(void);
+int GetProfileFrames(void);
+void GetPhaseStats(ProfilePhase phase, ProfileStats *stats);
+void GetCounterStats(ProfileCounter counter, ProfileStats *stats);
+const char *ProfilePhaseName(ProfilePhase phase);
+const char *ProfileCounterName(ProfileCounter counter);
+
+// Brackets one phase; both halves must sit in the same block
+#define PROFILE_BEGIN(phase) uint64_t profileStart_##phase = ProfileNow()
+#define PROFILE_END(phase) \
+    ProfileAddTime(phase, ProfileNow() - profileStart_##phase)
+#define PROFILE_COUNT(counter, amount) ProfileAddCount(counter, amount)
+#define PROFILE_END_FRAME() ProfileEndFrame()
+
+#else
+
+#define PROFILE_BEGIN(phase) ((void)0)
+#define PROFILE_END(phase) ((void)0)
+#define PROFILE_COUNT(counter, amount) ((void)0)
+#define PROFILE_END_FRAME() ((void)0)
+
+#endif // NDEBUG
+
+#endif // POOL_PROFILE_H
@@ -0,0 +1,483 @@
+#include "pool_replay.h"
+#include <stdlib.h>      // For malloc, realloc, free
+#include <string.h>      // For memcpy, memcmp
+
+#define REPLAY_SHOT 1
+#define REPLAY_KEYFRAME 2
+
+#define HEADER_SIZE 12
+#define FOOTER_SIZE 12
+#define ENTRY_SIZE 12
+#define SHOT_SIZE_MAX 22
+#define KEYFRAME_FIXED_SIZE 18     // Everything up to the per-ball data
+#define KEYFRAME_SIZE_MAX (KEYFRAME_FIXED_SIZE + MAX_TABLE_BALLS * 9)
+
+// ---------------------- BYTE ORDER ----------------------
+
+static unsigned char *PutU8(unsigned char *p, unsigned int v) {
+    *p = (unsigned char)v;
+    return p + 1;
+}
+
+static unsigned char *PutU16(unsigned char *p, unsigned int v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    return p + 2;
+}
+
+static unsigned char *PutU32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++)
+        p[i] = (unsigned char)(v >> (8 * i));
+    return p + 4;
+}
+
+static unsigned char *PutF32(unsigned char *p, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof bits);
+    return PutU32(p, bits);
+}
+
+static unsigned int GetU8(const unsigned char **p) {
+    return *(*p)++;
+}
+
+static unsigned int GetU16(const unsigned char **p) {
+    unsigned int v = (*p)[0] | ((*p)[1] << 8);
+    *p += 2;
+    return v;
+}
+
+static uint32_t GetU32(const unsigned char **p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++)
+        v |= (uint32_t)(*p)[i] << (8 * i);
+    *p += 4;
+    return v;
+}
+
+static float GetF32(const unsigned char **p) {
+    uint32_t bits = GetU32(p);
+    float v;
+    memcpy(&v, &bits, sizeof v);
+    return v;
+}
+
+// ---------------------- RECORDS ----------------------
+
+// The rule state and ball positions of a table at rest. Velocities are
+// all zero there, and ball types and numbers never change.
+static size_t PackKeyframe(unsigned char *buffer, const Game *game) {
+
+    unsigned char *p = buffer;
+    p = PutU8(p, REPLAY_KEYFRAME);
+    p = PutU8(p, game->state);
+    p = PutU8(p, game->currentPlayer);
+    p = PutU8(p, (game->firstShot ? 1 : 0) | (game->assignedTypes ? 2 : 0));
+    for (int i = 0; i < 2; i++) {
+        p = PutU8(p, game->players[i].type);
+        p = PutU8(p, game->players[i].ballsRemaining);
+    }
+    p = PutF32(p, game->cueBallPos.x);
+    p = PutF32(p, game->cueBallPos.y);
+    p = PutU16(p, game->ballCount);
+    for (int i = 0; i < game->ballCount; i++) {
+        p = PutF32(p, game->balls[i].position.x);
+        p = PutF32(p, game->balls[i].position.y);
+        p = PutU8(p, game->balls[i].pocketed);
+    }
+    return p - buffer;
+}
+
+static size_t PackShot(unsigned char *buffer, bool placed, Vector2 placement,
+                       ShotParams shot) {
+
+    unsigned char *p = buffer;
+    p = PutU8(p, REPLAY_SHOT);
+    p = PutU8(p, placed);
+    if (placed) {
+        p = PutF32(p, placement.x);
+        p = PutF32(p, placement.y);
+    }
+    p = PutF32(p, shot.direction.x);
+    p = PutF32(p, shot.direction.y);
+    p = PutF32(p, shot.speed);
+    return p - buffer;
+}
+
+// ---------------------- RECORDING ----------------------
+
+// Creates path and writes the header. The game supplies the physics
+// rate, which playback needs to reproduce the shots.
+bool OpenReplayWriter(ReplayWriter *writer, const char *path, const Game *game) {
+
+    writer->keyframe = malloc(KEYFRAME_SIZE_MAX);
+    writer->file = writer->keyframe ? fopen(path, "wb") : NULL;
+    if (writer->file == NULL) {
+        free(writer->keyframe);
+        return false;
+    }
+
+    writer->keyframeSize = 0;
+    writer->index = NULL;
+    writer->shotCount = 0;
+    writer->capacity = 0;
+    writer->shotsSinceKeyframe = 0;
+    writer->forceKeyframe = true;
+    writer->placed = false;
+    writer->keyframeOffset = 0;
+    writer->keyframeShot = 0;
+
+    unsigned char header[HEADER_SIZE], *p = header;
+    memcpy(p, "8BRP", 4);
+    p = PutU16(p + 4, REPLAY_VERSION);
+    p = PutU16(p, game->physicsHz);
+    PutU32(p, REPLAY_KEYFRAME_SHOTS);
+    return fwrite(header, 1, HEADER_SIZE, writer->file) == HEADER_SIZE;
+}
+
+static bool KeyframeDue(const ReplayWriter *writer) {
+    return writer->forceKeyframe ||
+           writer->shotsSinceKeyframe >= REPLAY_KEYFRAME_SHOTS;
+}
+
+// A cue placement attempt after a scratch, called before PlaceCueBall.
+// Only the last one before a shot is kept: it is the one that worked,
+// since the cue cannot be struck until a placement succeeds. A keyframe
+// due at this shot is taken now, while the table is still as the
+// previous shot left it.
+void RecordPlacement(ReplayWriter *writer, const Game *game, Vector2 position) {
+    if (!writer->placed && KeyframeDue(writer))
+        writer->keyframeSize = PackKeyframe(writer->keyframe, game);
+    writer->placed = true;
+    writer->placement = position;
+}
+
+// The next shot starts a new game, so it gets a keyframe of its own
+void RecordRestart(ReplayWriter *writer) {
+    writer->forceKeyframe = true;
+    writer->placed = false;
+}
+
+// Appends a shot, called with the table at rest just before the strike.
+// Every REPLAY_KEYFRAME_SHOTS shots the table is stored first.
+void RecordShot(ReplayWriter *writer, const Game *game, ShotParams shot) {
+
+    unsigned char buffer[SHOT_SIZE_MAX];
+
+    if (writer->file == NULL) return;
+
+    if (writer->shotCount == writer->capacity) {
+        int capacity = writer->capacity ? writer->capacity * 2 : 64;
+        ReplayIndexEntry *index = realloc(writer->index, capacity * sizeof *index);
+        if (index == NULL) return;
+        writer->index = index;
+        writer->capacity = capacity;
+    }
+
+    if (KeyframeDue(writer)) {
+        if (!writer->placed)
+            writer->keyframeSize = PackKeyframe(writer->keyframe, game);
+        writer->keyframeOffset = (uint32_t)ftell(writer->file);
+        writer->keyframeShot = writer->shotCount;
+        fwrite(writer->keyframe, 1, writer->keyframeSize, writer->file);
+        writer->shotsSinceKeyframe = 0;
+        writer->forceKeyframe = false;
+    }
+
+    writer->index[writer->shotCount++] = (ReplayIndexEntry){
+        (uint32_t)ftell(writer->file), writer->keyframeOffset, writer->keyframeShot
+    };
+    fwrite(buffer, 1, PackShot(buffer, writer->placed, writer->placement, shot),
+           writer->file);
+    writer->shotsSinceKeyframe++;
+    writer->placed = false;
+
+    // A crash then loses at most the index, which playback can rebuild
+    fflush(writer->file);
+}
+
+// Writes the index and footer and closes the file
+bool CloseReplayWriter(ReplayWriter *writer) {
+
+    if (writer->file == NULL) return false;
+
+    uint32_t indexOffset = (uint32_t)ftell(writer->file);
+    bool ok = true;
+
+    for (int s = 0; s < writer->shotCount; s++) {
+        unsigned char entry[ENTRY_SIZE], *p = entry;
+        p = PutU32(p, writer->index[s].shotOffset);
+        p = PutU32(p, writer->index[s].keyframeOffset);
+        PutU32(p, writer->index[s].keyframeShot);
+        ok &= fwrite(entry, 1, ENTRY_SIZE, writer->file) == ENTRY_SIZE;
+    }
+
+    unsigned char footer[FOOTER_SIZE], *p = footer;
+    p = PutU32(p, writer->shotCount);
+    p = PutU32(p, indexOffset);
+    memcpy(p, "8BIX", 4);
+    ok &= fwrite(footer, 1, FOOTER_SIZE, writer->file) == FOOTER_SIZE;
+
+    ok &= fclose(writer->file) == 0;
+    free(writer->index);
+    free(writer->keyframe);
+    writer->file = NULL;
+    writer->index = NULL;
+    writer->keyframe = NULL;
+    return ok;
+}
+
+// ---------------------- PLAYBACK ----------------------
+
+static bool AddEntry(ReplayReader *reader, int *capacity, ReplayIndexEntry entry) {
+
+    if (reader->shotCount == *capacity) {
+        int grown = *capacity ? *capacity * 2 : 64;
+        ReplayIndexEntry *index = realloc(reader->index, grown * sizeof *index);
+        if (index == NULL) return false;
+        reader->index = index;
+        *capacity = grown;
+    }
+    reader->index[reader->shotCount++] = entry;
+    return true;
+}
+
+// Rebuilds the index of a recording that was never closed by walking
+// its records; a torn record at the end is ignored
+static bool ScanRecords(ReplayReader *reader) {
+
+    static unsigned char buffer[KEYFRAME_SIZE_MAX];
+    int capacity = 0;
+    uint32_t keyframeOffset = 0, keyframeShot = 0;
+    bool haveKeyframe = false;
+
+    fseek(reader->file, HEADER_SIZE, SEEK_SET);
+
+    for (;;) {
+        uint32_t offset = (uint32_t)ftell(reader->file);
+        int tag = fgetc(reader->file);
+
+        if (tag == REPLAY_KEYFRAME) {
+            if (fread(buffer, 1, KEYFRAME_FIXED_SIZE - 1, reader->file) !=
+                KEYFRAME_FIXED_SIZE - 1)
+                break;
+            const unsigned char *p = buffer + KEYFRAME_FIXED_SIZE - 3;
+            size_t balls = GetU16(&p);
+            if (balls > MAX_TABLE_BALLS ||
+                fread(buffer, 9, balls, reader->file) != balls)
+                break;
+            keyframeOffset = offset;
+            keyframeShot = reader->shotCount;
+            haveKeyframe = true;
+        }
+        else if (tag == REPLAY_SHOT && haveKeyframe) {
+            int placed = fgetc(reader->file);
+            size_t size = placed > 0 ? 20 : 12;
+            if (placed == EOF || fread(buffer, 1, size, reader->file) != size)
+                break;
+            if (!AddEntry(reader, &capacity,
+                          (ReplayIndexEntry){ offset, keyframeOffset, keyframeShot }))
+                return false;
+        }
+        else {
+            break;
+        }
+    }
+    return true;
+}
+
+// Opens a recording and loads its index. A recording whose writer was
+// never closed has no index, so its records are scanned instead.
+bool OpenReplay(ReplayReader *reader, const char *path) {
+
+    reader->file = fopen(path, "rb");
+    reader->index = NULL;
+    reader->shotCount = 0;
+    reader->nextShot = 0;
+    if (reader->file == NULL) return false;
+
+    unsigned char header[HEADER_SIZE];
+    const unsigned char *p = header + 4;
+    if (fread(header, 1, HEADER_SIZE, reader->file) != HEADER_SIZE ||
+        memcmp(header, "8BRP", 4) != 0 ||
+        GetU16(&p) != REPLAY_VERSION) {
+        CloseReplay(reader);
+        return false;
+    }
+    reader->physicsHz = GetU16(&p);
+
+    unsigned char footer[FOOTER_SIZE];
+    p = footer;
+    if (fseek(reader->file, -FOOTER_SIZE, SEEK_END) != 0 ||
+        fread(footer, 1, FOOTER_SIZE, reader->file) != FOOTER_SIZE ||
+        memcmp(footer + 8, "8BIX", 4) != 0) {
+        if (!ScanRecords(reader)) {
+            CloseReplay(reader);
+            return false;
+        }
+        return true;
+    }
+
+    int count = (int)GetU32(&p);
+    uint32_t indexOffset = GetU32(&p);
+    reader->index = malloc((count > 0 ? count : 1) * sizeof *reader->index);
+    if (reader->index == NULL || fseek(reader->file, indexOffset, SEEK_SET) != 0) {
+        CloseReplay(reader);
+        return false;
+    }
+
+    for (int s = 0; s < count; s++) {
+        unsigned char entry[ENTRY_SIZE];
+        if (fread(entry, 1, ENTRY_SIZE, reader->file) != ENTRY_SIZE) {
+            CloseReplay(reader);
+            return false;
+        }
+        p = entry;
+        reader->index[s].shotOffset = GetU32(&p);
+        reader->index[s].keyframeOffset = GetU32(&p);
+        reader->index[s].keyframeShot = GetU32(&p);
+    }
+    reader->shotCount = count;
+    return true;
+}
+
+void CloseReplay(ReplayReader *reader) {
+    if (reader->file != NULL) fclose(reader->file);
+    free(reader->index);
+    reader->file = NULL;
+    reader->index = NULL;
+}
+
+// Restores the table stored at offset; the game is reset first so any
+// state not in the keyframe starts from its defaults
+static bool LoadKeyframe(ReplayReader *reader, Game *game, uint32_t offset) {
+
+    static unsigned char buffer[KEYFRAME_SIZE_MAX];
+
+    if (fseek(reader->file, offset, SEEK_SET) != 0 ||
+        fread(buffer, 1, KEYFRAME_FIXED_SIZE, reader->file) != KEYFRAME_FIXED_SIZE ||
+        buffer[0] != REPLAY_KEYFRAME)
+        return false;
+
+    const unsigned char *p = buffer + KEYFRAME_FIXED_SIZE - 2;
+    int balls = GetU16(&p);
+    if (balls > MAX_TABLE_BALLS ||
+        fread(buffer + KEYFRAME_FIXED_SIZE, 9, balls, reader->file) != (size_t)balls)
+        return false;
+
+    InitGame(game);
+    SetPhysicsRate(game, reader->physicsHz);
+
+    p = buffer + 1;
+    game->state = GetU8(&p);
+    game->currentPlayer = GetU8(&p);
+    unsigned int flags = GetU8(&p);
+    game->firstShot = (flags & 1) != 0;
+    game->assignedTypes = (flags & 2) != 0;
+    for (int i = 0; i < 2; i++) {
+        game->players[i].type = GetU8(&p);
+        game->players[i].ballsRemaining = GetU8(&p);
+    }
+    game->cueBallPos.x = GetF32(&p);
+    game->cueBallPos.y = GetF32(&p);
+    game->ballCount = GetU16(&p);
+    for (int i = 0; i < game->ballCount; i++) {
+        game->balls[i].position.x = GetF32(&p);
+        game->balls[i].position.y = GetF32(&p);
+        game->balls[i].pocketed = GetU8(&p) != 0;
+        game->balls[i].velocity = (Vector2){0, 0};
+        game->previousPositions[i] = game->balls[i].position;
+    }
+
+    RebuildTableState(game);
+    return true;
+}
+
+// The inputs of one shot: the cue placement that preceded it, if any,
+// and the strike
+bool ReadReplayShot(ReplayReader *reader, int shot, bool *placed,
+                    Vector2 *placement, ShotParams *params) {
+
+    unsigned char buffer[SHOT_SIZE_MAX];
+
+    if (fseek(reader->file, reader->index[shot].shotOffset, SEEK_SET) != 0 ||
+        fread(buffer, 1, 2, reader->file) != 2 ||
+        buffer[0] != REPLAY_SHOT)
+        return false;
+
+    size_t size = buffer[1] ? 20 : 12;
+    if (fread(buffer + 2, 1, size, reader->file) != size)
+        return false;
+
+    const unsigned char *p = buffer + 2;
+    *placed = buffer[1] != 0;
+    if (*placed) {
+        placement->x = GetF32(&p);
+        placement->y = GetF32(&p);
+    }
+    params->direction.x = GetF32(&p);
+    params->direction.y = GetF32(&p);
+    params->speed = GetF32(&p);
+    return true;
+}
+
+// Strikes shot reader->nextShot, placing the cue ball first after a
+// scratch, and leaves the balls rolling for the caller to step. A shot
+// that opens a keyframe starts from the stored table, which also picks
+// up restarts made during recording. Returns false past the last shot.
+bool PlayNextShot(ReplayReader *reader, Game *game) {
+
+    int shot = reader->nextShot;
+    if (shot >= reader->shotCount) return false;
+
+    if (reader->index[shot].keyframeShot == (uint32_t)shot &&
+        !LoadKeyframe(reader, game, reader->index[shot].keyframeOffset))
+        return false;
+
+    bool placed;
+    Vector2 placement;
+    ShotParams params;
+    if (!ReadReplayShot(reader, shot, &placed, &placement, &params))
+        return false;
+
+    if (placed)
+        PlaceCueBall(game, placement);
+    StrikeCueBall(game, params.direction, params.speed);
+    reader->nextShot = shot + 1;
+    return true;
+}
+
+// Puts the game at rest just before shot `shot` (shotCount for the end
+// of the recording): loads the nearest keyframe at or before it and
+// plays the shots in between with the same fixed steps as the game.
+bool SeekReplay(ReplayReader *reader, Game *game, int shot) {
+
+    if (shot < 0 || shot > reader->shotCount) return false;
+
+    if (reader->shotCount == 0) {
+        InitGame(game);
+        SetPhysicsRate(game, reader->physicsHz);
+        reader->nextShot = 0;
+        return true;
+    }
+
+    const ReplayIndexEntry *entry =
+        &reader->index[shot < reader->shotCount ? shot : reader->shotCount - 1];
+    if (!LoadKeyframe(reader, game, entry->keyframeOffset))
+        return false;
+
+    game->fastForward = false;
+    reader->nextShot = (int)entry->keyframeShot;
+    while (reader->nextShot < shot) {
+        if (!PlayNextShot(reader, game)) return false;
+
+        // A shot that ends the game stops the clock with balls rolling,
+        // as it does on screen
+        int steps = 0;
+        do {
+            StepSimulation(game);
+            steps++;
+        } while (game->ballsMoving && steps < MAX_SIMULATION_STEPS);
+    }
+    return true;
+}
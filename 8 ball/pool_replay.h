@@ -0,0 +1,66 @@
+#ifndef POOL_REPLAY_H
+#define POOL_REPLAY_H
+
+// Binary game recordings. A replay stores the inputs of every shot (cue
+// placement after a scratch, then direction and speed) and, every few
+// shots, a keyframe of the table at rest. An index at the end of the
+// file maps each shot to its record and to the keyframe it starts from,
+// so seeking re-simulates at most REPLAY_KEYFRAME_SHOTS - 1 shots.
+//
+// File layout, all little-endian:
+//   header   "8BRP", u16 version, u16 physicsHz, u32 keyframe interval
+//   records  tag byte + payload (REPLAY_SHOT, REPLAY_KEYFRAME)
+//   index    per shot: u32 shot record offset, u32 keyframe offset,
+//            u32 keyframe shot
+//   footer   u32 shot count, u32 index offset, "8BIX"
+
+#include "pool_sim.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#define REPLAY_VERSION 1
+#define REPLAY_KEYFRAME_SHOTS 8   // Shots between keyframes
+
+typedef struct {
+    uint32_t shotOffset;          // REPLAY_SHOT record of this shot
+    uint32_t keyframeOffset;      // Latest keyframe at or before it
+    uint32_t keyframeShot;        // The shot that keyframe was taken at
+} ReplayIndexEntry;
+
+typedef struct {
+    FILE *file;
+    ReplayIndexEntry *index;
+    int shotCount;
+    int capacity;
+    int shotsSinceKeyframe;
+    bool forceKeyframe;           // Set by a restart
+    bool placed;                  // Placement waiting for the next shot
+    Vector2 placement;
+    unsigned char *keyframe;      // Packed table for the next keyframe
+    size_t keyframeSize;
+    uint32_t keyframeOffset;
+    uint32_t keyframeShot;
+} ReplayWriter;
+
+typedef struct {
+    FILE *file;
+    ReplayIndexEntry *index;
+    int shotCount;
+    int physicsHz;
+    int nextShot;                 // Shot PlayNextShot will play
+} ReplayReader;
+
+bool OpenReplayWriter(ReplayWriter *writer, const char *path, const Game *game);
+void RecordPlacement(ReplayWriter *writer, const Game *game, Vector2 position);
+void RecordShot(ReplayWriter *writer, const Game *game, ShotParams shot);
+void RecordRestart(ReplayWriter *writer);
+bool CloseReplayWriter(ReplayWriter *writer);
+
+bool OpenReplay(ReplayReader *reader, const char *path);
+void CloseReplay(ReplayReader *reader);
+bool SeekReplay(ReplayReader *reader, Game *game, int shot);
+bool PlayNextShot(ReplayReader *reader, Game *game);
+bool ReadReplayShot(ReplayReader *reader, int shot, bool *placed,
+                    Vector2 *placement, ShotParams *params);
+
+#endif // POOL_REPLAY_H
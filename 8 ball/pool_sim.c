@@ -0,0 +1,1096 @@
+#include "pool_sim.h"
+#include "pool_profile.h"
+#include "pool_trace.h"
+#include <math.h>        // For sqrtf, powf, pow, log, ceil
+#include <stdio.h>       // For sprintf
+#include <string.h>      // For strcpy
+
+static void RefileBall(Game *game, int ball);
+static void StoreLane(Game *game, int i);
+static float RackRowOffset(int row);
+static bool BallInPocket(const Game *game, int ball, Vector2 pocket);
+#ifndef SIM_FIXED_POINT
+static bool FastForwardLoneBall(Game *game);
+#endif
+
+// ---------------------- GAME INITIALIZATION ----------------------
+
+void InitGame(Game *game) {
+
+    // Initialize player names and starting state
+    strcpy(game->players[0].name, "Player 1");
+    game->players[0].type = PLAYER_NONE;
+    game->players[0].ballsRemaining = 7;
+    game->players[0].computer = false;
+
+    strcpy(game->players[1].name, "Player 2");
+    game->players[1].type = PLAYER_NONE;
+    game->players[1].ballsRemaining = 7;
+    game->players[1].computer = false;
+
+    game->currentPlayer = 0;
+    game->state = GAME_START;
+
+    game->power = 0.0f;
+    game->aiming = false;
+    game->ballsMoving = false;
+    game->firstShot = true;
+    game->assignedTypes = false;
+
+    strcpy(game->statusMessage, 
+        "Break shot: click on cue, drag back, release to shoot");
+
+    // Cue stick initial settings
+    game->stickPullPixels = 0.0f;
+    game->stickLength = 120.0f;
+    game->stickRecoil = false;
+    game->recoilTimer = 0.0f;
+
+    // Physics clock
+    SetPhysicsRate(game, PHYSICS_HZ);
+    game->accumulator = 0.0f;
+    game->fastForward = false;
+
+    // Arrange balls
+    ResetBalls(game);
+}
+
+// ---------------------- BALL SETUP ----------------------
+
+void ResetBalls(Game *game) {
+
+    game->ballCount = MAX_BALLS;
+
+    // Triangle rack starting position
+    Vector2 triangleStart = { TABLE_WIDTH * 0.72f, TABLE_HEIGHT * 0.5f };
+
+    // Setup cue ball
+    game->balls[0].position = 
+        (Vector2){ TABLE_WIDTH * 0.25f, TABLE_HEIGHT * 0.5f };
+    game->balls[0].velocity = (Vector2){0, 0};
+    game->balls[0].type = BALL_CUE;
+    game->balls[0].number = 0;
+    game->balls[0].pocketed = false;
+    game->balls[0].isStriped = false;
+
+    int idx = 1;
+
+    // Create triangle formation
+    
+    for (int row = 0; row < 5; row++) {
+        for (int col = 0; col <= row; col++) {
+
+            if (idx >= MAX_BALLS) break;
+
+            float offsetX = RackRowOffset(row);
+            float offsetY = (col * (BALL_RADIUS * 2)) 
+                            - (row * BALL_RADIUS);
+
+            game->balls[idx].position = 
+                (Vector2){ triangleStart.x + offsetX,
+                           triangleStart.y + offsetY };
+
+            game->balls[idx].velocity = (Vector2){0,0};
+            game->balls[idx].pocketed = false;
+
+            // Assign ball types
+            if (idx == 8) {
+                game->balls[idx].type = BALL_EIGHT;
+                game->balls[idx].isStriped = false;
+            }
+            else if (idx <= 7) {
+                game->balls[idx].type = BALL_SOLID;
+                game->balls[idx].isStriped = false;
+            }
+            else {
+                game->balls[idx].type = BALL_STRIPE;
+                game->balls[idx].isStriped = true;
+            }
+            game->balls[idx].number = idx;
+            idx++;
+        }
+    }
+
+    game->cueBallPos = game->balls[0].position;
+
+    for (int i = 0; i < game->ballCount; i++)
+        game->previousPositions[i] = game->balls[i].position;
+
+    RebuildTableState(game);
+}
+
+// Horizontal rack spacing. Fixed-point builds work it out in integers:
+// a float multiply here could be fused with the add that follows (FMA)
+// in some builds and not others, moving the rack by one rounding.
+static float RackRowOffset(int row) {
+#ifdef SIM_FIXED_POINT
+    return FixedToFloat(row * FIXED_FROM_CONST(BALL_RADIUS * 2 * 0.88));
+#else
+    return row * (BALL_RADIUS * 2 * 0.88f);
+#endif
+}
+
+// Rebuilds the grid and the awake set after balls were edited directly
+void RebuildTableState(Game *game) {
+
+    game->awakeCount = 0;
+    for (int i = 0; i < MAX_TABLE_BALLS; i++)
+        game->awakeSlot[i] = -1;
+
+    for (int i = 0; i < game->ballCount; i++) {
+        if (!game->balls[i].pocketed &&
+            (game->balls[i].velocity.x != 0.0f ||
+             game->balls[i].velocity.y != 0.0f))
+            WakeBall(game, i);
+    }
+
+#ifdef SIM_FIXED_POINT
+    for (int i = 0; i < game->ballCount; i++)
+        LoadFixedBall(game, i);
+#endif
+
+    // Padding lanes stay at rest in the middle of the table
+    for (int i = 0; i < PHYSICS_LANES; i++) {
+        if (i < game->ballCount) {
+            StoreLane(game, i);
+        }
+        else {
+            game->lanes.x[i] = TABLE_WIDTH * 0.5f;
+            game->lanes.y[i] = TABLE_HEIGHT * 0.5f;
+            game->lanes.vx[i] = 0.0f;
+            game->lanes.vy[i] = 0.0f;
+        }
+    }
+
+    RebuildBallGrid(game);
+}
+
+// ---------------------- AWAKE SET ----------------------
+
+// Adds a ball to the awake list (no-op if it is already there)
+void WakeBall(Game *game, int ball) {
+    if (game->awakeSlot[ball] >= 0) return;
+    game->awakeSlot[ball] = (short)game->awakeCount;
+    game->awakeList[game->awakeCount++] = (short)ball;
+}
+
+// Removes a ball from the awake list by swapping in the last entry
+void SleepBall(Game *game, int ball) {
+    int slot = game->awakeSlot[ball];
+    if (slot < 0) return;
+    int last = game->awakeList[--game->awakeCount];
+    game->awakeList[slot] = (short)last;
+    game->awakeSlot[last] = (short)slot;
+    game->awakeSlot[ball] = -1;
+
+    // A sleeping lane must be a no-op for the integration kernel
+    StoreLane(game, ball);
+}
+
+// ---------------------- PHYSICS CLOCK ----------------------
+
+// Sets the number of physics steps per second. Per-step motion and
+// friction are rescaled so a shot travels the same path at any rate.
+// Fixed-point builds round the rate to a whole number of steps per
+// 60 Hz frame.
+void SetPhysicsRate(Game *game, int hz) {
+
+    if (hz < MIN_PHYSICS_HZ) hz = MIN_PHYSICS_HZ;
+    if (hz > MAX_PHYSICS_HZ) hz = MAX_PHYSICS_HZ;
+#ifdef SIM_FIXED_POINT
+    hz = (hz + BASE_FRAME_HZ / 2) / BASE_FRAME_HZ * BASE_FRAME_HZ;
+#endif
+
+    game->physicsHz = hz;
+    game->stepScale = (float)BASE_FRAME_HZ / (float)hz;
+    game->stepFriction = powf(FRICTION, game->stepScale);
+
+#ifdef SIM_FIXED_POINT
+    SetFixedStepRate(game);
+#endif
+}
+
+// ---------------------- PHYSICS UPDATE ----------------------
+
+void UpdatePhysics(Game *game) {
+
+    game->stats.pairTests = 0;
+    game->stats.collisionsResolved = 0;
+    game->stats.stepsSkipped = 0;
+
+#ifdef SIM_FIXED_POINT
+    // Same step in integers; the Ball views are refreshed as it goes
+    IntegrateFixed(game);
+#else
+    // A lone ball with a clear path jumps straight to where it stops
+    if (game->fastForward && FastForwardLoneBall(game)) {
+        CheckPockets(game);
+        for (int n = game->awakeCount - 1; n >= 0; n--) {
+            int i = game->awakeList[n];
+            RefileBall(game, i);
+            SleepBall(game, i);
+        }
+        return;
+    }
+
+    PhysicsLanes *lanes = &game->lanes;
+
+    // Load the awake balls into their lanes; collisions and rules work
+    // on the Ball views between steps
+    for (int n = 0; n < game->awakeCount; n++) {
+        int i = game->awakeList[n];
+        lanes->x[i] = game->balls[i].position.x;
+        lanes->y[i] = game->balls[i].position.y;
+        lanes->vx[i] = game->balls[i].velocity.x;
+        lanes->vy[i] = game->balls[i].velocity.y;
+    }
+
+    // Move, apply friction, bounce off rails and limit speed. Running
+    // every lane is cheaper than gathering; sleeping lanes hold zero
+    // velocity inside the rails, so the kernel leaves them untouched.
+    int laneCount = (game->ballCount + 7) / 8 * 8;
+    IntegrateLanes(lanes, laneCount, game->stepScale, game->stepFriction);
+
+    for (int n = 0; n < game->awakeCount; n++) {
+        int i = game->awakeList[n];
+        game->balls[i].position = (Vector2){ lanes->x[i], lanes->y[i] };
+        game->balls[i].velocity = (Vector2){ lanes->vx[i], lanes->vy[i] };
+    }
+#endif
+
+    // Ball-to-ball collision
+    PROFILE_BEGIN(PROFILE_COLLISIONS);
+    CheckCollisions(game);
+    PROFILE_END(PROFILE_COLLISIONS);
+
+    // Check pocketing
+    PROFILE_BEGIN(PROFILE_POCKETS);
+    CheckPockets(game);
+    PROFILE_END(PROFILE_POCKETS);
+
+    // Put balls that stopped or dropped to sleep
+    for (int n = game->awakeCount - 1; n >= 0; n--) {
+        int i = game->awakeList[n];
+        if (game->balls[i].pocketed ||
+            (game->balls[i].velocity.x == 0.0f &&
+             game->balls[i].velocity.y == 0.0f)) {
+            RefileBall(game, i);
+            SleepBall(game, i);
+        }
+    }
+}
+
+// Copies one Ball view into its lane. Sleeping balls get zero velocity
+// and pocketed ones are parked mid-table, away from the rails.
+static void StoreLane(Game *game, int i) {
+
+    bool awake = game->awakeSlot[i] >= 0;
+
+    if (game->balls[i].pocketed) {
+        game->lanes.x[i] = TABLE_WIDTH * 0.5f;
+        game->lanes.y[i] = TABLE_HEIGHT * 0.5f;
+    }
+    else {
+        game->lanes.x[i] = game->balls[i].position.x;
+        game->lanes.y[i] = game->balls[i].position.y;
+    }
+    game->lanes.vx[i] = awake ? game->balls[i].velocity.x : 0.0f;
+    game->lanes.vy[i] = awake ? game->balls[i].velocity.y : 0.0f;
+}
+
+// ---------------------- SIMULATION STEP ----------------------
+
+// Advances the table by one physics frame and runs the end-of-shot
+// rules once every ball has come to rest
+void StepSimulation(Game *game) {
+
+    // Only update physics during play or scratch state
+    if (game->state != GAME_PLAYING &&
+        game->state != GAME_SCRATCH)
+        return;
+
+    PROFILE_BEGIN(PROFILE_PHYSICS);
+    UpdatePhysics(game);
+    PROFILE_END(PROFILE_PHYSICS);
+    PROFILE_COUNT(PROFILE_STEPS, 1);
+    PROFILE_COUNT(PROFILE_PAIR_TESTS, game->stats.pairTests);
+    PROFILE_COUNT(PROFILE_COLLISIONS_RESOLVED, game->stats.collisionsResolved);
+
+    // Detect start of ball movement
+    if (!game->ballsMoving &&
+        AreBallsMoving(game))
+        game->ballsMoving = true;
+
+    // Detect stop of all balls
+    if (game->ballsMoving &&
+        !AreBallsMoving(game))
+        FinishShot(game);
+}
+
+// End-of-shot rules, run once when every ball has come to rest
+void FinishShot(Game *game) {
+
+    game->ballsMoving = false;
+
+    if (game->state == GAME_PLAYING) {
+        CheckWinCondition(game);
+        if (game->state != GAME_WON &&
+            game->state != GAME_LOST) {
+            NextTurn(game);
+        }
+    }
+}
+
+// ---------------------- SHOT ENTRY POINTS ----------------------
+
+// Launches the cue ball; direction must be a unit vector
+void StrikeCueBall(Game *game, Vector2 direction, float speed) {
+
+    if (speed > MAX_SHOT_SPEED)
+        speed = MAX_SHOT_SPEED;
+
+    // Apply velocity to cue ball
+    game->balls[0].velocity.x =
+        direction.x * speed;
+    game->balls[0].velocity.y =
+        direction.y * speed;
+#ifdef SIM_FIXED_POINT
+    LoadFixedVelocity(game, 0);
+#endif
+    WakeBall(game, 0);
+    game->state = GAME_PLAYING;
+    game->firstShot = false;
+}
+
+// Ball-in-hand placement after a scratch. Returns false (and sets the
+// status message) when the position is outside the rails.
+bool PlaceCueBall(Game *game, Vector2 position) {
+
+    if (position.x > RAIL_WIDTH + BALL_RADIUS &&
+        position.x < TABLE_WIDTH - RAIL_WIDTH - BALL_RADIUS &&
+        position.y > RAIL_WIDTH + BALL_RADIUS &&
+        position.y < TABLE_HEIGHT - RAIL_WIDTH - BALL_RADIUS) {
+        game->cueBallPos = position;
+        game->balls[0].position = game->cueBallPos;
+        game->balls[0].pocketed = false;
+        game->balls[0].velocity = (Vector2){0,0};
+        game->previousPositions[0] = position;
+#ifdef SIM_FIXED_POINT
+        LoadFixedBall(game, 0);
+#endif
+
+        // Awake for one step so the grid and pocket check pick it up
+        WakeBall(game, 0);
+        game->state = GAME_PLAYING;
+        sprintf(game->statusMessage, "Cue placed. %s's turn",game->players[game->currentPlayer].name);
+        return true;
+    }
+    strcpy(game->statusMessage, "Invalid position! Place inside rails");
+    return false;
+}
+
+// Stops every ball where it is. A won or lost game is not stepped any
+// more, so a headless shot that ends the game settles the table here.
+static void SettleTable(Game *game) {
+    while (game->awakeCount > 0) {
+        int ball = game->awakeList[game->awakeCount - 1];
+        game->balls[ball].velocity = (Vector2){0, 0};
+#ifdef SIM_FIXED_POINT
+        LoadFixedVelocity(game, ball);
+#endif
+        SleepBall(game, ball);
+    }
+    game->ballsMoving = false;
+}
+
+// Plays one shot headlessly and steps until every ball is at rest.
+// Call it only while the balls are stopped. Returns the number of
+// physics steps the shot lasted, including any a lone ball skipped
+// by fast-forwarding. If the shot wins or loses the game, stepping
+// stops there and the balls still rolling are stopped where they are.
+int SimulateShot(Game *game, Vector2 direction, float speed) {
+
+    StrikeCueBall(game, direction, speed);
+
+    bool fastForward = game->fastForward;
+    game->fastForward = true;
+
+    int steps = 0;
+    do {
+        StepSimulation(game);
+        steps += 1 + game->stats.stepsSkipped;
+    } while (game->ballsMoving && steps < MAX_SIMULATION_STEPS &&
+             (game->state == GAME_PLAYING || game->state == GAME_SCRATCH));
+
+    if (game->state == GAME_WON || game->state == GAME_LOST)
+        SettleTable(game);
+
+    game->fastForward = fastForward;
+    return steps;
+}
+
+// The drag-to-shoot formula: the cue ball travels towards the mouse
+// with speed proportional to how far the stick was pulled. Returns
+// false when the mouse is on top of the cue ball (no direction).
+bool ShotFromDrag(Vector2 cueBallPos, Vector2 mousePos,
+                  float pullPixels, ShotParams *shot) {
+
+    Vector2 dir = {
+        mousePos.x - cueBallPos.x,
+        mousePos.y - cueBallPos.y
+    };
+    float len = sqrtf(dir.x*dir.x + dir.y*dir.y);
+    if (len < 0.001f) return false;
+
+    if (pullPixels > MAX_POWER_PIXELS)
+        pullPixels = MAX_POWER_PIXELS;
+
+    shot->direction = (Vector2){ dir.x / len, dir.y / len };
+    shot->speed = (pullPixels / MAX_POWER_PIXELS) * MAX_SHOT_SPEED;
+    return true;
+}
+
+// Copies where the balls ended up after a headless shot
+void GetShotOutcome(const Game *game, int steps, ShotOutcome *outcome) {
+    for (int i = 0; i < game->ballCount && i < MAX_BALLS; i++) {
+        outcome->positions[i] = game->balls[i].position;
+        outcome->pocketed[i] = game->balls[i].pocketed;
+    }
+    outcome->steps = steps;
+}
+
+// ---------------------- ROLL PREDICTION ----------------------
+//
+// A free ball follows the stepped integrator exactly: each step it
+// moves by v * stepScale, then v *= stepFriction. The axes only meet in
+// the speed clamp, which a decaying ball never reaches, so each axis is
+// a geometric series of its own. After k steps
+//
+//     v_k = v f^k,    x_k = x + s v (1 - f^k) / (1 - f)
+//
+// and an axis stops on the first step where |v f^k| < MIN_VELOCITY. A
+// rail is reached on the first k with x_k past it, which is again a log.
+// Between two such events both axes shrink by the same f^k, so the path
+// is a straight segment; PredictRoll walks from event to event.
+
+#define ROLL_NEVER 0x7fffffff
+
+typedef struct {
+    double position;
+    double velocity;
+    double lo, hi;            // Centre limits set by the rails
+} RollAxis;
+
+// Steps until this axis stops or hits a rail
+static int AxisNextEvent(const RollAxis *axis, double s, double f) {
+
+    double v = axis->velocity;
+    if (v == 0.0) return ROLL_NEVER;
+
+    // First k with |v| f^k < MIN_VELOCITY
+    double lnF = log(f);
+    double k = ceil(log(MIN_VELOCITY / fabs(v)) / lnF);
+    if (k < 1.0) k = 1.0;
+    while (k > 1.0 && fabs(v) * pow(f, k - 1.0) < MIN_VELOCITY) k -= 1.0;
+    while (fabs(v) * pow(f, k) >= MIN_VELOCITY) k += 1.0;
+    int stop = (int)k;
+
+    // First k with the centre past the rail it is heading for
+    double room = v > 0.0 ? axis->hi - axis->position : axis->position - axis->lo;
+    double g = 1.0 - room * (1.0 - f) / (s * fabs(v));
+    if (g <= 0.0) return stop;
+
+    k = room < 0.0 ? 1.0 : floor(log(g) / lnF) + 1.0;
+    if (k < 1.0) k = 1.0;
+    if (k >= stop) return stop;
+    return (int)k;
+}
+
+// Advances an axis by k steps (no further than its next event) and
+// applies the stop and rail rules of the step it lands on
+static void AxisAdvance(RollAxis *axis, int k, double s, double f) {
+
+    if (axis->velocity == 0.0 || k <= 0) return;
+
+    double fk = pow(f, k);
+    axis->position += s * axis->velocity * (1.0 - fk) / (1.0 - f);
+    axis->velocity *= fk;
+
+    if (fabs(axis->velocity) < MIN_VELOCITY) axis->velocity = 0.0;
+
+    if (axis->position < axis->lo) {
+        axis->position = axis->lo;
+        axis->velocity *= -0.86;
+    }
+    if (axis->position > axis->hi) {
+        axis->position = axis->hi;
+        axis->velocity *= -0.86;
+    }
+}
+
+static void InitRollAxes(RollAxis axes[2], Vector2 position, Vector2 velocity) {
+    axes[0] = (RollAxis){ position.x, velocity.x,
+                          RAIL_WIDTH + BALL_RADIUS,
+                          TABLE_WIDTH - RAIL_WIDTH - BALL_RADIUS };
+    axes[1] = (RollAxis){ position.y, velocity.y,
+                          RAIL_WIDTH + BALL_RADIUS,
+                          TABLE_HEIGHT - RAIL_WIDTH - BALL_RADIUS };
+}
+
+// Rolls both axes forward by up to `limit` steps. Returns the steps
+// taken, which is less than limit only if the ball stopped first.
+static int AdvanceRoll(RollAxis axes[2], int limit, double s, double f,
+                       RollPrediction *roll) {
+
+    int taken = 0;
+
+    while (taken < limit) {
+        int kx = AxisNextEvent(&axes[0], s, f);
+        int ky = AxisNextEvent(&axes[1], s, f);
+        int k = kx < ky ? kx : ky;
+        if (k == ROLL_NEVER) break;           // At rest
+        if (k > limit - taken) k = limit - taken;
+
+        AxisAdvance(&axes[0], k, s, f);
+        AxisAdvance(&axes[1], k, s, f);
+        taken += k;
+
+        if (roll != NULL) {
+            if (roll->pointCount < MAX_ROLL_POINTS)
+                roll->points[roll->pointCount++] =
+                    (Vector2){ (float)axes[0].position, (float)axes[1].position };
+            else
+                roll->complete = false;
+        }
+    }
+    return taken;
+}
+
+// Where a ball launched with this velocity comes to rest, and when, at
+// the game's physics rate
+void PredictRoll(const Game *game, Vector2 position, Vector2 velocity,
+                 RollPrediction *roll) {
+
+    RollAxis axes[2];
+    InitRollAxes(axes, position, velocity);
+
+    roll->points[0] = position;
+    roll->pointCount = 1;
+    roll->complete = true;
+
+    int steps = AdvanceRoll(axes, MAX_SIMULATION_STEPS,
+                            game->stepScale, game->stepFriction, roll);
+
+    roll->stopPosition = (Vector2){ (float)axes[0].position, (float)axes[1].position };
+    roll->stopStep = steps;
+    roll->stopTime = (float)steps / game->physicsHz;
+}
+
+// Position of a freely rolling ball `seconds` from now
+Vector2 RollPositionAt(const Game *game, Vector2 position,
+                       Vector2 velocity, float seconds) {
+
+    RollAxis axes[2];
+    InitRollAxes(axes, position, velocity);
+
+    int steps = (int)(seconds * game->physicsHz);
+    AdvanceRoll(axes, steps, game->stepScale, game->stepFriction, NULL);
+    return (Vector2){ (float)axes[0].position, (float)axes[1].position };
+}
+
+// Casts the ball's path, segment by segment, against every other ball
+// grown to twice the radius: the first circle a segment enters is the
+// first ball the moving one would touch, and the entry point is where
+// its centre is at contact (the ghost ball). The equal-mass model of
+// ResolveElasticCollision then gives both directions after the hit.
+// Returns false if the path touches no ball.
+bool PredictContact(const Game *game, int cue, const RollPrediction *roll,
+                    ContactPrediction *contact) {
+
+    float reach = BALL_RADIUS * 2.0f;
+    float travelled = 0.0f;
+    contact->ball = -1;
+
+    for (int p = 1; p < roll->pointCount; p++) {
+        Vector2 a = roll->points[p - 1];
+        float dx = roll->points[p].x - a.x;
+        float dy = roll->points[p].y - a.y;
+        float length = sqrtf(dx*dx + dy*dy);
+        if (length <= 0.0f) continue;
+        dx /= length;
+        dy /= length;
+
+        // Nearest entry along this segment, if any
+        float best = length;
+        for (int j = 0; j < game->ballCount; j++) {
+            if (j == cue || game->balls[j].pocketed) continue;
+
+            float mx = a.x - game->balls[j].position.x;
+            float my = a.y - game->balls[j].position.y;
+            float b = mx*dx + my*dy;
+            float c = mx*mx + my*my - reach*reach;
+            if (c > 0.0f && b > 0.0f) continue;     // Outside and heading away
+            float disc = b*b - c;
+            if (disc < 0.0f) continue;              // Passes wide
+
+            float t = -b - sqrtf(disc);
+            if (t < 0.0f) t = 0.0f;                 // Already touching
+            if (t < best) {
+                best = t;
+                contact->ball = j;
+            }
+        }
+
+        if (contact->ball >= 0) {
+            contact->segment = p - 1;
+            contact->ghost = (Vector2){ a.x + dx*best, a.y + dy*best };
+            contact->distance = travelled + best;
+
+            Ball moving = { .position = contact->ghost, .velocity = { dx, dy } };
+            Ball object = { .position = game->balls[contact->ball].position };
+            ResolveElasticCollision(&moving, &object);
+            contact->cueAfter = moving.velocity;
+            contact->objectAfter = object.velocity;
+            return true;
+        }
+        travelled += length;
+    }
+    return false;
+}
+
+#ifndef SIM_FIXED_POINT
+
+// Distance from p to the segment a-b
+static float SegmentDistance(Vector2 p, Vector2 a, Vector2 b) {
+    float abx = b.x - a.x, aby = b.y - a.y;
+    float lenSq = abx*abx + aby*aby;
+    float t = lenSq > 0.0f ? ((p.x - a.x)*abx + (p.y - a.y)*aby) / lenSq : 0.0f;
+    if (t < 0.0f) t = 0.0f;
+    if (t > 1.0f) t = 1.0f;
+    return Distance(p, (Vector2){ a.x + abx*t, a.y + aby*t });
+}
+
+// Keeps the fast-forward well clear of anything the stepped path could
+// touch despite rounding
+#define ROLL_CLEARANCE 1.0f
+
+// If exactly one ball is rolling and its predicted path stays clear of
+// every other ball and every pocket, moves it to its rest point. The
+// steps jumped over are reported in stats.stepsSkipped.
+static bool FastForwardLoneBall(Game *game) {
+
+    static const Vector2 pockets[] = {
+        {RAIL_WIDTH, RAIL_WIDTH},
+        {TABLE_WIDTH*0.5f, RAIL_WIDTH},
+        {TABLE_WIDTH - RAIL_WIDTH, RAIL_WIDTH},
+        {RAIL_WIDTH, TABLE_HEIGHT - RAIL_WIDTH},
+        {TABLE_WIDTH*0.5f, TABLE_HEIGHT - RAIL_WIDTH},
+        {TABLE_WIDTH - RAIL_WIDTH, TABLE_HEIGHT - RAIL_WIDTH}
+    };
+
+    if (game->awakeCount != 1) return false;
+    int i = game->awakeList[0];
+    Ball *ball = &game->balls[i];
+    if (ball->pocketed) return false;
+
+    RollPrediction roll;
+    PredictRoll(game, ball->position, ball->velocity, &roll);
+    if (!roll.complete || roll.stopStep <= 1) return false;
+
+    for (int p = 1; p < roll.pointCount; p++) {
+        Vector2 a = roll.points[p - 1], b = roll.points[p];
+
+        for (int q = 0; q < 6; q++) {
+            if (SegmentDistance(pockets[q], a, b) < POCKET_RADIUS + ROLL_CLEARANCE)
+                return false;
+        }
+        for (int j = 0; j < game->ballCount; j++) {
+            if (j == i || game->balls[j].pocketed) continue;
+            if (SegmentDistance(game->balls[j].position, a, b) <
+                BALL_RADIUS * 2.0f + ROLL_CLEARANCE)
+                return false;
+        }
+    }
+
+    ball->position = roll.stopPosition;
+    ball->velocity = (Vector2){0, 0};
+    game->stats.stepsSkipped = roll.stopStep - 1;
+    return true;
+}
+
+#endif // SIM_FIXED_POINT
+
+// ---------------------- BROADPHASE GRID ----------------------
+
+// Grid cell containing a position (clamped to the table)
+static int GridCellFor(Vector2 position) {
+    int col = (int)(position.x / GRID_CELL_SIZE);
+    int row = (int)(position.y / GRID_CELL_SIZE);
+    if (col < 0) col = 0;
+    if (col >= GRID_COLS) col = GRID_COLS - 1;
+    if (row < 0) row = 0;
+    if (row >= GRID_ROWS) row = GRID_ROWS - 1;
+    return row * GRID_COLS + col;
+}
+
+// Moves a ball to the list of its current cell if it has left the old
+// one; pocketed balls are taken off the grid entirely
+static void RefileBall(Game *game, int ball) {
+
+    BallGrid *grid = &game->grid;
+    int cell = game->balls[ball].pocketed ?
+        -1 : GridCellFor(game->balls[ball].position);
+    int oldCell = grid->ballCell[ball];
+    if (cell == oldCell) return;
+
+    // Unlink from the old cell
+    if (oldCell >= 0) {
+        int prev = grid->prevInCell[ball];
+        int next = grid->nextInCell[ball];
+        if (prev >= 0) grid->nextInCell[prev] = next;
+        else grid->cellHead[oldCell] = next;
+        if (next >= 0) grid->prevInCell[next] = prev;
+    }
+
+    // Push onto the front of the new cell
+    grid->ballCell[ball] = cell;
+    if (cell >= 0) {
+        int head = grid->cellHead[cell];
+        grid->prevInCell[ball] = -1;
+        grid->nextInCell[ball] = head;
+        if (head >= 0) grid->prevInCell[head] = ball;
+        grid->cellHead[cell] = ball;
+    }
+}
+
+// Files every ball from scratch (after a reset or a ball count change)
+void RebuildBallGrid(Game *game) {
+
+    for (int c = 0; c < GRID_CELLS; c++)
+        game->grid.cellHead[c] = -1;
+    for (int i = 0; i < MAX_TABLE_BALLS; i++)
+        game->grid.ballCell[i] = -1;
+
+    for (int i = 0; i < game->ballCount; i++)
+        RefileBall(game, i);
+}
+
+// Re-files the awake balls that changed cell since the last update;
+// sleeping balls cannot have moved
+void UpdateBallGrid(Game *game) {
+    for (int n = 0; n < game->awakeCount; n++)
+        RefileBall(game, game->awakeList[n]);
+}
+
+// ---------------------- BALL-TO-BALL COLLISION ----------------------
+
+// Tests one pair and resolves it if the balls overlap. Squared distances
+// reject the pair before any sqrt is taken.
+static bool ResolveBallPair(Game *game, int i, int j) {
+
+#ifdef SIM_FIXED_POINT
+    return ResolveBallPairFixed(game, i, j);
+#endif
+
+    float dx = game->balls[j].position.x - game->balls[i].position.x;
+    float dy = game->balls[j].position.y - game->balls[i].position.y;
+    float distSq = dx*dx + dy*dy;
+    float minDist = BALL_RADIUS * 2.0f;
+
+    game->stats.pairTests++;
+
+    // If balls overlap → collision occurred
+    if (distSq >= minDist*minDist || distSq <= 0.0001f*0.0001f)
+        return false;
+
+    // Calculate distance between ball centers
+    float dist = sqrtf(distSq);
+
+    // Calculate overlap amount
+    float overlap = 0.5f * (minDist - dist + 0.001f);
+
+    // Normal direction between balls
+    Vector2 normal = { dx / dist, dy / dist };
+
+    // Push balls apart equally
+    game->balls[i].position.x -= normal.x * overlap;
+    game->balls[i].position.y -= normal.y * overlap;
+    game->balls[j].position.x += normal.x * overlap;
+    game->balls[j].position.y += normal.y * overlap;
+
+    // Apply elastic collision physics
+    ResolveElasticCollision(
+        &game->balls[i],
+        &game->balls[j]);
+
+    // Clamp speeds to avoid unrealistic speed
+    ClampBallSpeed(&game->balls[i],
+                   MAX_BALL_SPEED);
+    ClampBallSpeed(&game->balls[j],
+                   MAX_BALL_SPEED);
+
+    // A struck ball joins the awake set; if it ends up with no speed
+    // it goes straight back to sleep at the end of the step
+    WakeBall(game, i);
+    WakeBall(game, j);
+
+    game->stats.collisionsResolved++;
+    return true;
+}
+
+void CheckCollisions(Game *game) {
+
+    BallGrid *grid = &game->grid;
+    short candidates[MAX_TABLE_BALLS];
+
+    UpdateBallGrid(game);
+
+    // Every pair with at least one awake ball. Balls woken by a hit are
+    // appended to the list and get their own pass in the same loop.
+    for (int n = 0; n < game->awakeCount; n++) {
+        int i = game->awakeList[n];
+        int cell = grid->ballCell[i];
+        if (cell < 0) continue;   // Pocketed
+
+        // Gather neighbours from the 3x3 block of cells around ball i;
+        // only those can be touching it. An awake pair is taken once,
+        // from its lower-numbered ball.
+        int count = 0;
+        int col = cell % GRID_COLS;
+        int row = cell / GRID_COLS;
+        for (int r = row - 1; r <= row + 1; r++) {
+            if (r < 0 || r >= GRID_ROWS) continue;
+            for (int c = col - 1; c <= col + 1; c++) {
+                if (c < 0 || c >= GRID_COLS) continue;
+                for (int j = grid->cellHead[r * GRID_COLS + c];
+                     j >= 0; j = grid->nextInCell[j]) {
+                    if (j != i && (game->awakeSlot[j] < 0 || j > i))
+                        candidates[count++] = (short)j;
+                }
+            }
+        }
+
+        // Resolved pairs are pushed apart, so re-file them right away
+        for (int k = 0; k < count; k++) {
+            int j = candidates[k];
+            if (ResolveBallPair(game, i, j)) {
+                TRACE_INSTANT("collision", i, j);
+                RefileBall(game, i);
+                RefileBall(game, j);
+            }
+        }
+    }
+}
+
+// Reference O(n^2) version kept for benchmarking the broadphase
+void CheckCollisionsBruteForce(Game *game) {
+
+    // Compare each ball with every other ball
+    for (int i = 0; i < game->ballCount; i++) {
+        if (game->balls[i].pocketed) continue;
+        for (int j = i+1; j < game->ballCount; j++) {
+            if (game->balls[j].pocketed) continue;
+            ResolveBallPair(game, i, j);
+        }
+    }
+}
+
+void ResolveElasticCollision(Ball *a, Ball *b) {
+
+    // Compute normal vector
+    float dx = b->position.x - a->position.x;
+    float dy = b->position.y - a->position.y;
+    float dist = sqrtf(dx*dx + dy*dy);
+    if (dist <= 0.0001f) return;
+    float nx = dx / dist;
+    float ny = dy / dist;
+
+    // Tangent vector
+    float tx = -ny;
+    float ty = nx;
+
+    // Project velocities onto normal and tangent
+
+    float va_n = a->velocity.x * nx +
+                 a->velocity.y * ny;
+    float va_t = a->velocity.x * tx +
+                 a->velocity.y * ty;
+    float vb_n = b->velocity.x * nx +
+                 b->velocity.y * ny;
+    float vb_t = b->velocity.x * tx +
+                 b->velocity.y * ty;
+
+    // Equal mass elastic collision:
+    // Swap normal components
+
+    float va_n_after = vb_n;
+    float vb_n_after = va_n;
+
+    // Convert back to vector form
+
+    a->velocity.x = va_n_after * nx +
+                    va_t * tx;
+    a->velocity.y = va_n_after * ny +
+                    va_t * ty;
+    b->velocity.x = vb_n_after * nx +
+                    vb_t * tx;
+    b->velocity.y = vb_n_after * ny +
+                    vb_t * ty;
+}
+
+void CheckPockets(Game *game) {
+
+    // Define 6 pocket positions
+
+    Vector2 pockets[] = {
+        {RAIL_WIDTH, RAIL_WIDTH},
+        {TABLE_WIDTH*0.5f, RAIL_WIDTH},
+        {TABLE_WIDTH - RAIL_WIDTH, RAIL_WIDTH},
+        {RAIL_WIDTH, TABLE_HEIGHT - RAIL_WIDTH},
+        {TABLE_WIDTH*0.5f, TABLE_HEIGHT - RAIL_WIDTH},
+        {TABLE_WIDTH - RAIL_WIDTH, TABLE_HEIGHT - RAIL_WIDTH}
+    };
+    bool cueBallPocketed = false;
+    bool anyPocketed = false;
+
+    // A resting ball cannot roll into a pocket, so only awake ones count
+    for (int n = 0; n < game->awakeCount; n++) {
+        int i = game->awakeList[n];
+        if (game->balls[i].pocketed) continue;
+        for (int p = 0; p < 6; p++) {
+
+            // If ball center inside pocket radius
+
+            if (BallInPocket(game, i, pockets[p])) {
+                game->balls[i].pocketed = true;
+                game->balls[i].velocity = (Vector2){0,0};
+                TRACE_INSTANT("pocket", i, p);
+#ifdef SIM_FIXED_POINT
+                game->fixed.vx[i] = 0;
+                game->fixed.vy[i] = 0;
+#endif
+                anyPocketed = true;
+                // Cue ball scratch
+
+                if (i == 0) {
+                    cueBallPocketed = true;
+                    game->cueBallPos = (Vector2){ TABLE_WIDTH * 0.25f, TABLE_HEIGHT * 0.5f };
+                }
+                else {
+                    // 8-ball logic
+                    if (game->balls[i].type == BALL_EIGHT) {
+                        int myIdx = game->currentPlayer;
+                        if ((game->players[myIdx].type
+                             == PLAYER_SOLIDS &&
+                             game->players[myIdx].ballsRemaining == 0)
+                            ||
+                            (game->players[myIdx].type
+                             == PLAYER_STRIPES &&
+                             game->players[myIdx].ballsRemaining == 0)) {
+
+                            game->state = GAME_WON;
+                        }
+                        else {
+                            game->state = GAME_LOST;
+                        }
+                        TRACE_INSTANT("game over", game->state, -1);
+                        return;
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    if (cueBallPocketed)
+        ApplyScratch(game);
+
+    if (anyPocketed) {
+        sprintf(game->statusMessage,
+            "%s pocketed a ball!",
+            game->players[game->currentPlayer].name);
+    }
+}
+
+// Ball centre inside the pocket radius
+static bool BallInPocket(const Game *game, int ball, Vector2 pocket) {
+#ifdef SIM_FIXED_POINT
+    return BallInPocketFixed(game, ball, pocket);
+#else
+    return Distance(game->balls[ball].position, pocket) < POCKET_RADIUS;
+#endif
+}
+
+void ApplyScratch(Game *game) {
+    game->state = GAME_SCRATCH;
+    strcpy(game->statusMessage,
+           "Scratch! Place cue ball");
+
+    // Switch turn to opponent
+    game->currentPlayer =
+        1 - game->currentPlayer;
+    TRACE_INSTANT("scratch", game->currentPlayer, -1);
+}
+
+void CheckWinCondition(Game *game) {
+    int idx = game->currentPlayer;
+    if ((game->players[idx].type ==
+         PLAYER_SOLIDS &&
+         game->players[idx].ballsRemaining == 0)
+        ||
+        (game->players[idx].type ==
+         PLAYER_STRIPES &&
+         game->players[idx].ballsRemaining == 0)) {
+        strcpy(game->statusMessage,"Shoot the 8-ball!");
+    }
+}
+
+void NextTurn(Game *game) {
+
+    // Switch player
+    game->currentPlayer =
+        1 - game->currentPlayer;
+    sprintf(game->statusMessage,
+        "%s's turn",game->players[game->currentPlayer].name);
+    TRACE_INSTANT("next turn", game->currentPlayer, -1);
+}
+
+// Balls leave the awake set as soon as they stop, so its size answers
+// this without scanning the table
+bool AreBallsMoving(Game *game) {
+    return game->awakeCount > 0;
+}
+
+float Distance(Vector2 a, Vector2 b) {
+    float dx = a.x - b.x;
+    float dy = a.y - b.y;
+    return sqrtf(dx*dx + dy*dy);
+}
+
+void ClampBallSpeed(Ball *b,float maxSpeed) {
+    float sx = b->velocity.x;
+    float sy = b->velocity.y;
+    float mag = sqrtf(sx*sx + sy*sy);
+    if (mag > maxSpeed) {
+        b->velocity.x =
+            (b->velocity.x / mag)* maxSpeed;
+        b->velocity.y =(b->velocity.y / mag) * maxSpeed;
+    }
+}
+
+//----------------- Returns the index of the player assigned to the given ball type------------
+int playerIndexForType(const Game *game, BallType btype) {
+    if (btype == BALL_SOLID) {
+        if (game->players[0].type == PLAYER_SOLIDS)
+            return 0;
+        if (game->players[1].type == PLAYER_SOLIDS)
+            return 1;
+    }
+    if (btype == BALL_STRIPE) {
+        if (game->players[0].type == PLAYER_STRIPES)
+            return 0;
+        if (game->players[1].type == PLAYER_STRIPES)
+            return 1;
+    }
+    return -1;  // Not assigned
+}
@@ -0,0 +1,305 @@
+#ifndef POOL_SIM_H
+#define POOL_SIM_H
+
+// Headless 8-ball simulation core: table state, physics and rules.
+// Nothing in here depends on raylib, so it can be linked into tools
+// that never open a window.
+
+#include <stdbool.h>     // For bool type
+
+#ifdef SIM_FIXED_POINT
+#include <stdint.h>      // For int32_t, uint32_t, uint64_t
+#endif
+
+// ---------------------- CONSTANT DEFINITIONS ----------------------
+
+#define MAX_BALLS 16              // Total balls including cue ball
+#define TABLE_WIDTH 800           // Table width
+#define TABLE_HEIGHT 400          // Table height
+#define BALL_RADIUS 15            // Radius of each ball
+#define POCKET_RADIUS 28          // Radius of pocket
+#define RAIL_WIDTH 40             // Thickness of table rail
+
+// Physics tuning parameters
+#define FRICTION 0.985f           // Friction multiplier per frame
+#define MIN_VELOCITY 0.06f        // Minimum velocity threshold to stop ball
+#define MAX_POWER_PIXELS 160.0f   // Maximum drag distance for power
+#define MAX_SHOT_SPEED 22.0f      // Maximum initial shot speed
+#define MAX_BALL_SPEED 26.0f      // Maximum speed any ball can have
+
+// Fixed-step physics clock. Velocities stay in pixels per 60 Hz frame;
+// each step advances stepScale of such a frame.
+#ifndef PHYSICS_HZ
+#define PHYSICS_HZ 240            // Default physics steps per second
+#endif
+#define BASE_FRAME_HZ 60          // Rate the tuning constants assume
+#define MIN_PHYSICS_HZ 60
+#define MAX_PHYSICS_HZ 1920
+
+#define MAX_SIMULATION_STEPS 80000   // Safety cap for SimulateShot
+#define MAX_ROLL_POINTS 16        // Path corners kept by PredictRoll
+
+// Capacity of the ball arrays. A normal game uses MAX_BALLS; tools that
+// stress the physics with denser synthetic tables can raise it with
+// -DMAX_TABLE_BALLS=1024.
+#ifndef MAX_TABLE_BALLS
+#define MAX_TABLE_BALLS MAX_BALLS
+#endif
+
+// Structure-of-arrays lanes are padded to a whole number of 8-wide
+// (AVX) vectors
+#define PHYSICS_LANES (((MAX_TABLE_BALLS) + 7) / 8 * 8)
+
+// Broadphase grid: one cell per ball diameter, so touching balls are
+// always in the same or a neighbouring cell
+#define GRID_CELL_SIZE (BALL_RADIUS * 2)
+#define GRID_COLS (TABLE_WIDTH / GRID_CELL_SIZE + 1)
+#define GRID_ROWS (TABLE_HEIGHT / GRID_CELL_SIZE + 1)
+#define GRID_CELLS (GRID_COLS * GRID_ROWS)
+
+// ---------------------- FIXED-POINT MODE ----------------------
+//
+// Building with -DSIM_FIXED_POINT runs the stepped physics (integration,
+// collisions, pockets) in Q16.16 integers so every x86-64 build of the
+// same inputs ends in the same bits. The float Ball fields then become a
+// view refreshed from the integer state (see pool_fixed.c).
+
+#ifdef SIM_FIXED_POINT
+typedef int32_t Fixed;            // Q16.16
+
+#define FIXED_ONE 65536
+#define FIXED_FROM_CONST(v) ((Fixed)((v) * 65536.0 + 0.5))
+
+// Integer physics state; the Ball fields are a view of it
+typedef struct {
+    Fixed x[MAX_TABLE_BALLS];
+    Fixed y[MAX_TABLE_BALLS];
+    Fixed vx[MAX_TABLE_BALLS];    // Pixels per 60 Hz frame
+    Fixed vy[MAX_TABLE_BALLS];
+    int stepsPerFrame;            // physicsHz / BASE_FRAME_HZ
+    uint32_t stepFriction;        // FRICTION per step, Q0.32
+} FixedState;
+#endif
+
+// ---------------------- VECTOR TYPE ----------------------
+
+// Same layout as raylib's Vector2; the guard lets both headers coexist
+#if !defined(RL_VECTOR2_TYPE)
+typedef struct Vector2 {
+    float x;
+    float y;
+} Vector2;
+#define RL_VECTOR2_TYPE
+#endif
+
+// ---------------------- ENUM TYPES ----------------------
+
+// Ball type classification
+typedef enum {
+    BALL_CUE,      // White cue ball
+    BALL_SOLID,    // Solid balls (1-7)
+    BALL_STRIPE,   // Stripe balls (9-15)
+    BALL_EIGHT     // Black 8-ball
+} BallType;
+
+// Game state tracking
+typedef enum {
+    GAME_START,
+    GAME_PLAYING,
+    GAME_SCRATCH,
+    GAME_WON,
+    GAME_LOST
+} GameState;
+
+// Player assigned type
+typedef enum {
+    PLAYER_NONE,
+    PLAYER_SOLIDS,
+    PLAYER_STRIPES
+} PlayerType;
+
+// ---------------------- STRUCT DEFINITIONS ----------------------
+
+// Ball structure (colour is a rendering concern, see BallColor)
+typedef struct {
+    Vector2 position;     // Current position
+    Vector2 velocity;     // Current velocity
+    BallType type;        // Ball type
+    int number;           // Ball number
+    bool pocketed;        // Is ball inside pocket
+    bool isStriped;       // Stripe flag
+} Ball;
+
+// Player structure
+typedef struct {
+    PlayerType type;      // Assigned type
+    int ballsRemaining;   // Balls left to clear
+    char name[20];        // Player name
+    bool computer;        // Shots chosen by the AI (pool_ai.c)
+} Player;
+
+// Integrator state in structure-of-arrays form, one lane per ball.
+// The Ball structs stay the view used by collisions, rules and drawing;
+// UpdatePhysics copies awake balls in and out around the kernel.
+typedef struct {
+    _Alignas(32) float x[PHYSICS_LANES];
+    _Alignas(32) float y[PHYSICS_LANES];
+    _Alignas(32) float vx[PHYSICS_LANES];
+    _Alignas(32) float vy[PHYSICS_LANES];
+} PhysicsLanes;
+
+// Uniform grid of per-cell ball lists, kept up to date as balls move
+typedef struct {
+    short cellHead[GRID_CELLS];           // First ball in each cell, -1 if empty
+    short ballCell[MAX_TABLE_BALLS];      // Cell each ball is filed in, -1 if none
+    short nextInCell[MAX_TABLE_BALLS];    // Links of the per-cell lists
+    short prevInCell[MAX_TABLE_BALLS];
+} BallGrid;
+
+// Per-step physics counters
+typedef struct {
+    int pairTests;                // Ball pairs distance-tested
+    int collisionsResolved;       // Pairs that actually collided
+    int stepsSkipped;             // Steps a fast-forward jumped over
+} SimStats;
+
+// Closed-form free roll of one ball: friction, per-axis stops and rail
+// bounces, ignoring other balls and pockets
+typedef struct {
+    Vector2 points[MAX_ROLL_POINTS];  // Start, each bounce or axis stop, rest
+    int pointCount;
+    bool complete;                // False if the path had more corners
+    Vector2 stopPosition;         // Where the ball comes to rest
+    int stopStep;                 // Physics steps until it is at rest
+    float stopTime;               // The same in seconds
+} RollPrediction;
+
+// First object ball on a predicted roll: the ghost-ball aim preview
+typedef struct {
+    int ball;                     // Ball hit first, -1 if none
+    int segment;                  // Contact lies on points[segment] to [segment + 1]
+    Vector2 ghost;                // Cue ball centre at contact
+    float distance;               // Path length to contact
+    Vector2 cueAfter;             // Velocities just after contact, per unit
+    Vector2 objectAfter;          // of cue ball speed just before it
+} ContactPrediction;
+
+// Candidate cue shot
+typedef struct {
+    Vector2 direction;   // Unit vector
+    float speed;         // Clamped to MAX_SHOT_SPEED when played
+} ShotParams;
+
+// Where a table came to rest
+typedef struct {
+    Vector2 positions[MAX_BALLS];   // Final positions (entry point if pocketed)
+    bool pocketed[MAX_BALLS];       // Pocketed during the shot or before
+    int steps;                      // Physics steps until every ball stopped
+} ShotOutcome;
+
+// Main Game structure
+typedef struct {
+    Ball balls[MAX_TABLE_BALLS];  // All balls
+    int ballCount;                // Balls in use (MAX_BALLS in a real game)
+    Player players[2];            // Two players
+    int currentPlayer;            // Whose turn
+    GameState state;              // Current state
+
+    Vector2 cueBallPos;           // Cue ball respawn position
+    float power;                  // Current shot power
+    bool aiming;                  // Is player dragging
+    bool ballsMoving;             // Are balls in motion
+    bool firstShot;               // Break shot flag
+    bool assignedTypes;           // Are solids/stripes assigned
+
+    char statusMessage[100];      // UI message
+
+    // Cue stick mechanics
+    Vector2 dragStart;
+    float stickPullPixels;
+    float stickLength;
+    bool stickRecoil;
+    float recoilTimer;
+
+    // Fixed-step physics clock
+    int physicsHz;                // Physics steps per second
+    float stepScale;              // Fraction of a 60 Hz frame per step
+    float stepFriction;           // FRICTION rescaled to one step
+    float accumulator;            // Frame time not yet simulated (seconds)
+    bool fastForward;             // Headless only: jump a lone ball to rest
+    Vector2 previousPositions[MAX_TABLE_BALLS]; // Positions before the last step
+
+    // SoA copy of positions and velocities for the integration kernel
+    PhysicsLanes lanes;
+
+    // Collision broadphase
+    BallGrid grid;
+    SimStats stats;
+
+    // Balls in motion. Resting balls sleep and are skipped by the
+    // integrator, the collision pass and the pocket check.
+    short awakeList[MAX_TABLE_BALLS];     // Indices of awake balls
+    short awakeSlot[MAX_TABLE_BALLS];     // Position in awakeList, -1 if asleep
+    int awakeCount;                       // Cached "any ball moving" counter
+
+#ifdef SIM_FIXED_POINT
+    FixedState fixed;             // Authoritative positions and velocities
+#endif
+} Game;
+
+// ---------------------- FUNCTION PROTOTYPES ----------------------
+
+void InitGame(Game *game);
+void ResetBalls(Game *game);
+void SetPhysicsRate(Game *game, int hz);
+void StepSimulation(Game *game);
+void FinishShot(Game *game);
+void StrikeCueBall(Game *game, Vector2 direction, float speed);
+bool PlaceCueBall(Game *game, Vector2 position);
+int SimulateShot(Game *game, Vector2 direction, float speed);
+bool ShotFromDrag(Vector2 cueBallPos, Vector2 mousePos,
+                  float pullPixels, ShotParams *shot);
+void GetShotOutcome(const Game *game, int steps, ShotOutcome *outcome);
+void PredictRoll(const Game *game, Vector2 position, Vector2 velocity,
+                 RollPrediction *roll);
+Vector2 RollPositionAt(const Game *game, Vector2 position,
+                       Vector2 velocity, float seconds);
+bool PredictContact(const Game *game, int cue, const RollPrediction *roll,
+                    ContactPrediction *contact);
+void UpdatePhysics(Game *game);
+void IntegrateLanes(PhysicsLanes *lanes, int laneCount,
+                    float stepScale, float stepFriction);
+void IntegrateBallArrays(float *x, float *y, float *vx, float *vy,
+                         int count, float stepScale, float stepFriction);
+void CheckCollisions(Game *game);
+void CheckCollisionsBruteForce(Game *game);
+void RebuildBallGrid(Game *game);
+void UpdateBallGrid(Game *game);
+void RebuildTableState(Game *game);
+void WakeBall(Game *game, int ball);
+void SleepBall(Game *game, int ball);
+void CheckPockets(Game *game);
+void CheckWinCondition(Game *game);
+void NextTurn(Game *game);
+void ApplyScratch(Game *game);
+bool AreBallsMoving(Game *game);
+float Distance(Vector2 a, Vector2 b);
+int playerIndexForType(const Game *game, BallType btype);
+void ResolveElasticCollision(Ball *a, Ball *b);
+void ClampBallSpeed(Ball *b, float maxSpeed);
+
+#ifdef SIM_FIXED_POINT
+void SetFixedStepRate(Game *game);
+void LoadFixedBall(Game *game, int ball);
+void LoadFixedVelocity(Game *game, int ball);
+void SyncBallView(Game *game, int ball);
+void IntegrateFixed(Game *game);
+bool ResolveBallPairFixed(Game *game, int i, int j);
+bool BallInPocketFixed(const Game *game, int ball, Vector2 pocket);
+void StrikeCueBallFixed(Game *game, Fixed vx, Fixed vy);
+float FixedToFloat(Fixed v);
+Fixed FixedFromFloat(float v);
+uint64_t HashFixedState(const Game *game, uint64_t hash);
+#endif
+
+#endif // POOL_SIM_H
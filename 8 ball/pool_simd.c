@@ -0,0 +1,260 @@
+// Integration kernel over the structure-of-arrays ball lanes.
+//
+// Each lane gets exactly the per-ball update UpdatePhysics used to do:
+// move, apply friction, snap tiny velocities to zero, bounce off the
+// rails and clamp the speed. The vector width follows the build flags:
+// AVX (-mavx2 / -march=native) does 8 lanes at a time, SSE2 (every
+// x86-64 build) does 4, anything else falls back to plain C.
+
+#include "pool_sim.h"
+#include <math.h>        // For sqrtf, fabsf
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define RAIL_BOUNCE -0.86f        // Velocity kept (and flipped) on a rail hit
+
+// ---------------------- SCALAR KERNEL ----------------------
+
+#if !defined(__AVX__) && !defined(__SSE2__)
+
+static void IntegrateScalar(float *x, float *y, float *vx, float *vy,
+                            int count, float stepScale, float stepFriction) {
+
+    for (int i = 0; i < count; i++) {
+
+        // Update position
+        x[i] += vx[i] * stepScale;
+        y[i] += vy[i] * stepScale;
+
+        // Apply friction
+        vx[i] *= stepFriction;
+        vy[i] *= stepFriction;
+
+        // Stop tiny velocities
+        if (fabsf(vx[i]) < MIN_VELOCITY) vx[i] = 0;
+        if (fabsf(vy[i]) < MIN_VELOCITY) vy[i] = 0;
+
+        // Rail collision (bounce effect)
+        if (x[i] - BALL_RADIUS < RAIL_WIDTH) {
+            x[i] = RAIL_WIDTH + BALL_RADIUS;
+            vx[i] *= RAIL_BOUNCE;
+        }
+        if (x[i] + BALL_RADIUS > TABLE_WIDTH - RAIL_WIDTH) {
+            x[i] = TABLE_WIDTH - RAIL_WIDTH - BALL_RADIUS;
+            vx[i] *= RAIL_BOUNCE;
+        }
+        if (y[i] - BALL_RADIUS < RAIL_WIDTH) {
+            y[i] = RAIL_WIDTH + BALL_RADIUS;
+            vy[i] *= RAIL_BOUNCE;
+        }
+        if (y[i] + BALL_RADIUS > TABLE_HEIGHT - RAIL_WIDTH) {
+            y[i] = TABLE_HEIGHT - RAIL_WIDTH - BALL_RADIUS;
+            vy[i] *= RAIL_BOUNCE;
+        }
+
+        // Limit maximum speed
+        float magSq = vx[i]*vx[i] + vy[i]*vy[i];
+        if (magSq > MAX_BALL_SPEED * MAX_BALL_SPEED) {
+            float mag = sqrtf(magSq);
+            vx[i] = (vx[i] / mag) * MAX_BALL_SPEED;
+            vy[i] = (vy[i] / mag) * MAX_BALL_SPEED;
+        }
+    }
+}
+
+#endif
+
+// ---------------------- AVX KERNEL ----------------------
+
+#if defined(__AVX__)
+
+#define LANE_WIDTH 8
+
+static void IntegrateVector(float *xs, float *ys, float *vxs, float *vys,
+                            int count, float stepScale, float stepFriction) {
+
+    const __m256 scale = _mm256_set1_ps(stepScale);
+    const __m256 friction = _mm256_set1_ps(stepFriction);
+    const __m256 minVelocity = _mm256_set1_ps(MIN_VELOCITY);
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    const __m256 bounce = _mm256_set1_ps(RAIL_BOUNCE);
+    const __m256 radius = _mm256_set1_ps(BALL_RADIUS);
+    const __m256 nearRail = _mm256_set1_ps(RAIL_WIDTH);
+    const __m256 farRailX = _mm256_set1_ps(TABLE_WIDTH - RAIL_WIDTH);
+    const __m256 farRailY = _mm256_set1_ps(TABLE_HEIGHT - RAIL_WIDTH);
+    const __m256 minPos = _mm256_set1_ps(RAIL_WIDTH + BALL_RADIUS);
+    const __m256 maxPosX = _mm256_set1_ps(TABLE_WIDTH - RAIL_WIDTH - BALL_RADIUS);
+    const __m256 maxPosY = _mm256_set1_ps(TABLE_HEIGHT - RAIL_WIDTH - BALL_RADIUS);
+    const __m256 maxSpeed = _mm256_set1_ps(MAX_BALL_SPEED);
+    const __m256 maxSpeedSq = _mm256_set1_ps(MAX_BALL_SPEED * MAX_BALL_SPEED);
+    const __m256 zero = _mm256_setzero_ps();
+
+    // Unaligned loads cost nothing on aligned data and keep a malloc'd
+    // Game (16-byte aligned) safe
+    for (int i = 0; i < count; i += LANE_WIDTH) {
+        __m256 vx = _mm256_loadu_ps(vxs + i);
+        __m256 vy = _mm256_loadu_ps(vys + i);
+        __m256 hit;
+
+        // A block of resting balls is a no-op; skip it
+        hit = _mm256_or_ps(_mm256_cmp_ps(vx, zero, _CMP_NEQ_OQ),
+                           _mm256_cmp_ps(vy, zero, _CMP_NEQ_OQ));
+        if (!_mm256_movemask_ps(hit)) continue;
+
+        __m256 x = _mm256_loadu_ps(xs + i);
+        __m256 y = _mm256_loadu_ps(ys + i);
+
+        // Update position and apply friction
+        x = _mm256_add_ps(x, _mm256_mul_ps(vx, scale));
+        y = _mm256_add_ps(y, _mm256_mul_ps(vy, scale));
+        vx = _mm256_mul_ps(vx, friction);
+        vy = _mm256_mul_ps(vy, friction);
+
+        // Stop tiny velocities
+        hit = _mm256_cmp_ps(_mm256_andnot_ps(signBit, vx), minVelocity, _CMP_LT_OQ);
+        vx = _mm256_andnot_ps(hit, vx);
+        hit = _mm256_cmp_ps(_mm256_andnot_ps(signBit, vy), minVelocity, _CMP_LT_OQ);
+        vy = _mm256_andnot_ps(hit, vy);
+
+        // Rail collision (bounce effect)
+        hit = _mm256_cmp_ps(_mm256_sub_ps(x, radius), nearRail, _CMP_LT_OQ);
+        x = _mm256_blendv_ps(x, minPos, hit);
+        vx = _mm256_blendv_ps(vx, _mm256_mul_ps(vx, bounce), hit);
+        hit = _mm256_cmp_ps(_mm256_add_ps(x, radius), farRailX, _CMP_GT_OQ);
+        x = _mm256_blendv_ps(x, maxPosX, hit);
+        vx = _mm256_blendv_ps(vx, _mm256_mul_ps(vx, bounce), hit);
+        hit = _mm256_cmp_ps(_mm256_sub_ps(y, radius), nearRail, _CMP_LT_OQ);
+        y = _mm256_blendv_ps(y, minPos, hit);
+        vy = _mm256_blendv_ps(vy, _mm256_mul_ps(vy, bounce), hit);
+        hit = _mm256_cmp_ps(_mm256_add_ps(y, radius), farRailY, _CMP_GT_OQ);
+        y = _mm256_blendv_ps(y, maxPosY, hit);
+        vy = _mm256_blendv_ps(vy, _mm256_mul_ps(vy, bounce), hit);
+
+        // Limit maximum speed (sqrt and divide only when a lane needs it)
+        __m256 magSq = _mm256_add_ps(_mm256_mul_ps(vx, vx),
+                                     _mm256_mul_ps(vy, vy));
+        hit = _mm256_cmp_ps(magSq, maxSpeedSq, _CMP_GT_OQ);
+        if (_mm256_movemask_ps(hit)) {
+            __m256 mag = _mm256_sqrt_ps(magSq);
+            vx = _mm256_blendv_ps(vx, _mm256_mul_ps(_mm256_div_ps(vx, mag), maxSpeed), hit);
+            vy = _mm256_blendv_ps(vy, _mm256_mul_ps(_mm256_div_ps(vy, mag), maxSpeed), hit);
+        }
+
+        _mm256_storeu_ps(xs + i, x);
+        _mm256_storeu_ps(ys + i, y);
+        _mm256_storeu_ps(vxs + i, vx);
+        _mm256_storeu_ps(vys + i, vy);
+    }
+}
+
+// ---------------------- SSE2 KERNEL ----------------------
+
+#elif defined(__SSE2__)
+
+#define LANE_WIDTH 4
+
+// SSE2 has no blendv: pick b where mask is set, a elsewhere
+static inline __m128 Select(__m128 a, __m128 b, __m128 mask) {
+    return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a));
+}
+
+static void IntegrateVector(float *xs, float *ys, float *vxs, float *vys,
+                            int count, float stepScale, float stepFriction) {
+
+    const __m128 scale = _mm_set1_ps(stepScale);
+    const __m128 friction = _mm_set1_ps(stepFriction);
+    const __m128 minVelocity = _mm_set1_ps(MIN_VELOCITY);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    const __m128 bounce = _mm_set1_ps(RAIL_BOUNCE);
+    const __m128 radius = _mm_set1_ps(BALL_RADIUS);
+    const __m128 nearRail = _mm_set1_ps(RAIL_WIDTH);
+    const __m128 farRailX = _mm_set1_ps(TABLE_WIDTH - RAIL_WIDTH);
+    const __m128 farRailY = _mm_set1_ps(TABLE_HEIGHT - RAIL_WIDTH);
+    const __m128 minPos = _mm_set1_ps(RAIL_WIDTH + BALL_RADIUS);
+    const __m128 maxPosX = _mm_set1_ps(TABLE_WIDTH - RAIL_WIDTH - BALL_RADIUS);
+    const __m128 maxPosY = _mm_set1_ps(TABLE_HEIGHT - RAIL_WIDTH - BALL_RADIUS);
+    const __m128 maxSpeed = _mm_set1_ps(MAX_BALL_SPEED);
+    const __m128 maxSpeedSq = _mm_set1_ps(MAX_BALL_SPEED * MAX_BALL_SPEED);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (int i = 0; i < count; i += LANE_WIDTH) {
+        __m128 vx = _mm_loadu_ps(vxs + i);
+        __m128 vy = _mm_loadu_ps(vys + i);
+        __m128 hit;
+
+        // A block of resting balls is a no-op; skip it
+        hit = _mm_or_ps(_mm_cmpneq_ps(vx, zero), _mm_cmpneq_ps(vy, zero));
+        if (!_mm_movemask_ps(hit)) continue;
+
+        __m128 x = _mm_loadu_ps(xs + i);
+        __m128 y = _mm_loadu_ps(ys + i);
+
+        // Update position and apply friction
+        x = _mm_add_ps(x, _mm_mul_ps(vx, scale));
+        y = _mm_add_ps(y, _mm_mul_ps(vy, scale));
+        vx = _mm_mul_ps(vx, friction);
+        vy = _mm_mul_ps(vy, friction);
+
+        // Stop tiny velocities
+        hit = _mm_cmplt_ps(_mm_andnot_ps(signBit, vx), minVelocity);
+        vx = _mm_andnot_ps(hit, vx);
+        hit = _mm_cmplt_ps(_mm_andnot_ps(signBit, vy), minVelocity);
+        vy = _mm_andnot_ps(hit, vy);
+
+        // Rail collision (bounce effect)
+        hit = _mm_cmplt_ps(_mm_sub_ps(x, radius), nearRail);
+        x = Select(x, minPos, hit);
+        vx = Select(vx, _mm_mul_ps(vx, bounce), hit);
+        hit = _mm_cmpgt_ps(_mm_add_ps(x, radius), farRailX);
+        x = Select(x, maxPosX, hit);
+        vx = Select(vx, _mm_mul_ps(vx, bounce), hit);
+        hit = _mm_cmplt_ps(_mm_sub_ps(y, radius), nearRail);
+        y = Select(y, minPos, hit);
+        vy = Select(vy, _mm_mul_ps(vy, bounce), hit);
+        hit = _mm_cmpgt_ps(_mm_add_ps(y, radius), farRailY);
+        y = Select(y, maxPosY, hit);
+        vy = Select(vy, _mm_mul_ps(vy, bounce), hit);
+
+        // Limit maximum speed (sqrt and divide only when a lane needs it)
+        __m128 magSq = _mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy));
+        hit = _mm_cmpgt_ps(magSq, maxSpeedSq);
+        if (_mm_movemask_ps(hit)) {
+            __m128 mag = _mm_sqrt_ps(magSq);
+            vx = Select(vx, _mm_mul_ps(_mm_div_ps(vx, mag), maxSpeed), hit);
+            vy = Select(vy, _mm_mul_ps(_mm_div_ps(vy, mag), maxSpeed), hit);
+        }
+
+        _mm_storeu_ps(xs + i, x);
+        _mm_storeu_ps(ys + i, y);
+        _mm_storeu_ps(vxs + i, vx);
+        _mm_storeu_ps(vys + i, vy);
+    }
+}
+
+#endif
+
+// ---------------------- ENTRY POINT ----------------------
+
+// Runs one physics step over elements [0, count) of four parallel
+// arrays. count must be a multiple of 8; the arrays may hold balls of
+// one table or the same ball across several tables (see pool_batch.c).
+void IntegrateBallArrays(float *x, float *y, float *vx, float *vy,
+                         int count, float stepScale, float stepFriction) {
+#if defined(LANE_WIDTH)
+    IntegrateVector(x, y, vx, vy, count, stepScale, stepFriction);
+#else
+    IntegrateScalar(x, y, vx, vy, count, stepScale, stepFriction);
+#endif
+}
+
+// Runs one physics step over lanes [0, laneCount). laneCount must be a
+// multiple of 8 (see PHYSICS_LANES).
+void IntegrateLanes(PhysicsLanes *lanes, int laneCount,
+                    float stepScale, float stepFriction) {
+    IntegrateBallArrays(lanes->x, lanes->y, lanes->vx, lanes->vy,
+                        laneCount, stepScale, stepFriction);
+}
@@ -0,0 +1,363 @@
+#include "pool_snapshot.h"
+#include <stdint.h>
+#include <stdio.h>       // For FILE, fopen, fread, fwrite
+#include <string.h>      // For memcpy, memcmp
+
+#define HEADER_SIZE 12
+
+#define RULE_FIRST_SHOT 1
+#define RULE_ASSIGNED 2
+#define RULE_BALLS_MOVING 4
+#define RULE_AIMING 8
+#define RULE_RECOIL 16
+
+#define BALL_TYPE_MASK 3
+#define BALL_POCKETED 4
+#define BALL_STRIPED 8
+#define BALL_MOVING 16
+
+#ifdef SIM_FIXED_POINT
+#define BUILD_FLAGS SNAPSHOT_FIXED
+#else
+#define BUILD_FLAGS 0
+#endif
+
+// ---------------------- BYTE ORDER ----------------------
+
+static unsigned char *PutU16(unsigned char *p, unsigned int v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    return p + 2;
+}
+
+static unsigned char *PutU32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++)
+        p[i] = (unsigned char)(v >> (8 * i));
+    return p + 4;
+}
+
+static unsigned char *PutF32(unsigned char *p, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof bits);
+    return PutU32(p, bits);
+}
+
+// Length byte, then the characters without the terminator
+static unsigned char *PutString(unsigned char *p, const char *s, size_t size) {
+    size_t length = 0;
+    while (length + 1 < size && s[length] != '\0') length++;
+    *p++ = (unsigned char)length;
+    memcpy(p, s, length);
+    return p + length;
+}
+
+static unsigned int GetU16(const unsigned char **p) {
+    unsigned int v = (*p)[0] | ((*p)[1] << 8);
+    *p += 2;
+    return v;
+}
+
+static uint32_t GetU32(const unsigned char **p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++)
+        v |= (uint32_t)(*p)[i] << (8 * i);
+    *p += 4;
+    return v;
+}
+
+static float GetF32(const unsigned char **p) {
+    uint32_t bits = GetU32(p);
+    float v;
+    memcpy(&v, &bits, sizeof v);
+    return v;
+}
+
+static void GetString(const unsigned char **p, char *s) {
+    size_t length = *(*p)++;
+    memcpy(s, *p, length);
+    s[length] = '\0';
+    *p += length;
+}
+
+// True if a string stored at p lies before end and fits size with its
+// terminator
+static bool StringFits(const unsigned char *p, const unsigned char *end,
+                       size_t size) {
+    return p < end && *p < size && (size_t)(end - p) > *p;
+}
+
+// ---------------------- BALL WORDS ----------------------
+
+// The authoritative position and velocity of a ball, as stored
+static void BallWords(const Game *game, int i, uint32_t words[4]) {
+#ifdef SIM_FIXED_POINT
+    words[0] = (uint32_t)game->fixed.x[i];
+    words[1] = (uint32_t)game->fixed.y[i];
+    words[2] = (uint32_t)game->fixed.vx[i];
+    words[3] = (uint32_t)game->fixed.vy[i];
+#else
+    const Ball *ball = &game->balls[i];
+    memcpy(&words[0], &ball->position.x, 4);
+    memcpy(&words[1], &ball->position.y, 4);
+    memcpy(&words[2], &ball->velocity.x, 4);
+    memcpy(&words[3], &ball->velocity.y, 4);
+#endif
+}
+
+static void SetBallWords(Game *game, int i, const uint32_t words[4]) {
+#ifdef SIM_FIXED_POINT
+    game->fixed.x[i] = (Fixed)words[0];
+    game->fixed.y[i] = (Fixed)words[1];
+    game->fixed.vx[i] = (Fixed)words[2];
+    game->fixed.vy[i] = (Fixed)words[3];
+    SyncBallView(game, i);
+#else
+    Ball *ball = &game->balls[i];
+    memcpy(&ball->position.x, &words[0], 4);
+    memcpy(&ball->position.y, &words[1], 4);
+    memcpy(&ball->velocity.x, &words[2], 4);
+    memcpy(&ball->velocity.y, &words[3], 4);
+#endif
+}
+
+// ---------------------- SAVE ----------------------
+
+// Writes the table into buffer. Returns the bytes used, or 0 if
+// capacity is too small; SNAPSHOT_SIZE_MAX always fits.
+size_t SaveSnapshot(const Game *game, unsigned char *buffer, size_t capacity) {
+
+    unsigned char scratch[SNAPSHOT_SIZE_MAX];
+    unsigned char *p = capacity >= SNAPSHOT_SIZE_MAX ? buffer : scratch;
+    unsigned char *start = p;
+
+    memcpy(p, "8BSN", 4);
+    p = PutU16(p + 4, SNAPSHOT_VERSION);
+    *p++ = BUILD_FLAGS;
+    *p++ = 0;
+    p = PutU16(p, game->ballCount);
+    p = PutU16(p, game->physicsHz);
+
+    *p++ = (unsigned char)game->state;
+    *p++ = (unsigned char)game->currentPlayer;
+    *p++ = (game->firstShot ? RULE_FIRST_SHOT : 0) |
+           (game->assignedTypes ? RULE_ASSIGNED : 0) |
+           (game->ballsMoving ? RULE_BALLS_MOVING : 0) |
+           (game->aiming ? RULE_AIMING : 0) |
+           (game->stickRecoil ? RULE_RECOIL : 0);
+    for (int i = 0; i < 2; i++) {
+        *p++ = (unsigned char)game->players[i].type;
+        *p++ = (unsigned char)game->players[i].ballsRemaining;
+        p = PutString(p, game->players[i].name, sizeof game->players[i].name);
+    }
+
+    p = PutF32(p, game->cueBallPos.x);
+    p = PutF32(p, game->cueBallPos.y);
+    p = PutF32(p, game->power);
+    p = PutF32(p, game->dragStart.x);
+    p = PutF32(p, game->dragStart.y);
+    p = PutF32(p, game->stickPullPixels);
+    p = PutF32(p, game->stickLength);
+    p = PutF32(p, game->recoilTimer);
+    p = PutF32(p, game->accumulator);
+    p = PutString(p, game->statusMessage, sizeof game->statusMessage);
+
+    // Resting balls leave out their zero velocity
+    for (int i = 0; i < game->ballCount; i++) {
+        const Ball *ball = &game->balls[i];
+        uint32_t words[4];
+        BallWords(game, i, words);
+        bool moving = (words[2] | words[3]) != 0;
+
+        *p++ = (unsigned char)ball->number;
+        *p++ = (ball->type & BALL_TYPE_MASK) |
+               (ball->pocketed ? BALL_POCKETED : 0) |
+               (ball->isStriped ? BALL_STRIPED : 0) |
+               (moving ? BALL_MOVING : 0);
+        for (int k = 0; k < (moving ? 4 : 2); k++)
+            p = PutU32(p, words[k]);
+    }
+
+    p = PutU16(p, game->awakeCount);
+    for (int n = 0; n < game->awakeCount; n++)
+        p = PutU16(p, game->awakeList[n]);
+
+    unsigned char *filed = p;
+    p += 2;
+    for (int c = 0; c < GRID_CELLS; c++) {
+        for (int j = game->grid.cellHead[c]; j >= 0; j = game->grid.nextInCell[j]) {
+            p = PutU16(p, j);
+            p = PutU16(p, c);
+        }
+    }
+    PutU16(filed, (unsigned int)(p - filed - 2) / 4);
+
+    size_t size = (size_t)(p - start);
+    if (size > capacity) return 0;
+    if (start == scratch) memcpy(buffer, scratch, size);
+    return size;
+}
+
+// ---------------------- LOAD ----------------------
+
+// Puts the awake list and the cell lists back in their saved order over
+// the ones RebuildTableState made. The awake set itself is the same:
+// between steps a ball is awake exactly when it is moving.
+static void RestoreOrder(Game *game, const unsigned char *p) {
+
+    BallGrid *grid = &game->grid;
+
+    game->awakeCount = GetU16(&p);
+    for (int n = 0; n < game->awakeCount; n++) {
+        int ball = GetU16(&p);
+        game->awakeList[n] = (short)ball;
+        game->awakeSlot[ball] = (short)n;
+    }
+
+    for (int c = 0; c < GRID_CELLS; c++)
+        grid->cellHead[c] = -1;
+    for (int i = 0; i < MAX_TABLE_BALLS; i++)
+        grid->ballCell[i] = -1;
+
+    // Each cell's balls are stored together, head first
+    int filed = GetU16(&p);
+    int prev = -1, prevCell = -1;
+    for (int n = 0; n < filed; n++) {
+        int ball = GetU16(&p);
+        int cell = GetU16(&p);
+        if (cell != prevCell) {
+            grid->cellHead[cell] = (short)ball;
+            prev = -1;
+        }
+        else {
+            grid->nextInCell[prev] = (short)ball;
+        }
+        grid->ballCell[ball] = (short)cell;
+        grid->prevInCell[ball] = (short)prev;
+        grid->nextInCell[ball] = -1;
+        prev = ball;
+        prevCell = cell;
+    }
+}
+
+// Replaces the table with a snapshot. Fields a snapshot does not hold,
+// such as fastForward, keep their values, and the grid, lanes and awake
+// set are rebuilt. Returns false, leaving the game untouched, if the
+// bytes are not a complete snapshot of this version and build kind.
+bool LoadSnapshot(Game *game, const unsigned char *buffer, size_t size) {
+
+    const unsigned char *p = buffer + 4, *end = buffer + size;
+    if (size < HEADER_SIZE || memcmp(buffer, "8BSN", 4) != 0 ||
+        GetU16(&p) != SNAPSHOT_VERSION || *p != BUILD_FLAGS)
+        return false;
+    p += 2;
+    int balls = GetU16(&p);
+    int hz = GetU16(&p);
+    if (balls > MAX_TABLE_BALLS) return false;
+
+    // Check the length of every section before touching the game
+    const unsigned char *q = p + 3;
+    for (int i = 0; i < 2; i++) {
+        q += 2;
+        if (!StringFits(q, end, sizeof game->players[i].name)) return false;
+        q += 1 + *q;
+    }
+    q += 36;
+    if (!StringFits(q, end, sizeof game->statusMessage)) return false;
+    q += 1 + *q;
+    for (int i = 0; i < balls; i++) {
+        if (end - q < 2) return false;
+        int words = q[1] & BALL_MOVING ? 4 : 2;
+        q += 2;
+        if (end - q < 4 * words) return false;
+        q += 4 * words;
+    }
+    for (int section = 0; section < 2; section++) {
+        if (end - q < 2) return false;
+        int count = q[0] | q[1] << 8;
+        int stride = section == 0 ? 2 : 4;
+        if (count > balls || end - q - 2 < count * stride) return false;
+        for (q += 2; count > 0; count--, q += stride) {
+            if ((q[0] | q[1] << 8) >= balls) return false;
+            if (stride == 4 && (q[2] | q[3] << 8) >= GRID_CELLS) return false;
+        }
+    }
+
+    game->ballCount = balls;
+    SetPhysicsRate(game, hz);
+
+    game->state = (GameState)*p++;
+    game->currentPlayer = *p++ & 1;
+    unsigned int rules = *p++;
+    game->firstShot = (rules & RULE_FIRST_SHOT) != 0;
+    game->assignedTypes = (rules & RULE_ASSIGNED) != 0;
+    game->ballsMoving = (rules & RULE_BALLS_MOVING) != 0;
+    game->aiming = (rules & RULE_AIMING) != 0;
+    game->stickRecoil = (rules & RULE_RECOIL) != 0;
+    for (int i = 0; i < 2; i++) {
+        game->players[i].type = (PlayerType)*p++;
+        game->players[i].ballsRemaining = *p++;
+        GetString(&p, game->players[i].name);
+    }
+
+    game->cueBallPos.x = GetF32(&p);
+    game->cueBallPos.y = GetF32(&p);
+    game->power = GetF32(&p);
+    game->dragStart.x = GetF32(&p);
+    game->dragStart.y = GetF32(&p);
+    game->stickPullPixels = GetF32(&p);
+    game->stickLength = GetF32(&p);
+    game->recoilTimer = GetF32(&p);
+    game->accumulator = GetF32(&p);
+    GetString(&p, game->statusMessage);
+
+    for (int i = 0; i < balls; i++) {
+        Ball *ball = &game->balls[i];
+        ball->number = *p++;
+        unsigned int bits = *p++;
+        ball->type = (BallType)(bits & BALL_TYPE_MASK);
+        ball->pocketed = (bits & BALL_POCKETED) != 0;
+        ball->isStriped = (bits & BALL_STRIPED) != 0;
+
+        uint32_t words[4] = { 0, 0, 0, 0 };
+        for (int k = 0; k < (bits & BALL_MOVING ? 4 : 2); k++)
+            words[k] = GetU32(&p);
+        SetBallWords(game, i, words);
+        game->previousPositions[i] = ball->position;
+    }
+
+    game->stats = (SimStats){ 0, 0, 0 };
+#ifdef SIM_FIXED_POINT
+    // RebuildTableState reloads the integers from the rounded float view
+    FixedState fixed = game->fixed;
+    RebuildTableState(game);
+    game->fixed = fixed;
+#else
+    RebuildTableState(game);
+#endif
+    RestoreOrder(game, p);
+    return true;
+}
+
+// ---------------------- FILES ----------------------
+
+bool SaveSnapshotFile(const Game *game, const char *path) {
+
+    static unsigned char buffer[SNAPSHOT_SIZE_MAX];
+    size_t size = SaveSnapshot(game, buffer, sizeof buffer);
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) return false;
+    bool ok = fwrite(buffer, 1, size, file) == size;
+    return fclose(file) == 0 && ok;
+}
+
+bool LoadSnapshotFile(Game *game, const char *path) {
+
+    static unsigned char buffer[SNAPSHOT_SIZE_MAX];
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return false;
+    size_t size = fread(buffer, 1, sizeof buffer, file);
+    fclose(file);
+    return LoadSnapshot(game, buffer, size);
+}
@@ -0,0 +1,43 @@
+#ifndef POOL_SNAPSHOT_H
+#define POOL_SNAPSHOT_H
+
+// Whole-table snapshots: everything needed to carry on from a position,
+// including balls in motion, the rule state and the cue stick. Snapshots
+// are built in memory so a search can fork from one position many times;
+// the file helpers wrap the same bytes.
+//
+// Layout, all little-endian:
+//   header   "8BSN", u16 version, u8 flags, u8 spare, u16 ball count,
+//            u16 physicsHz
+//   rules    state, current player, flag bits, then per player its type,
+//            balls remaining and name (u8 length + bytes)
+//   cue      f32 cueBallPos, power, dragStart, stickPullPixels,
+//            stickLength, recoilTimer, accumulator
+//   status   u8 length + bytes
+//   balls    u8 number, u8 bits (type, pocketed, striped, moving),
+//            32-bit x, y, then vx, vy only if moving
+//   order    u16 awake count and the awake balls in list order, then
+//            u16 filed count and (u16 ball, u16 cell) in cell-list order
+//
+// Pairs are resolved in awake-list and cell-list order, so the order
+// section is what makes a restored table carry on exactly as the saved
+// one would have, mid-shot included.
+//
+// The 32-bit ball words are floats, or Q16.16 in SIM_FIXED_POINT builds
+// (SNAPSHOT_FIXED), so a fixed-point table restores bit for bit. A
+// snapshot only loads into a build of the same kind.
+
+#include "pool_sim.h"
+#include <stddef.h>
+
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_FIXED 1          // Header flag: ball words are Q16.16
+
+#define SNAPSHOT_SIZE_MAX (12 + 3 + 2 * 22 + 36 + 100 + 4 + MAX_TABLE_BALLS * 24)
+
+size_t SaveSnapshot(const Game *game, unsigned char *buffer, size_t capacity);
+bool LoadSnapshot(Game *game, const unsigned char *buffer, size_t size);
+bool SaveSnapshotFile(const Game *game, const char *path);
+bool LoadSnapshotFile(Game *game, const char *path);
+
+#endif // POOL_SNAPSHOT_H
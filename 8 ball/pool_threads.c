@@ -0,0 +1,291 @@
+#define _POSIX_C_SOURCE 200809L   // For sysconf, sched_yield
+
+#include "pool_threads.h"
+#include <sched.h>       // For sched_yield
+#include <unistd.h>      // For sysconf
+
+// ---------------------- SCHEDULING ----------------------
+//
+// RunParallel gives every worker an equal slice of [0, count) as one
+// range in its deque. A worker pops the newest range from its own deque,
+// keeps splitting off the upper half (pushing it back for itself or for
+// thieves) until the range is at most `grain` tasks, and runs the rest.
+// An idle worker steals the oldest, and therefore largest, range from a
+// random victim. The calling thread works as worker 0 and returns once
+// every task has run and every helper has left the job, so the deques
+// are empty and quiet between jobs.
+
+#define EMPTY_RANGE (-1LL)
+#define DEQUE_MASK (TASK_DEQUE_SIZE - 1)
+
+static long long PackRange(int begin, int end) {
+    return ((long long)begin << 32) | (unsigned int)end;
+}
+
+static void UnpackRange(long long range, int *begin, int *end) {
+    *begin = (int)(range >> 32);
+    *end = (int)(range & 0xffffffffLL);
+}
+
+// ---------------------- DEQUE ----------------------
+
+// Owner only. Returns false when the deque is full.
+static bool PushRange(TaskDeque *deque, long long range) {
+
+    long long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    if (b - t >= TASK_DEQUE_SIZE) return false;
+
+    atomic_store_explicit(&deque->ranges[b & DEQUE_MASK], range,
+                          memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    return true;
+}
+
+// Owner only. Takes the newest range.
+static long long PopRange(TaskDeque *deque) {
+
+    long long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (t > b) {
+        // Already empty
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+        return EMPTY_RANGE;
+    }
+
+    long long range = atomic_load_explicit(&deque->ranges[b & DEQUE_MASK],
+                                           memory_order_relaxed);
+    if (t == b) {
+        // Last range: race the thieves for it
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                                     memory_order_seq_cst,
+                                                     memory_order_relaxed))
+            range = EMPTY_RANGE;
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    }
+    return range;
+}
+
+// Any thread. Takes the oldest range, or nothing if another thread won.
+static long long StealRange(TaskDeque *deque) {
+
+    long long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (t >= b) return EMPTY_RANGE;
+
+    long long range = atomic_load_explicit(&deque->ranges[t & DEQUE_MASK],
+                                           memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed))
+        return EMPTY_RANGE;
+    return range;
+}
+
+// ---------------------- WORKERS ----------------------
+
+static long long TrySteal(Worker *worker) {
+
+    ThreadPool *pool = worker->pool;
+
+    for (int attempt = 0; attempt < pool->workerCount; attempt++) {
+        worker->seed ^= worker->seed << 13;
+        worker->seed ^= worker->seed >> 17;
+        worker->seed ^= worker->seed << 5;
+        int victim = (int)(worker->seed % (unsigned int)pool->workerCount);
+        if (victim == worker->index) continue;
+
+        long long range = StealRange(&pool->deques[victim]);
+        if (range != EMPTY_RANGE) return range;
+    }
+    return EMPTY_RANGE;
+}
+
+static void RunRange(Worker *worker, long long range) {
+
+    ThreadPool *pool = worker->pool;
+    TaskDeque *own = &pool->deques[worker->index];
+    int begin, end;
+    UnpackRange(range, &begin, &end);
+
+    // Leave the upper halves where thieves can find them
+    while (end - begin > pool->grain) {
+        int mid = begin + (end - begin) / 2;
+        if (!PushRange(own, PackRange(mid, end))) break;
+        end = mid;
+    }
+
+    for (int i = begin; i < end; i++)
+        pool->func(pool->context, i);
+
+    atomic_fetch_sub_explicit(&pool->remaining, end - begin,
+                              memory_order_acq_rel);
+}
+
+static void WorkUntilDone(Worker *worker) {
+
+    ThreadPool *pool = worker->pool;
+    TaskDeque *own = &pool->deques[worker->index];
+
+    while (atomic_load_explicit(&pool->remaining, memory_order_acquire) > 0) {
+        long long range = PopRange(own);
+        if (range == EMPTY_RANGE)
+            range = TrySteal(worker);
+
+        if (range != EMPTY_RANGE)
+            RunRange(worker, range);
+        else
+            sched_yield();
+    }
+}
+
+static void *WorkerMain(void *arg) {
+
+    Worker *worker = arg;
+    ThreadPool *pool = worker->pool;
+    unsigned long seen = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->generation == seen && !pool->shutdown)
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        if (pool->shutdown) {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        WorkUntilDone(worker);
+        atomic_fetch_sub_explicit(&pool->busy, 1, memory_order_release);
+    }
+}
+
+// ---------------------- POOL ----------------------
+
+// Online CPUs, clamped to what a pool can hold
+int DefaultWorkerCount(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) cpus = 1;
+    if (cpus > MAX_WORKERS) cpus = MAX_WORKERS;
+    return (int)cpus;
+}
+
+// Starts workerCount - 1 helper threads (0 picks one per CPU); the
+// calling thread is the last worker. Returns false if a thread could
+// not be started.
+bool CreateThreadPool(ThreadPool *pool, int workerCount) {
+
+    if (workerCount <= 0) workerCount = DefaultWorkerCount();
+    if (workerCount > MAX_WORKERS) workerCount = MAX_WORKERS;
+
+    pool->workerCount = workerCount;
+    pool->generation = 0;
+    pool->shutdown = false;
+    atomic_init(&pool->remaining, 0);
+    atomic_init(&pool->busy, 0);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+
+    for (int w = 0; w < workerCount; w++) {
+        atomic_init(&pool->deques[w].top, 0);
+        atomic_init(&pool->deques[w].bottom, 0);
+        pool->workers[w].pool = pool;
+        pool->workers[w].index = w;
+        pool->workers[w].seed = 2463534242u + 977u * (unsigned int)w;
+    }
+
+    for (int w = 1; w < workerCount; w++) {
+        if (pthread_create(&pool->threads[w], NULL,
+                           WorkerMain, &pool->workers[w]) != 0) {
+            pool->workerCount = w;
+            DestroyThreadPool(pool);
+            return false;
+        }
+    }
+    return true;
+}
+
+void DestroyThreadPool(ThreadPool *pool) {
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int w = 1; w < pool->workerCount; w++)
+        pthread_join(pool->threads[w], NULL);
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pool->workerCount = 0;
+}
+
+// Runs func(context, i) for every i in [0, count) across the pool and
+// returns when all of them are done
+void RunParallel(ThreadPool *pool, int count, TaskFunc func, void *context) {
+
+    if (count <= 0) return;
+
+    // Enough pieces per worker to even out uneven tasks
+    int grain = count / (pool->workerCount * 8);
+    pool->grain = grain > 0 ? grain : 1;
+    pool->func = func;
+    pool->context = context;
+    atomic_store(&pool->remaining, count);
+    atomic_store(&pool->busy, pool->workerCount - 1);
+
+    // Seed every deque with an equal slice. The helpers are asleep and
+    // the lock below publishes the pushes to them.
+    for (int w = 0; w < pool->workerCount; w++) {
+        int begin = (int)((long long)count * w / pool->workerCount);
+        int end = (int)((long long)count * (w + 1) / pool->workerCount);
+        if (begin < end)
+            PushRange(&pool->deques[w], PackRange(begin, end));
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    WorkUntilDone(&pool->workers[0]);
+
+    // Helpers may still be on their way out of the job
+    while (atomic_load_explicit(&pool->busy, memory_order_acquire) > 0)
+        sched_yield();
+}
+
+// ---------------------- SHOT EVALUATION ----------------------
+
+typedef struct {
+    const Game *game;
+    const ShotParams *shots;
+    ShotOutcome *outcomes;
+} ShotJob;
+
+static void SimulateShotTask(void *context, int index) {
+
+    ShotJob *job = context;
+
+    // Every task plays its own copy, so the result does not depend on
+    // which thread ran it
+    Game table = *job->game;
+    int steps = SimulateShot(&table, job->shots[index].direction,
+                             job->shots[index].speed);
+    GetShotOutcome(&table, steps, &job->outcomes[index]);
+}
+
+// Plays count shots from the same position with SimulateShot, spread
+// over the pool. outcomes[i] belongs to shots[i].
+void SimulateShotsParallel(ThreadPool *pool, const Game *game,
+                           const ShotParams *shots, ShotOutcome *outcomes,
+                           int count) {
+    ShotJob job = { game, shots, outcomes };
+    RunParallel(pool, count, SimulateShotTask, &job);
+}
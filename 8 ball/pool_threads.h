@@ -0,0 +1,63 @@
+#ifndef POOL_THREADS_H
+#define POOL_THREADS_H
+
+// Work-stealing thread pool for independent headless jobs, such as
+// playing the same table under many candidate shots. Each worker owns a
+// deque of task ranges; it splits and runs its own work from the bottom
+// and steals from the top of the others' when it runs dry.
+
+#include "pool_sim.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define MAX_WORKERS 64            // Threads a pool can run, caller included
+#define TASK_DEQUE_SIZE 64        // Ranges per deque (a power of two)
+
+// Runs task `index` of a parallel loop. Tasks must only write to their
+// own output slots, which keeps results independent of thread count.
+typedef void (*TaskFunc)(void *context, int index);
+
+// Chase-Lev deque of [begin, end) task ranges packed into 64 bits
+typedef struct {
+    _Alignas(64) atomic_llong top;        // Thieves take from here
+    _Alignas(64) atomic_llong bottom;     // Owner pushes and pops here
+    atomic_llong ranges[TASK_DEQUE_SIZE];
+} TaskDeque;
+
+typedef struct ThreadPool ThreadPool;
+
+// Per-thread state handed to each worker
+typedef struct {
+    ThreadPool *pool;
+    int index;                    // Worker 0 is the calling thread
+    unsigned int seed;            // Victim selection for stealing
+} Worker;
+
+struct ThreadPool {
+    int workerCount;
+    pthread_t threads[MAX_WORKERS];
+    Worker workers[MAX_WORKERS];
+    TaskDeque deques[MAX_WORKERS];
+
+    // Current job, published under lock before the workers wake
+    TaskFunc func;
+    void *context;
+    int grain;                    // Ranges at or below this run unsplit
+    atomic_int remaining;         // Tasks not finished yet
+    atomic_int busy;              // Helper threads still inside the job
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    unsigned long generation;     // Bumped for every job
+    bool shutdown;
+};
+
+int DefaultWorkerCount(void);
+bool CreateThreadPool(ThreadPool *pool, int workerCount);
+void DestroyThreadPool(ThreadPool *pool);
+void RunParallel(ThreadPool *pool, int count, TaskFunc func, void *context);
+void SimulateShotsParallel(ThreadPool *pool, const Game *game,
+                           const ShotParams *shots, ShotOutcome *outcomes,
+                           int count);
+
+#endif // POOL_THREADS_H
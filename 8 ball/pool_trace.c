@@ -0,0 +1,199 @@
+#define _POSIX_C_SOURCE 200809L   // For clock_gettime, nanosleep
+
+#include "pool_trace.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>       // For FILE, fprintf
+#include <stdlib.h>      // For malloc, free
+#include <time.h>        // For clock_gettime, nanosleep
+
+// ---------------------- RING ----------------------
+//
+// Bounded multi-producer ring after Vyukov. Every slot carries a
+// sequence number: a producer claims position pos by moving writePos
+// from pos to pos + 1 while the slot's sequence reads pos, fills the
+// record, and publishes it by storing pos + 1. The writer thread, the
+// only consumer, takes slot pos once its sequence is pos + 1 and hands
+// it back for the next lap by storing pos + TRACE_RING_SIZE. A full
+// ring drops the event rather than wait.
+
+#define TRACE_MASK (TRACE_RING_SIZE - 1)
+
+typedef struct {
+    uint64_t time;                // Nanoseconds since StartTrace
+    const char *name;
+    char phase;                   // 'B', 'E' or 'i'
+    int thread;
+    int a, b;
+} TraceRecord;
+
+typedef struct {
+    atomic_ullong sequence;
+    TraceRecord record;
+} TraceSlot;
+
+typedef struct {
+    TraceSlot *slots;
+    _Alignas(64) atomic_ullong writePos;
+    _Alignas(64) unsigned long long readPos;   // Writer thread only
+    atomic_int dropped;
+    atomic_int nextThread;
+
+    FILE *file;
+    bool firstEvent;
+    uint64_t startTime;
+    pthread_t writer;
+    atomic_bool stopping;
+} TraceState;
+
+atomic_bool traceActive;
+
+static TraceState trace;
+static _Thread_local int traceThread;   // 0 until the thread's first event
+
+static uint64_t MonotonicNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void TraceEvent(char phase, const char *name, int a, int b) {
+
+    if (traceThread == 0)
+        traceThread = atomic_fetch_add(&trace.nextThread, 1) + 1;
+
+    unsigned long long pos = atomic_load_explicit(&trace.writePos,
+                                                  memory_order_relaxed);
+    TraceSlot *slot;
+    for (;;) {
+        slot = &trace.slots[pos & TRACE_MASK];
+        unsigned long long seq = atomic_load_explicit(&slot->sequence,
+                                                      memory_order_acquire);
+        long long diff = (long long)(seq - pos);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&trace.writePos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0) {
+            // The writer is a full lap behind
+            atomic_fetch_add_explicit(&trace.dropped, 1, memory_order_relaxed);
+            return;
+        }
+        else {
+            pos = atomic_load_explicit(&trace.writePos, memory_order_relaxed);
+        }
+    }
+
+    slot->record = (TraceRecord){ MonotonicNanos() - trace.startTime,
+                                  name, phase, traceThread, a, b };
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+}
+
+// ---------------------- WRITER ----------------------
+
+static void WriteRecord(const TraceRecord *r) {
+
+    fprintf(trace.file,
+            "%s\n{\"name\":\"%s\",\"cat\":\"pool\",\"ph\":\"%c\",\"ts\":%.3f,"
+            "\"pid\":1,\"tid\":%d",
+            trace.firstEvent ? "" : ",", r->name, r->phase,
+            r->time / 1000.0, r->thread);
+    trace.firstEvent = false;
+
+    if (r->phase == 'i')
+        fprintf(trace.file, ",\"s\":\"t\"");
+    if (r->a >= 0 && r->b >= 0)
+        fprintf(trace.file, ",\"args\":{\"a\":%d,\"b\":%d}", r->a, r->b);
+    else if (r->a >= 0)
+        fprintf(trace.file, ",\"args\":{\"a\":%d}", r->a);
+    fprintf(trace.file, "}");
+}
+
+// Writes every published event; stops at the first slot still being filled
+static void DrainRing(void) {
+
+    for (;;) {
+        TraceSlot *slot = &trace.slots[trace.readPos & TRACE_MASK];
+        unsigned long long seq = atomic_load_explicit(&slot->sequence,
+                                                      memory_order_acquire);
+        if (seq != trace.readPos + 1) break;
+
+        WriteRecord(&slot->record);
+        atomic_store_explicit(&slot->sequence, trace.readPos + TRACE_RING_SIZE,
+                              memory_order_release);
+        trace.readPos++;
+    }
+    fflush(trace.file);
+}
+
+static void *WriterMain(void *arg) {
+
+    (void)arg;
+    struct timespec pause = { 0, TRACE_FLUSH_MS * 1000000L };
+
+    while (!atomic_load_explicit(&trace.stopping, memory_order_acquire)) {
+        DrainRing();
+        nanosleep(&pause, NULL);
+    }
+    return NULL;
+}
+
+// ---------------------- CONTROL ----------------------
+
+// Opens path and starts recording. Returns false if the file, the ring
+// or the writer thread could not be set up, or a trace is running.
+bool StartTrace(const char *path) {
+
+    if (atomic_load(&traceActive)) return false;
+
+    trace.slots = malloc(TRACE_RING_SIZE * sizeof *trace.slots);
+    if (trace.slots == NULL) return false;
+
+    trace.file = fopen(path, "w");
+    if (trace.file == NULL) {
+        free(trace.slots);
+        return false;
+    }
+
+    for (unsigned long long i = 0; i < TRACE_RING_SIZE; i++)
+        atomic_init(&trace.slots[i].sequence, i);
+    atomic_init(&trace.writePos, 0);
+    trace.readPos = 0;
+    atomic_init(&trace.dropped, 0);
+    atomic_init(&trace.nextThread, 0);
+    atomic_init(&trace.stopping, false);
+    trace.firstEvent = true;
+    trace.startTime = MonotonicNanos();
+
+    fprintf(trace.file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    if (pthread_create(&trace.writer, NULL, WriterMain, NULL) != 0) {
+        fclose(trace.file);
+        free(trace.slots);
+        return false;
+    }
+
+    atomic_store(&traceActive, true);
+    return true;
+}
+
+// Stops recording, writes what is left and closes the file. Call it
+// once no other thread can still be inside a traced section.
+void StopTrace(void) {
+
+    if (!atomic_load(&traceActive)) return;
+    atomic_store(&traceActive, false);
+
+    atomic_store(&trace.stopping, true);
+    pthread_join(trace.writer, NULL);
+    DrainRing();
+
+    fprintf(trace.file, "\n],\"otherData\":{\"droppedEvents\":%d}}\n",
+            atomic_load(&trace.dropped));
+    fclose(trace.file);
+    free(trace.slots);
+    trace.slots = NULL;
+}
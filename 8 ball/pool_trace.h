@@ -0,0 +1,33 @@
+#ifndef POOL_TRACE_H
+#define POOL_TRACE_H
+
+// Chrome trace export (chrome://tracing, ui.perfetto.dev). Any thread
+// drops begin / end / instant events into a lock-free ring; a background
+// thread drains it into a JSON trace file. When no trace is running each
+// macro is one relaxed load and a branch.
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#define TRACE_RING_SIZE 65536     // Events in flight (a power of two)
+#define TRACE_FLUSH_MS 10         // How often the writer drains the ring
+
+extern atomic_bool traceActive;
+
+bool StartTrace(const char *path);
+void StopTrace(void);
+void TraceEvent(char phase, const char *name, int a, int b);
+
+// name must be a string literal (or otherwise outlive the trace); a and
+// b show up as args, and negative values are left out
+#define TRACE_IF_ACTIVE(phase, name, a, b)                                \
+    do {                                                                  \
+        if (atomic_load_explicit(&traceActive, memory_order_relaxed))     \
+            TraceEvent(phase, name, a, b);                                \
+    } while (0)
+
+#define TRACE_BEGIN(name) TRACE_IF_ACTIVE('B', name, -1, -1)
+#define TRACE_END(name) TRACE_IF_ACTIVE('E', name, -1, -1)
+#define TRACE_INSTANT(name, a, b) TRACE_IF_ACTIVE('i', name, a, b)
+
+#endif // POOL_TRACE_H
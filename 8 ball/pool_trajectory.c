@@ -0,0 +1,241 @@
+#include "pool_trajectory.h"
+#include <math.h>        // For floorf
+#include <string.h>      // For memcmp
+
+#define FRAME_KEY 1               // Every ball stored absolutely
+#define FRAME_POCKETS 2           // A pocketed bitmask follows the moved one
+
+#define HEADER_SIZE 10
+#define NIBBLE_ESCAPE 15
+#define FRAME_SIZE_MAX (1 + MAX_TABLE_BALLS / 4 + 2 + MAX_TABLE_BALLS * 11)
+
+// ---------------------- VARINTS ----------------------
+
+static uint32_t ZigZag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t UnZigZag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static unsigned char *PutVarint(unsigned char *p, uint32_t v) {
+    while (v >= 0x80) {
+        *p++ = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (unsigned char)v;
+    return p;
+}
+
+static bool GetVarint(FILE *file, uint32_t *v) {
+    *v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        int c = getc(file);
+        if (c == EOF) return false;
+        *v |= (uint32_t)(c & 0x7f) << shift;
+        if (!(c & 0x80)) return true;
+    }
+    return false;
+}
+
+static int32_t Quantize(float v) {
+    return (int32_t)floorf(v * TRAJECTORY_SCALE + 0.5f);
+}
+
+// ---------------------- ENCODER ----------------------
+
+// Writes the stream header; the first encoded frame is a key frame
+bool StartTrajectory(TrajectoryEncoder *encoder, FILE *file,
+                     const Game *game, int frameHz) {
+
+    encoder->file = file;
+    encoder->state.ballCount = game->ballCount;
+    encoder->state.frames = 0;
+
+    unsigned char header[HEADER_SIZE] = {
+        '8', 'B', 'T', 'J',
+        TRAJECTORY_VERSION & 0xff, TRAJECTORY_VERSION >> 8,
+        game->ballCount & 0xff, game->ballCount >> 8,
+        frameHz & 0xff, frameHz >> 8
+    };
+    encoder->bytes = HEADER_SIZE;
+    return fwrite(header, 1, HEADER_SIZE, file) == HEADER_SIZE;
+}
+
+// Appends the balls as they are now
+bool EncodeTrajectoryFrame(TrajectoryEncoder *encoder, const Game *game) {
+
+    TrajectoryState *s = &encoder->state;
+    unsigned char buffer[FRAME_SIZE_MAX], *p = buffer;
+    int maskBytes = (s->ballCount + 7) / 8;
+
+    if (s->frames % TRAJECTORY_KEY_FRAMES == 0) {
+        *p++ = FRAME_KEY;
+        for (int i = 0; i < s->ballCount; i++) {
+            s->x[i] = Quantize(game->balls[i].position.x);
+            s->y[i] = Quantize(game->balls[i].position.y);
+            s->dx[i] = s->dy[i] = 0;
+            s->pocketed[i] = game->balls[i].pocketed;
+            p = PutVarint(p, ZigZag(s->x[i]));
+            p = PutVarint(p, ZigZag(s->y[i]));
+            *p++ = s->pocketed[i];
+        }
+    }
+    else {
+        unsigned char *flags = p++;
+        unsigned char *moved = p;
+        memset(moved, 0, maskBytes);
+        p += maskBytes;
+        *flags = 0;
+
+        // Pocketed balls that changed state this frame
+        unsigned char pockets[MAX_TABLE_BALLS / 8 + 1] = {0};
+        for (int i = 0; i < s->ballCount; i++) {
+            if (game->balls[i].pocketed != s->pocketed[i]) {
+                pockets[i >> 3] |= 1 << (i & 7);
+                s->pocketed[i] = game->balls[i].pocketed;
+                *flags = FRAME_POCKETS;
+            }
+        }
+        if (*flags & FRAME_POCKETS) {
+            memcpy(p, pockets, maskBytes);
+            p += maskBytes;
+        }
+
+        for (int i = 0; i < s->ballCount; i++) {
+            int32_t x = Quantize(game->balls[i].position.x);
+            int32_t y = Quantize(game->balls[i].position.y);
+
+            // Unmoved balls cost one bit and stop predicting motion
+            if (x == s->x[i] && y == s->y[i]) {
+                s->dx[i] = s->dy[i] = 0;
+                continue;
+            }
+            moved[i >> 3] |= 1 << (i & 7);
+
+            uint32_t zx = ZigZag(x - (s->x[i] + s->dx[i]));
+            uint32_t zy = ZigZag(y - (s->y[i] + s->dy[i]));
+            *p++ = (unsigned char)(((zx < NIBBLE_ESCAPE ? zx : NIBBLE_ESCAPE) << 4) |
+                                   (zy < NIBBLE_ESCAPE ? zy : NIBBLE_ESCAPE));
+            if (zx >= NIBBLE_ESCAPE) p = PutVarint(p, zx);
+            if (zy >= NIBBLE_ESCAPE) p = PutVarint(p, zy);
+
+            s->dx[i] = x - s->x[i];
+            s->dy[i] = y - s->y[i];
+            s->x[i] = x;
+            s->y[i] = y;
+        }
+    }
+
+    s->frames++;
+    size_t size = p - buffer;
+    encoder->bytes += (long)size;
+    return fwrite(buffer, 1, size, encoder->file) == size;
+}
+
+// ---------------------- DECODER ----------------------
+
+// Reads the stream header. Returns false if it is not a trajectory.
+bool OpenTrajectory(TrajectoryDecoder *decoder, FILE *file) {
+
+    unsigned char header[HEADER_SIZE];
+    if (fread(header, 1, HEADER_SIZE, file) != HEADER_SIZE ||
+        memcmp(header, "8BTJ", 4) != 0 ||
+        (header[4] | header[5] << 8) != TRAJECTORY_VERSION)
+        return false;
+
+    int balls = header[6] | header[7] << 8;
+    if (balls > MAX_TABLE_BALLS) return false;
+
+    decoder->file = file;
+    decoder->state.ballCount = balls;
+    decoder->state.frames = 0;
+    decoder->frameHz = header[8] | header[9] << 8;
+    return true;
+}
+
+// Advances to the next frame. Returns false at the end of the stream,
+// including a frame cut short by a crash.
+bool DecodeTrajectoryFrame(TrajectoryDecoder *decoder) {
+
+    TrajectoryState *s = &decoder->state;
+    FILE *file = decoder->file;
+    int maskBytes = (s->ballCount + 7) / 8;
+    uint32_t zx, zy;
+
+    int flags = getc(file);
+    if (flags == EOF) return false;
+
+    if (flags & FRAME_KEY) {
+        for (int i = 0; i < s->ballCount; i++) {
+            if (!GetVarint(file, &zx) || !GetVarint(file, &zy)) return false;
+            int pocketed = getc(file);
+            if (pocketed == EOF) return false;
+            s->x[i] = UnZigZag(zx);
+            s->y[i] = UnZigZag(zy);
+            s->dx[i] = s->dy[i] = 0;
+            s->pocketed[i] = pocketed != 0;
+        }
+        s->frames++;
+        return true;
+    }
+
+    unsigned char moved[MAX_TABLE_BALLS / 8 + 1];
+    unsigned char pockets[MAX_TABLE_BALLS / 8 + 1];
+    if (fread(moved, 1, maskBytes, file) != (size_t)maskBytes) return false;
+    if (flags & FRAME_POCKETS) {
+        if (fread(pockets, 1, maskBytes, file) != (size_t)maskBytes) return false;
+        for (int i = 0; i < s->ballCount; i++) {
+            if (pockets[i >> 3] & (1 << (i & 7)))
+                s->pocketed[i] = !s->pocketed[i];
+        }
+    }
+
+    for (int byte = 0; byte < maskBytes; byte++) {
+
+        // Whole bytes of resting balls are skipped at once
+        if (moved[byte] == 0) {
+            for (int i = byte * 8; i < byte * 8 + 8 && i < s->ballCount; i++)
+                s->dx[i] = s->dy[i] = 0;
+            continue;
+        }
+
+        for (int i = byte * 8; i < byte * 8 + 8 && i < s->ballCount; i++) {
+            if (!(moved[byte] & (1 << (i & 7)))) {
+                s->dx[i] = s->dy[i] = 0;
+                continue;
+            }
+
+            int nibbles = getc(file);
+            if (nibbles == EOF) return false;
+            zx = nibbles >> 4;
+            zy = nibbles & 15;
+            if (zx == NIBBLE_ESCAPE && !GetVarint(file, &zx)) return false;
+            if (zy == NIBBLE_ESCAPE && !GetVarint(file, &zy)) return false;
+
+            s->dx[i] += UnZigZag(zx);
+            s->dy[i] += UnZigZag(zy);
+            s->x[i] += s->dx[i];
+            s->y[i] += s->dy[i];
+        }
+    }
+
+    s->frames++;
+    return true;
+}
+
+// Puts the decoded frame on the table for drawing
+void ApplyTrajectoryFrame(const TrajectoryDecoder *decoder, Game *game) {
+
+    const TrajectoryState *s = &decoder->state;
+
+    for (int i = 0; i < s->ballCount && i < MAX_TABLE_BALLS; i++) {
+        Ball *ball = &game->balls[i];
+        ball->position.x = (float)s->x[i] / TRAJECTORY_SCALE;
+        ball->position.y = (float)s->y[i] / TRAJECTORY_SCALE;
+        ball->velocity = (Vector2){0, 0};
+        ball->pocketed = s->pocketed[i];
+        game->previousPositions[i] = ball->position;
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef POOL_TRAJECTORY_H
+#define POOL_TRAJECTORY_H
+
+// Compressed per-frame ball positions, for replays that show every frame
+// exactly as it was drawn. Positions are quantized to 1/16 px. Each frame
+// stores only the balls whose quantized position changed. A ball's
+// change is predicted to equal its change in the previous frame, and
+// only the difference from that prediction is stored. Under friction
+// that difference is a few sixteenths, so both axes usually fit one byte.
+//
+// Stream layout:
+//   header  "8BTJ", u16 version, u16 ball count, u16 frames per second
+//   frames  flags byte, then
+//           key frame:    every ball as a varint absolute position and
+//                         a pocketed byte
+//           other frames: moved-ball bitmask, pocketed bitmask (only if
+//                         flagged), then one entry per moved ball
+//   entry   byte with the zigzag residuals of x and y in its two nibbles;
+//           a nibble of 15 means a varint with the full value follows
+//
+// Encoder and decoder share the same quantized state, so the stream is
+// lossless at 1/16 px and errors never accumulate. The caller owns the
+// FILE; frames are appended as they are encoded.
+
+#include "pool_sim.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#define TRAJECTORY_VERSION 1
+#define TRAJECTORY_SCALE 16       // Quantization steps per pixel
+#define TRAJECTORY_KEY_FRAMES 600 // Frames between full key frames
+
+// Quantized state both sides track, one entry per ball
+typedef struct {
+    int ballCount;
+    int32_t x[MAX_TABLE_BALLS], y[MAX_TABLE_BALLS];     // Position
+    int32_t dx[MAX_TABLE_BALLS], dy[MAX_TABLE_BALLS];   // Last change
+    bool pocketed[MAX_TABLE_BALLS];
+    int frames;
+} TrajectoryState;
+
+typedef struct {
+    FILE *file;
+    TrajectoryState state;
+    long bytes;                   // Written so far, header included
+} TrajectoryEncoder;
+
+typedef struct {
+    FILE *file;
+    TrajectoryState state;
+    int frameHz;
+} TrajectoryDecoder;
+
+bool StartTrajectory(TrajectoryEncoder *encoder, FILE *file,
+                     const Game *game, int frameHz);
+bool EncodeTrajectoryFrame(TrajectoryEncoder *encoder, const Game *game);
+
+bool OpenTrajectory(TrajectoryDecoder *decoder, FILE *file);
+bool DecodeTrajectoryFrame(TrajectoryDecoder *decoder);
+void ApplyTrajectoryFrame(const TrajectoryDecoder *decoder, Game *game);
+
+#endif // POOL_TRAJECTORY_H
@@ -0,0 +1,209 @@
+#include "pool_zobrist.h"
+#include <stdlib.h>      // For aligned_alloc, free
+#include <string.h>      // For memcpy
+
+#define ZOBRIST_SEED 0x8ba11a5e5eedull
+
+// Feature kinds, kept apart in the top byte of a key's input
+#define KEY_BALL 1
+#define KEY_PLAYER 2
+#define KEY_TYPE 3
+#define KEY_STATE 4
+
+// ---------------------- KEYS ----------------------
+
+static uint64_t SplitMix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+static uint64_t ZobristKey(unsigned int kind, unsigned int a, unsigned int b) {
+    return SplitMix64(ZOBRIST_SEED ^ ((uint64_t)kind << 56) ^
+                      ((uint64_t)a << 32) ^ b);
+}
+
+// Quantized cell of a ball; pocketed balls share the cell -1
+static int BallCell(const TableHash *hash, const Ball *ball) {
+    if (ball->pocketed) return -1;
+    int col = (int)(ball->position.x / hash->gridSize);
+    int row = (int)(ball->position.y / hash->gridSize);
+    if (col < 0) col = 0;
+    if (col >= hash->cols) col = hash->cols - 1;
+    if (row < 0) row = 0;
+    return row * hash->cols + col;
+}
+
+static uint64_t BallKey(int ball, int cell) {
+    return ZobristKey(KEY_BALL, (unsigned int)ball, (unsigned int)cell);
+}
+
+// ---------------------- TABLE HASH ----------------------
+
+// Hashes every feature from scratch. gridSize of 0 uses ZOBRIST_GRID.
+void InitTableHash(TableHash *hash, const Game *game, float gridSize) {
+
+    hash->gridSize = gridSize > 0.0f ? gridSize : ZOBRIST_GRID;
+    hash->cols = (int)(TABLE_WIDTH / hash->gridSize) + 1;
+    hash->ballCount = game->ballCount;
+    hash->hash = 0;
+
+    for (int i = 0; i < game->ballCount; i++) {
+        hash->cell[i] = BallCell(hash, &game->balls[i]);
+        hash->hash ^= BallKey(i, hash->cell[i]);
+    }
+
+    hash->player = game->currentPlayer;
+    hash->state = game->state;
+    hash->hash ^= ZobristKey(KEY_PLAYER, hash->player, 0);
+    hash->hash ^= ZobristKey(KEY_STATE, hash->state, 0);
+    for (int p = 0; p < 2; p++) {
+        hash->types[p] = game->players[p].type;
+        hash->hash ^= ZobristKey(KEY_TYPE, p, hash->types[p]);
+    }
+}
+
+// Brings the hash up to date with the table and returns it. Only
+// features that changed are XORed out and back in; a ball that moved
+// within its cell changes nothing.
+uint64_t UpdateTableHash(TableHash *hash, const Game *game) {
+
+    if (game->ballCount != hash->ballCount) {
+        InitTableHash(hash, game, hash->gridSize);
+        return hash->hash;
+    }
+
+    for (int i = 0; i < game->ballCount; i++) {
+        int cell = BallCell(hash, &game->balls[i]);
+        if (cell == hash->cell[i]) continue;
+        hash->hash ^= BallKey(i, hash->cell[i]) ^ BallKey(i, cell);
+        hash->cell[i] = cell;
+    }
+
+    if (game->currentPlayer != hash->player) {
+        hash->hash ^= ZobristKey(KEY_PLAYER, hash->player, 0) ^
+                      ZobristKey(KEY_PLAYER, game->currentPlayer, 0);
+        hash->player = game->currentPlayer;
+    }
+    if (game->state != hash->state) {
+        hash->hash ^= ZobristKey(KEY_STATE, hash->state, 0) ^
+                      ZobristKey(KEY_STATE, game->state, 0);
+        hash->state = game->state;
+    }
+    for (int p = 0; p < 2; p++) {
+        if (game->players[p].type == hash->types[p]) continue;
+        hash->hash ^= ZobristKey(KEY_TYPE, p, hash->types[p]) ^
+                      ZobristKey(KEY_TYPE, p, game->players[p].type);
+        hash->types[p] = game->players[p].type;
+    }
+    return hash->hash;
+}
+
+// One-off hash of a position, equal to what InitTableHash computes
+uint64_t HashTablePosition(const Game *game, float gridSize) {
+    TableHash hash;
+    InitTableHash(&hash, game, gridSize);
+    return hash.hash;
+}
+
+// ---------------------- TRANSPOSITION TABLE ----------------------
+
+static uint64_t PackOutcome(CachedOutcome outcome) {
+    uint32_t bits;
+    memcpy(&bits, &outcome.score, sizeof bits);
+    return bits | (uint64_t)outcome.samples << 32 |
+           (uint64_t)outcome.bestShot << 48;
+}
+
+static CachedOutcome UnpackOutcome(uint64_t data) {
+    CachedOutcome outcome;
+    uint32_t bits = (uint32_t)data;
+    memcpy(&outcome.score, &bits, sizeof bits);
+    outcome.samples = (uint16_t)(data >> 32);
+    outcome.bestShot = (uint16_t)(data >> 48);
+    return outcome;
+}
+
+// Allocates the largest power-of-two number of buckets that fits in
+// bytes, all empty. Returns false if bytes holds no bucket or the
+// allocation fails.
+bool CreateTranspositionTable(TranspositionTable *table, size_t bytes) {
+
+    size_t count = 1;
+    if (bytes < sizeof(TranspositionBucket)) return false;
+    while (count * 2 * sizeof(TranspositionBucket) <= bytes) count *= 2;
+
+    table->buckets = aligned_alloc(_Alignof(TranspositionBucket),
+                                   count * sizeof(TranspositionBucket));
+    if (table->buckets == NULL) return false;
+    table->mask = count - 1;
+    ClearTranspositionTable(table);
+    return true;
+}
+
+void FreeTranspositionTable(TranspositionTable *table) {
+    free(table->buckets);
+    table->buckets = NULL;
+}
+
+// Empties every slot. Not safe while other threads use the table.
+void ClearTranspositionTable(TranspositionTable *table) {
+    for (uint64_t b = 0; b <= table->mask; b++) {
+        for (int w = 0; w < TRANSPOSITION_WAYS; w++) {
+            atomic_init(&table->buckets[b].slots[w].check, 0);
+            atomic_init(&table->buckets[b].slots[w].data, 0);
+        }
+    }
+}
+
+// Looks the position up; safe from any number of threads at once
+bool ProbeTransposition(const TranspositionTable *table, uint64_t key,
+                        CachedOutcome *outcome) {
+
+    TranspositionBucket *bucket = &table->buckets[key & table->mask];
+
+    for (int w = 0; w < TRANSPOSITION_WAYS; w++) {
+        TranspositionSlot *slot = &bucket->slots[w];
+        uint64_t data = atomic_load_explicit(&slot->data, memory_order_relaxed);
+        uint64_t check = atomic_load_explicit(&slot->check, memory_order_relaxed);
+        if (data != 0 && (check ^ data) == key) {
+            *outcome = UnpackOutcome(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Saves an outcome over the same position's slot, an empty slot, or
+// the slot with the fewest samples, in that order of preference. Safe
+// from any number of threads at once; racing writers may lose an entry
+// but never produce a wrong one.
+void StoreTransposition(TranspositionTable *table, uint64_t key,
+                        CachedOutcome outcome) {
+
+    if (outcome.samples == 0) return;
+
+    TranspositionBucket *bucket = &table->buckets[key & table->mask];
+    TranspositionSlot *target = NULL;
+    unsigned int fewest = UINT16_MAX + 1u;
+
+    for (int w = 0; w < TRANSPOSITION_WAYS; w++) {
+        TranspositionSlot *slot = &bucket->slots[w];
+        uint64_t data = atomic_load_explicit(&slot->data, memory_order_relaxed);
+        uint64_t check = atomic_load_explicit(&slot->check, memory_order_relaxed);
+        if (data == 0 || (check ^ data) == key) {
+            target = slot;
+            break;
+        }
+        unsigned int samples = (uint16_t)(data >> 32);
+        if (samples < fewest) {
+            fewest = samples;
+            target = slot;
+        }
+    }
+
+    uint64_t data = PackOutcome(outcome);
+    atomic_store_explicit(&target->check, key ^ data, memory_order_relaxed);
+    atomic_store_explicit(&target->data, data, memory_order_relaxed);
+}
@@ -0,0 +1,74 @@
+#ifndef POOL_ZOBRIST_H
+#define POOL_ZOBRIST_H
+
+// Zobrist hashing of table positions, and a transposition table keyed by
+// it so a shot search can reuse evaluations of positions it has already
+// seen.
+//
+// A position's hash is the XOR of one 64-bit key per feature: each ball
+// in its cell of a quantization grid (or in the pocket), the player to
+// shoot, both players' types and the rule state. Keys come from a
+// splitmix64 hash of the feature, so no key tables are stored and any
+// grid size works. Positions whose balls lie in the same cells hash
+// the same, which is what lets near-identical positions share an entry.
+// When a ball changes cell, its old key is XORed out and the new one
+// in, so updating after a shot costs one compare per ball plus two keys
+// per ball that moved.
+
+#include "pool_sim.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ZOBRIST_GRID 4.0f         // Default quantization step, pixels
+#define TRANSPOSITION_WAYS 4      // Slots per bucket, one cache line
+
+// Hash of a table and the quantized state it was built from
+typedef struct {
+    uint64_t hash;
+    float gridSize;               // Quantization step, pixels
+    int cols;                     // Grid columns across the table
+    int ballCount;
+    int cell[MAX_TABLE_BALLS];    // Grid cell of each ball, -1 if pocketed
+    int player;
+    GameState state;
+    PlayerType types[2];
+} TableHash;
+
+// What the search learned about a position
+typedef struct {
+    float score;                  // Mean evaluation
+    uint16_t samples;             // Rollouts behind the score, at least 1
+    uint16_t bestShot;            // Best candidate found, search-defined
+} CachedOutcome;
+
+// A slot holds key ^ data next to data. A reader accepts it only if the
+// XOR gives back its key, so a slot torn by two racing writers reads as
+// a miss and no lock is needed.
+typedef struct {
+    atomic_ullong check;
+    atomic_ullong data;           // Packed CachedOutcome, 0 if empty
+} TranspositionSlot;
+
+typedef struct {
+    _Alignas(64) TranspositionSlot slots[TRANSPOSITION_WAYS];
+} TranspositionBucket;
+
+typedef struct {
+    TranspositionBucket *buckets;
+    uint64_t mask;                // Bucket count - 1
+} TranspositionTable;
+
+void InitTableHash(TableHash *hash, const Game *game, float gridSize);
+uint64_t UpdateTableHash(TableHash *hash, const Game *game);
+uint64_t HashTablePosition(const Game *game, float gridSize);
+
+bool CreateTranspositionTable(TranspositionTable *table, size_t bytes);
+void FreeTranspositionTable(TranspositionTable *table);
+void ClearTranspositionTable(TranspositionTable *table);
+bool ProbeTransposition(const TranspositionTable *table, uint64_t key,
+                        CachedOutcome *outcome);
+void StoreTransposition(TranspositionTable *table, uint64_t key,
+                        CachedOutcome outcome);
+
+#endif // POOL_ZOBRIST_H
@@ -1,793 +1,909 @@
-#include "raylib.h"      // Raylib graphics library
-#include <math.h>        // For sqrtf, fabs, atan2 etc.
-#include <stdio.h>       // For sprintf
-#include <stdlib.h>
-#include <string.h>      // For strcpy
-#include <stdbool.h>     // For bool type
-
-// ---------------------- CONSTANT DEFINITIONS ----------------------
-
-#define MAX_BALLS 16              // Total balls including cue ball
-#define TABLE_WIDTH 800           // Table width
-#define TABLE_HEIGHT 400          // Table height
-#define BALL_RADIUS 15            // Radius of each ball
-#define POCKET_RADIUS 28          // Radius of pocket
-#define RAIL_WIDTH 40             // Thickness of table rail
-
-// Physics tuning parameters
-#define FRICTION 0.985f           // Friction multiplier per frame
-#define MIN_VELOCITY 0.06f        // Minimum velocity threshold to stop ball
-#define MAX_POWER_PIXELS 160.0f   // Maximum drag distance for power
-#define MAX_SHOT_SPEED 22.0f      // Maximum initial shot speed
-#define MAX_BALL_SPEED 26.0f      // Maximum speed any ball can have
-
-// ---------------------- ENUM TYPES ----------------------
-
-// Ball type classification
-typedef enum {
-    BALL_CUE,      // White cue ball
-    BALL_SOLID,    // Solid balls (1-7)
-    BALL_STRIPE,   // Stripe balls (9-15)
-    BALL_EIGHT     // Black 8-ball
-} BallType;
-
-// Game state tracking
-typedef enum {
-    GAME_START,
-    GAME_PLAYING,
-    GAME_SCRATCH,
-    GAME_WON,
-    GAME_LOST
-} GameState;
-
-// Player assigned type
-typedef enum {
-    PLAYER_NONE,
-    PLAYER_SOLIDS,
-    PLAYER_STRIPES
-} PlayerType;
-
-// ---------------------- STRUCT DEFINITIONS ----------------------
-
-// Ball structure
-typedef struct {
-    Vector2 position;     // Current position
-    Vector2 velocity;     // Current velocity
-    Color color;          // Ball color
-    BallType type;        // Ball type
-    int number;           // Ball number
-    bool pocketed;        // Is ball inside pocket
-    bool isStriped;       // Stripe flag
-} Ball;
-
-// Player structure
-typedef struct {
-    PlayerType type;      // Assigned type
-    int ballsRemaining;   // Balls left to clear
-    char name[20];        // Player name
-} Player;
-
-// Main Game structure
-typedef struct {
-    Ball balls[MAX_BALLS];        // All balls
-    Player players[2];            // Two players
-    int currentPlayer;            // Whose turn
-    GameState state;              // Current state
-
-    Vector2 cueBallPos;           // Cue ball respawn position
-    float power;                  // Current shot power
-    bool aiming;                  // Is player dragging
-    bool ballsMoving;             // Are balls in motion
-    bool firstShot;               // Break shot flag
-    bool assignedTypes;           // Are solids/stripes assigned
-
-    char statusMessage[100];      // UI message
-
-    // Cue stick mechanics
-    Vector2 dragStart;            
-    float stickPullPixels;        
-    float stickLength;            
-    bool stickRecoil;
-    float recoilTimer;
-} Game;
-
-// ---------------------- FUNCTION PROTOTYPES ----------------------
-
-void InitGame(Game *game);
-void ResetBalls(Game *game);
-void UpdateGame(Game *game);
-void DrawGame(Game *game);
-void HandleInput(Game *game);
-void UpdatePhysics(Game *game);
-void CheckCollisions(Game *game);
-void CheckPockets(Game *game);
-void CheckWinCondition(Game *game);
-void NextTurn(Game *game);
-void ApplyScratch(Game *game);
-void DrawPowerBar(Game *game);
-void DrawTable();
-bool AreBallsMoving(Game *game);
-float Distance(Vector2 a, Vector2 b);
-int playerIndexForType(Game *game, BallType btype);
-void ResolveElasticCollision(Ball *a, Ball *b);
-void ClampBallSpeed(Ball *b, float maxSpeed);
-
-// ---------------------- GAME INITIALIZATION ----------------------
-
-void InitGame(Game *game) {
-
-    // Initialize player names and starting state
-    strcpy(game->players[0].name, "Player 1");
-    game->players[0].type = PLAYER_NONE;
-    game->players[0].ballsRemaining = 7;
-
-    strcpy(game->players[1].name, "Player 2");
-    game->players[1].type = PLAYER_NONE;
-    game->players[1].ballsRemaining = 7;
-
-    game->currentPlayer = 0;
-    game->state = GAME_START;
-
-    game->power = 0.0f;
-    game->aiming = false;
-    game->ballsMoving = false;
-    game->firstShot = true;
-    game->assignedTypes = false;
-
-    strcpy(game->statusMessage, 
-        "Break shot: click on cue, drag back, release to shoot");
-
-    // Cue stick initial settings
-    game->stickPullPixels = 0.0f;
-    game->stickLength = 120.0f;
-    game->stickRecoil = false;
-    game->recoilTimer = 0.0f;
-
-    // Arrange balls
-    ResetBalls(game);
-}
-
-// ---------------------- BALL SETUP ----------------------
-
-void ResetBalls(Game *game) {
-
-    // Triangle rack starting position
-    Vector2 triangleStart = { TABLE_WIDTH * 0.72f, TABLE_HEIGHT * 0.5f };
-
-    // Setup cue ball
-    game->balls[0].position = 
-        (Vector2){ TABLE_WIDTH * 0.25f, TABLE_HEIGHT * 0.5f };
-    game->balls[0].velocity = (Vector2){0, 0};
-    game->balls[0].color = WHITE;
-    game->balls[0].type = BALL_CUE;
-    game->balls[0].number = 0;
-    game->balls[0].pocketed = false;
-    game->balls[0].isStriped = false;
-
-    // Define colors
-    Color solidColors[] = { YELLOW, BLUE, RED, PURPLE, 
-                            ORANGE, GREEN, MAROON };
-    Color stripeColors[] = { YELLOW, BLUE, RED, PURPLE, 
-                             ORANGE, GREEN, MAROON };
-
-    int idx = 1;
-
-    // Create triangle formation
-    
-    for (int row = 0; row < 5; row++) {
-        for (int col = 0; col <= row; col++) {
-
-            if (idx >= MAX_BALLS) break;
-
-            float offsetX = row * (BALL_RADIUS * 2 * 0.88f);
-            float offsetY = (col * (BALL_RADIUS * 2)) 
-                            - (row * BALL_RADIUS);
-
-            game->balls[idx].position = 
-                (Vector2){ triangleStart.x + offsetX,
-                           triangleStart.y + offsetY };
-
-            game->balls[idx].velocity = (Vector2){0,0};
-            game->balls[idx].pocketed = false;
-
-            // Assign ball types
-            if (idx == 8) {
-                game->balls[idx].color = BLACK;
-                game->balls[idx].type = BALL_EIGHT;
-                game->balls[idx].isStriped = false;
-            }
-            else if (idx <= 7) {
-                game->balls[idx].color = solidColors[idx-1];
-                game->balls[idx].type = BALL_SOLID;
-                game->balls[idx].isStriped = false;
-            }
-            else {
-                int sidx = idx - 9;
-                if (sidx < 0) sidx = 0;
-                game->balls[idx].color = stripeColors[sidx];
-                game->balls[idx].type = BALL_STRIPE;
-                game->balls[idx].isStriped = true;
-            }
-            game->balls[idx].number = idx;
-            idx++;
-        }
-    }
-
-    game->cueBallPos = game->balls[0].position;
-}
-
-// ---------------------- PHYSICS UPDATE ----------------------
-
-void UpdatePhysics(Game *game) {
-
-    for (int i = 0; i < MAX_BALLS; i++) {
-
-        if (game->balls[i].pocketed) continue;
-
-        // Update position
-        game->balls[i].position.x += game->balls[i].velocity.x;
-        game->balls[i].position.y += game->balls[i].velocity.y;
-
-        // Apply friction
-        game->balls[i].velocity.x *= FRICTION;
-        game->balls[i].velocity.y *= FRICTION;
-
-        // Stop tiny velocities
-        if (fabs(game->balls[i].velocity.x) < MIN_VELOCITY)
-            game->balls[i].velocity.x = 0;
-        if (fabs(game->balls[i].velocity.y) < MIN_VELOCITY)
-            game->balls[i].velocity.y = 0;
-
-        // Rail collision (bounce effect)
-        if (game->balls[i].position.x - BALL_RADIUS < RAIL_WIDTH) {
-            game->balls[i].position.x = RAIL_WIDTH + BALL_RADIUS;
-            game->balls[i].velocity.x *= -0.86f;
-        }
-        if (game->balls[i].position.x + BALL_RADIUS >
-            TABLE_WIDTH - RAIL_WIDTH) {
-            game->balls[i].position.x =
-                TABLE_WIDTH - RAIL_WIDTH - BALL_RADIUS;
-            game->balls[i].velocity.x *= -0.86f;
-        }
-        if (game->balls[i].position.y - BALL_RADIUS < RAIL_WIDTH) {
-            game->balls[i].position.y = RAIL_WIDTH + BALL_RADIUS;
-            game->balls[i].velocity.y *= -0.86f;
-        }
-        if (game->balls[i].position.y + BALL_RADIUS >
-            TABLE_HEIGHT - RAIL_WIDTH) {
-            game->balls[i].position.y =
-                TABLE_HEIGHT - RAIL_WIDTH - BALL_RADIUS;
-            game->balls[i].velocity.y *= -0.86f;
-        }
-
-        // Limit maximum speed
-        ClampBallSpeed(&game->balls[i], MAX_BALL_SPEED);
-    }
-
-    // Ball-to-ball collision
-    CheckCollisions(game);
-
-    // Check pocketing
-    CheckPockets(game);
-}
-
-// ---------------------- MAIN FUNCTION ----------------------
-
-int main(void) {
-
-    // Create game window
-
-    InitWindow(TABLE_WIDTH, TABLE_HEIGHT + 100,"8 Ball Pool - Drag to Charge (Fixed)");
-    SetTargetFPS(60);
-    Game game;
-    InitGame(&game);
-
-    // Main game loop
-
-    while (!WindowShouldClose()) {
-        UpdateGame(&game);   // Update logic
-        DrawGame(&game);     // Draw everything
-    }
-    CloseWindow();
-    return 0;
-}
-
-void UpdateGame(Game *game) {
-
-    // Handle keyboard & mouse input
-    HandleInput(game);
-
-    // Handle cue stick recoil animation after shot
-    if (game->stickRecoil) {
-
-        // Reduce recoil timer per frame (60 FPS assumption)
-        game->recoilTimer -= 1.0f/60.0f;
-
-        // When recoil ends, reset stick pull
-        if (game->recoilTimer <= 0.0f) {
-            game->stickRecoil = false;
-            game->stickPullPixels = 0.0f;
-        } 
-        else {
-            // Gradually reduce pull distance visually
-            game->stickPullPixels *= 0.92f;
-
-            // Update power based on pull distance
-            game->power = game->stickPullPixels / MAX_POWER_PIXELS;
-            if (game->power < 0) game->power = 0;
-        }
-    }
-
-    // Only update physics during play or scratch state
-    if (game->state == GAME_PLAYING || 
-        game->state == GAME_SCRATCH) {
-        UpdatePhysics(game);
-
-        // Detect start of ball movement
-        if (!game->ballsMoving && 
-            AreBallsMoving(game)) 
-            game->ballsMoving = true;
-
-        // Detect stop of all balls
-        if (game->ballsMoving && 
-            !AreBallsMoving(game)) {
-            game->ballsMoving = false;
-
-            // When balls stop
-            if (game->state == GAME_PLAYING) {
-                CheckWinCondition(game);
-                if (game->state != GAME_WON &&
-                    game->state != GAME_LOST) {
-                    NextTurn(game);
-                }
-            }
-        }
-    }
-}
-
-void HandleInput(Game *game) {
-
-    // Restart game anytime by pressing R
-    if (IsKeyPressed(KEY_R)) {
-        InitGame(game);
-        return;
-    }
-
-    Vector2 mousePos = GetMousePosition();
-
-    // -------- SCRATCH MODE --------
-    if (game->state == GAME_SCRATCH) {
-
-        // Player can place cue ball inside valid area
-
-        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-            if (mousePos.x > RAIL_WIDTH + BALL_RADIUS &&
-                mousePos.x < TABLE_WIDTH - RAIL_WIDTH - BALL_RADIUS &&
-                mousePos.y > RAIL_WIDTH + BALL_RADIUS &&
-                mousePos.y < TABLE_HEIGHT - RAIL_WIDTH - BALL_RADIUS) {
-                game->cueBallPos = mousePos;
-                game->balls[0].position = game->cueBallPos;
-                game->balls[0].pocketed = false;
-                game->balls[0].velocity = (Vector2){0,0};
-                game->state = GAME_PLAYING;
-                sprintf(game->statusMessage, "Cue placed. %s's turn",game->players[game->currentPlayer].name);
-            }
-            else {
-                strcpy(game->statusMessage, "Invalid position! Place inside rails");
-            }
-        }
-        return;
-    }
-
-    // Ignore input if balls are moving
-    if (game->ballsMoving) return;
-    Vector2 cueBallPos = 
-        game->balls[0].pocketed ?
-        game->cueBallPos :
-        game->balls[0].position;
-
-    // Start drag if clicking near cue ball
-    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-        if (Distance(mousePos, cueBallPos) <= BALL_RADIUS*1.6f) {
-            game->aiming = true;
-            game->dragStart = mousePos;
-            game->stickPullPixels = 0.0f;
-            game->power = 0.0f;
-        }
-    }
-
-    // While dragging mouse
-
-    if (IsMouseButtonDown(MOUSE_LEFT_BUTTON) && 
-        game->aiming) {
-        float d = Distance(mousePos, cueBallPos);
-        if (d > MAX_POWER_PIXELS)
-            d = MAX_POWER_PIXELS;
-        game->stickPullPixels = d;
-        game->power = d / MAX_POWER_PIXELS;
-    }
-
-    // Release mouse → shoot
-
-    if (game->aiming &&
-        IsMouseButtonReleased(MOUSE_LEFT_BUTTON)) {
-        game->aiming = false;
-        Vector2 dir = {
-            mousePos.x - cueBallPos.x,
-            mousePos.y - cueBallPos.y
-        };
-        float len = sqrtf(dir.x*dir.x + dir.y*dir.y);
-        if (len < 0.001f) return;
-        dir.x /= len;
-        dir.y /= len;
-        float shotSpeed =
-            (game->stickPullPixels / MAX_POWER_PIXELS)
-            * MAX_SHOT_SPEED;
-        if (shotSpeed > MAX_SHOT_SPEED)
-            shotSpeed = MAX_SHOT_SPEED;
-
-        // Apply velocity to cue ball
-
-        game->balls[0].velocity.x =
-            dir.x * shotSpeed;
-        game->balls[0].velocity.y =
-            dir.y * shotSpeed;
-        game->state = GAME_PLAYING;
-        game->firstShot = false;
-
-        // Start recoil animation
-
-        game->stickRecoil = true;
-        game->recoilTimer = 0.12f;
-
-        game->power = 0.0f;
-    }
-}
-
-void CheckCollisions(Game *game) {
-
-    // Compare each ball with every other ball
-    for (int i = 0; i < MAX_BALLS; i++) {
-        if (game->balls[i].pocketed) continue;
-        for (int j = i+1; j < MAX_BALLS; j++) {
-            if (game->balls[j].pocketed) continue;
-
-            // Calculate distance between ball centers
-            float dist = Distance(
-                game->balls[i].position,
-                game->balls[j].position);
-            float minDist = BALL_RADIUS * 2.0f;
-
-            // If balls overlap → collision occurred
-            if (dist < minDist && dist > 0.0001f) {
-
-                // Calculate overlap amount
-                float overlap = 0.5f * (minDist - dist + 0.001f);
-
-                // Normal direction between balls
-                Vector2 normal = {
-                    (game->balls[j].position.x -
-                     game->balls[i].position.x) / dist,
-                    (game->balls[j].position.y -
-                     game->balls[i].position.y) / dist
-                };
-
-                // Push balls apart equally
-                game->balls[i].position.x -= normal.x * overlap;
-                game->balls[i].position.y -= normal.y * overlap;
-                game->balls[j].position.x += normal.x * overlap;
-                game->balls[j].position.y += normal.y * overlap;
-
-                // Apply elastic collision physics
-                ResolveElasticCollision(
-                    &game->balls[i],
-                    &game->balls[j]);
-
-                // Clamp speeds to avoid unrealistic speed
-                ClampBallSpeed(&game->balls[i],
-                               MAX_BALL_SPEED);
-                ClampBallSpeed(&game->balls[j],
-                               MAX_BALL_SPEED);
-            }
-        }
-    }
-}
-
-void ResolveElasticCollision(Ball *a, Ball *b) {
-
-    // Compute normal vector
-    float dx = b->position.x - a->position.x;
-    float dy = b->position.y - a->position.y;
-    float dist = sqrtf(dx*dx + dy*dy);
-    if (dist <= 0.0001f) return;
-    float nx = dx / dist;
-    float ny = dy / dist;
-
-    // Tangent vector
-    float tx = -ny;
-    float ty = nx;
-
-    // Project velocities onto normal and tangent
-
-    float va_n = a->velocity.x * nx +
-                 a->velocity.y * ny;
-    float va_t = a->velocity.x * tx +
-                 a->velocity.y * ty;
-    float vb_n = b->velocity.x * nx +
-                 b->velocity.y * ny;
-    float vb_t = b->velocity.x * tx +
-                 b->velocity.y * ty;
-
-    // Equal mass elastic collision:
-    // Swap normal components
-
-    float va_n_after = vb_n;
-    float vb_n_after = va_n;
-
-    // Convert back to vector form
-
-    a->velocity.x = va_n_after * nx +
-                    va_t * tx;
-    a->velocity.y = va_n_after * ny +
-                    va_t * ty;
-    b->velocity.x = vb_n_after * nx +
-                    vb_t * tx;
-    b->velocity.y = vb_n_after * ny +
-                    vb_t * ty;
-}
-
-void CheckPockets(Game *game) {
-
-    // Define 6 pocket positions
-
-    Vector2 pockets[] = {
-        {RAIL_WIDTH, RAIL_WIDTH},
-        {TABLE_WIDTH*0.5f, RAIL_WIDTH},
-        {TABLE_WIDTH - RAIL_WIDTH, RAIL_WIDTH},
-        {RAIL_WIDTH, TABLE_HEIGHT - RAIL_WIDTH},
-        {TABLE_WIDTH*0.5f, TABLE_HEIGHT - RAIL_WIDTH},
-        {TABLE_WIDTH - RAIL_WIDTH, TABLE_HEIGHT - RAIL_WIDTH}
-    };
-    bool cueBallPocketed = false;
-    bool anyPocketed = false;
-    for (int i = 0; i < MAX_BALLS; i++) {
-        if (game->balls[i].pocketed) continue;
-        for (int p = 0; p < 6; p++) {
-
-            // If ball center inside pocket radius
-
-            if (Distance(game->balls[i].position,
-                         pockets[p]) < POCKET_RADIUS) {
-                game->balls[i].pocketed = true;
-                game->balls[i].velocity = (Vector2){0,0};
-                anyPocketed = true;
-                // Cue ball scratch
-
-                if (i == 0) {
-                    cueBallPocketed = true;
-                    game->cueBallPos = (Vector2){ TABLE_WIDTH * 0.25f, TABLE_HEIGHT * 0.5f };
-                }
-                else {
-                    // 8-ball logic
-                    if (game->balls[i].type == BALL_EIGHT) {
-                        int myIdx = game->currentPlayer;
-                        if ((game->players[myIdx].type
-                             == PLAYER_SOLIDS &&
-                             game->players[myIdx].ballsRemaining == 0)
-                            ||
-                            (game->players[myIdx].type
-                             == PLAYER_STRIPES &&
-                             game->players[myIdx].ballsRemaining == 0)) {
-
-                            game->state = GAME_WON;
-                        }
-                        else {
-                            game->state = GAME_LOST;
-                        }
-                        return;
-                    }
-                }
-                break;
-            }
-        }
-    }
-
-    if (cueBallPocketed)
-        ApplyScratch(game);
-
-    if (anyPocketed) {
-        sprintf(game->statusMessage,
-            "%s pocketed a ball!",
-            game->players[game->currentPlayer].name);
-    }
-}
-
-void ApplyScratch(Game *game) {
-    game->state = GAME_SCRATCH;
-    strcpy(game->statusMessage,
-           "Scratch! Place cue ball");
-
-    // Switch turn to opponent
-    game->currentPlayer =
-        1 - game->currentPlayer;
-}
-
-void CheckWinCondition(Game *game) {
-    int idx = game->currentPlayer;
-    if ((game->players[idx].type ==
-         PLAYER_SOLIDS &&
-         game->players[idx].ballsRemaining == 0)
-        ||
-        (game->players[idx].type ==
-         PLAYER_STRIPES &&
-         game->players[idx].ballsRemaining == 0)) {
-        strcpy(game->statusMessage,"Shoot the 8-ball!");
-    }
-}
-
-void NextTurn(Game *game) {
-
-    // Switch player
-    game->currentPlayer =
-        1 - game->currentPlayer;
-    sprintf(game->statusMessage,
-        "%s's turn",game->players[game->currentPlayer].name);
-}
-
-bool AreBallsMoving(Game *game) {
-    for (int i = 0; i < MAX_BALLS; i++) {
-        if (game->balls[i].pocketed)
-            continue;
-        if (fabs(game->balls[i].velocity.x)
-            > MIN_VELOCITY ||
-            fabs(game->balls[i].velocity.y)
-            > MIN_VELOCITY)
-            return true;
-    }
-    return false;
-}
-
-float Distance(Vector2 a, Vector2 b) {
-    float dx = a.x - b.x;
-    float dy = a.y - b.y;
-    return sqrtf(dx*dx + dy*dy);
-}
-
-void ClampBallSpeed(Ball *b,float maxSpeed) {
-    float sx = b->velocity.x;
-    float sy = b->velocity.y;
-    float mag = sqrtf(sx*sx + sy*sy);
-    if (mag > maxSpeed) {
-        b->velocity.x =
-            (b->velocity.x / mag)* maxSpeed;
-        b->velocity.y =(b->velocity.y / mag) * maxSpeed;
-    }
-}
-
-void DrawTable() {
-    BeginDrawing();
-    ClearBackground(DARKGREEN);
-
-    // Draw wooden outer border
-    DrawRectangle(0, 0, TABLE_WIDTH, TABLE_HEIGHT, BROWN);
-
-    // Draw inner table (playing surface)
-    DrawRectangle(RAIL_WIDTH, RAIL_WIDTH,
-                  TABLE_WIDTH - 2*RAIL_WIDTH,
-                  TABLE_HEIGHT - 2*RAIL_WIDTH,
-                  DARKGREEN);
-
-    // Draw pockets (6 total)
-    Vector2 pockets[] = {
-        {RAIL_WIDTH, RAIL_WIDTH},
-        {TABLE_WIDTH*0.5f, RAIL_WIDTH},
-        {TABLE_WIDTH - RAIL_WIDTH, RAIL_WIDTH},
-        {RAIL_WIDTH, TABLE_HEIGHT - RAIL_WIDTH},
-        {TABLE_WIDTH*0.5f, TABLE_HEIGHT - RAIL_WIDTH},
-        {TABLE_WIDTH - RAIL_WIDTH, TABLE_HEIGHT - RAIL_WIDTH}
-    };
-
-    for (int i = 0; i < 6; i++) {
-        DrawCircleV(pockets[i], POCKET_RADIUS, BLACK);
-    }
-}
-//------------------------ Draws the power bar UI showing the current shot power-------------------
-
-void DrawPowerBar(Game *game) {
-
-    float barWidth = 300;
-    float barHeight = 20;
-    float x = (TABLE_WIDTH - barWidth) / 2;
-    float y = TABLE_HEIGHT + 40;
-
-    // Outline
-    DrawRectangleLines(x, y, barWidth, barHeight, WHITE);
-
-    // Fill based on power
-
-    DrawRectangle(x, y,
-                  barWidth * game->power,
-                  barHeight,
-                  RED);
-    DrawText("Power", x - 60, y,20,  WHITE);
-}
-
-//-----------------Draws the entire game scene: table, balls, aiming line, UI, status, and power bar-------------
-
-void DrawGame(Game *game) {
-    DrawTable();
-
-    // Draw balls
-    for (int i = 0; i < MAX_BALLS; i++) {
-        if (game->balls[i].pocketed)
-            continue;
-
-        // Draw ball body
-        DrawCircleV(game->balls[i].position,
-                    BALL_RADIUS,
-                    game->balls[i].color);
-
-        // Draw stripe if striped ball
-        if (game->balls[i].isStriped) {
-            DrawCircleLines(
-                game->balls[i].position.x,
-                game->balls[i].position.y,
-                BALL_RADIUS,
-                WHITE);
-        }
-
-        // Draw ball number (except cue ball)
-
-        if (game->balls[i].number != 0) {
-            char num[3];
-            sprintf(num, "%d",
-                    game->balls[i].number);
-            DrawText(num,
-                game->balls[i].position.x - 6,
-                game->balls[i].position.y - 6,
-                12,
-                WHITE);
-        }
-    }
-
-    // Draw aiming line
-    if (game->aiming && !game->ballsMoving) {
-        Vector2 cuePos = game->balls[0].position;
-        Vector2 mouse = GetMousePosition();
-        DrawLineV(cuePos, mouse, WHITE);
-    }
-
-    // Draw UI area background
-    DrawRectangle(0, TABLE_HEIGHT,
-                  TABLE_WIDTH, 100,
-                  DARKGRAY);
-
-    // Draw status message
-    DrawText(game->statusMessage,
-             20,
-             TABLE_HEIGHT + 10,
-             20,
-             WHITE);
-
-    // Draw power bar
-    DrawPowerBar(game);
-
-    EndDrawing();
-}
-
-//----------------- Returns the index of the player assigned to the given ball type------------
-int playerIndexForType(Game *game, BallType btype) {
-    if (btype == BALL_SOLID) {
-        if (game->players[0].type == PLAYER_SOLIDS)
-            return 0;
-        if (game->players[1].type == PLAYER_SOLIDS)
-            return 1;
-    }
-    if (btype == BALL_STRIPE) {
-        if (game->players[0].type == PLAYER_STRIPES)
-            return 0;
-        if (game->players[1].type == PLAYER_STRIPES)
-            return 1;
-    }
-    return -1;  // Not assigned
-}
\ No newline at end of file
+#include "raylib.h"      // Raylib graphics library
+#include "pool_sim.h"    // Headless table simulation
+#include "pool_profile.h" // Frame profiler (debug builds)
+#include "pool_trace.h"  // Chrome trace export (--trace)
+#include "pool_replay.h" // Game recording and playback (--record, --replay)
+#include "pool_trajectory.h" // Frame-by-frame recordings (--frames, --play-frames)
+#include "pool_snapshot.h" // Quick save and load (F5, F9)
+#include "pool_ai_worker.h" // Computer opponent on its own thread (--ai)
+#include "pool_physics_thread.h" // Physics on its own thread (--physics-thread)
+#include <math.h>        // For powf
+#include <stdio.h>       // For sprintf, fprintf
+#include <stdlib.h>      // For atoi, strtof
+#include <string.h>      // For strcmp, strcpy
+
+// Longest frame the physics clock will catch up on; anything beyond
+// this (debugger pause, window drag) is dropped instead of replayed
+#define MAX_FRAME_TIME 0.25f
+
+#define QUICKSAVE_PATH "quicksave.8bs"
+
+#ifdef PROFILE_ENABLED
+// Profiler overlay in the UI strip, toggled with F3
+static bool showProfiler = false;
+#endif
+
+// Recording of the game being played (--record) or playback of a
+// recorded one (--replay)
+static ReplayWriter recorder;
+static bool recording = false;
+static ReplayReader player;
+static bool replaying = false;
+static bool replayPaused = false;
+
+// Aim preview: the cue ball's path, the ghost ball at the first contact
+// and the directions after it. Only recomputed when the mouse moves.
+#define AIM_LINE_LENGTH 80.0f     // Preview lines for a ball taking all the speed
+typedef struct {
+    bool valid;
+    Vector2 mouse;                // Aim it was computed for
+    Vector2 cue;
+    bool hasShot;
+    RollPrediction roll;
+    ContactPrediction contact;
+    bool hit;
+} AimPreview;
+static AimPreview aimPreview;
+
+// Computer opponent (--ai 1|2, --ai-time seconds, --ai-search tree for
+// the tree search). It searches on its own thread; the game only posts
+// requests and polls for the answer, so frames never wait on it.
+static int computerPlayer = -1;
+static AIConfig aiConfig;
+static bool aiTree = false;
+static AIWorker aiWorker;
+static bool aiThinking = false;           // Waiting for aiRequest
+static unsigned int aiRequest;
+static unsigned int aiFallbackSeed = 1u;  // Random shots when it cannot search
+
+// Every drawn frame saved (--frames) or played back (--play-frames)
+#define FRAMES_FAST_FORWARD 10    // Frames shown per frame while RIGHT is held
+static FILE *framesFile = NULL;
+static TrajectoryEncoder frameEncoder;
+static TrajectoryDecoder frameDecoder;
+static bool framesRecording = false;
+static bool framesPlaying = false;
+
+// Physics on its own thread (--physics-thread). game is then the game
+// thread's view: the newest step read from the physics thread, plus the
+// shots and tables played since, which are sent on to it.
+static bool physicsThreaded = false;
+static PhysicsThread physicsThread;
+static double physicsFrameTime;           // Physics clock of the step in view
+static char physicsStatus[100];           // Status line of the last step read
+static bool physicsTablePending = false;  // Restart or load still to send
+
+// Table colours, cycled with T
+typedef struct {
+    const char *name;
+    Color rail;
+    Color felt;
+    Color pocket;
+    Color strip;                  // UI area under the table
+} TableTheme;
+static const TableTheme themes[] = {
+    { "Classic", BROWN, DARKGREEN, BLACK, DARKGRAY },
+    { "Tournament", DARKBROWN, DARKBLUE, BLACK, DARKGRAY }
+};
+#define THEME_COUNT ((int)(sizeof themes / sizeof themes[0]))
+static int currentTheme = 0;
+
+// Rails, felt, pockets and the UI strip never change during play, so
+// they are drawn once into textures that are copied to the screen every
+// frame: one layer for the table, one for the strip under it. Each
+// layer remembers the theme colours it was drawn with and is redrawn
+// only when one of its own colours changes.
+#define LAYER_COLORS 3
+typedef struct {
+    RenderTexture2D texture;
+    bool loaded;
+    Color colors[LAYER_COLORS];   // Theme colours it was drawn with
+} TableLayer;
+static TableLayer tableLayer;     // Rails, felt and pockets
+static TableLayer stripLayer;     // UI strip background
+
+// Every ball face (colour, stripe ring and number) drawn once at
+// startup into a row of cells, one per ball number. Balls are then
+// copied from it, and consecutive copies from one texture go out as a
+// single batch of quads. Cells leave room around the ball so bilinear
+// filtering at fractional positions never reads a neighbour.
+#define BALL_CELL (2 * BALL_RADIUS + 4)   // Atlas cell size in pixels
+static RenderTexture2D ballAtlas;
+
+// ---------------------- FUNCTION PROTOTYPES ----------------------
+
+void UpdateGame(Game *game, float frameTime);
+void DrawGame(Game *game);
+void HandleInput(Game *game);
+void HandleReplayInput(Game *game);
+void HandleComputerTurn(Game *game);
+void PollComputerShot(Game *game);
+void CancelComputer(void);
+void SetComputerPlayer(Game *game);
+void PlayFrames(Game *game);
+bool PlayShot(Game *game, ShotParams shot);
+bool PlayPlacement(Game *game, Vector2 position);
+void TableReplaced(Game *game);
+void ReadPhysicsView(Game *game);
+void DrawPowerBar(Game *game);
+void DrawAimPreview(Game *game);
+void DrawTable();
+void DrawStaticTable(const TableTheme *theme);
+void DrawStrip(const TableTheme *theme);
+void UpdateTableLayer(void);
+void UpdateLayer(TableLayer *layer, int width, int height, const Color *colors,
+                 int colorCount, void (*draw)(const TableTheme *theme));
+void LoadBallAtlas(const Game *game);
+Color BallColor(const Ball *ball);
+#ifdef PROFILE_ENABLED
+void DrawProfiler(void);
+#endif
+
+// ---------------------- MAIN FUNCTION ----------------------
+
+int main(int argc, char **argv) {
+
+    Game game;
+    InitGame(&game);
+    DefaultAIConfig(&aiConfig);
+
+    // --trace <file> records a Chrome trace of every frame, --record
+    // <file> saves the shots played and --replay <file> plays them back;
+    // --frames and --play-frames do the same for every drawn frame
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--ai") == 0)
+            computerPlayer = atoi(argv[i + 1]) - 1;
+        if (strcmp(argv[i], "--ai-time") == 0)
+            aiConfig.budget = strtof(argv[i + 1], NULL);
+        if (strcmp(argv[i], "--ai-search") == 0)
+            aiTree = strcmp(argv[i + 1], "tree") == 0;
+        if (strcmp(argv[i], "--trace") == 0 && !StartTrace(argv[i + 1]))
+            fprintf(stderr, "Could not start trace %s\n", argv[i + 1]);
+        if (strcmp(argv[i], "--record") == 0) {
+            recording = OpenReplayWriter(&recorder, argv[i + 1], &game);
+            if (!recording)
+                fprintf(stderr, "Could not record to %s\n", argv[i + 1]);
+        }
+        if (strcmp(argv[i], "--replay") == 0) {
+            replaying = OpenReplay(&player, argv[i + 1]) &&
+                        SeekReplay(&player, &game, 0);
+            if (!replaying)
+                fprintf(stderr, "Could not replay %s\n", argv[i + 1]);
+        }
+        if (strcmp(argv[i], "--frames") == 0 && framesFile == NULL) {
+            framesFile = fopen(argv[i + 1], "wb");
+            framesRecording = framesFile != NULL &&
+                StartTrajectory(&frameEncoder, framesFile, &game, BASE_FRAME_HZ);
+            if (!framesRecording)
+                fprintf(stderr, "Could not record frames to %s\n", argv[i + 1]);
+        }
+        if (strcmp(argv[i], "--play-frames") == 0 && framesFile == NULL) {
+            framesFile = fopen(argv[i + 1], "rb");
+            framesPlaying = framesFile != NULL &&
+                            OpenTrajectory(&frameDecoder, framesFile);
+            if (!framesPlaying)
+                fprintf(stderr, "Could not play frames from %s\n", argv[i + 1]);
+        }
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--physics-thread") == 0)
+            physicsThreaded = true;
+    }
+
+    if (computerPlayer == 0 || computerPlayer == 1) {
+        if (StartAIWorker(&aiWorker, &aiConfig, aiTree)) {
+            SetComputerPlayer(&game);
+        }
+        else {
+            fprintf(stderr, "Could not start the computer's thread\n");
+            computerPlayer = -1;
+        }
+    }
+
+    // Playback drives the table from the game loop
+    if (physicsThreaded && (replaying || framesPlaying)) {
+        fprintf(stderr, "--physics-thread is ignored during playback\n");
+        physicsThreaded = false;
+    }
+    if (physicsThreaded) {
+        physicsFrameTime = PhysicsClock();
+        strcpy(physicsStatus, game.statusMessage);
+        if (!StartPhysicsThread(&physicsThread, &game)) {
+            fprintf(stderr, "Could not start the physics thread\n");
+            physicsThreaded = false;
+        }
+    }
+
+    // Create game window
+
+    InitWindow(TABLE_WIDTH, TABLE_HEIGHT + 100,"8 Ball Pool - Drag to Charge (Fixed)");
+    SetTargetFPS(60);
+    LoadBallAtlas(&game);
+
+    // Main game loop
+
+    while (!WindowShouldClose()) {
+        if (framesPlaying)
+            PlayFrames(&game);               // Recorded frames instead of play
+        else
+            UpdateGame(&game, GetFrameTime());   // Update logic
+        if (framesRecording)
+            EncodeTrajectoryFrame(&frameEncoder, &game);
+        DrawGame(&game);     // Draw everything
+        PROFILE_END_FRAME();
+    }
+    StopTrace();
+    if (recording) CloseReplayWriter(&recorder);
+    if (replaying) CloseReplay(&player);
+    if (framesFile != NULL) fclose(framesFile);
+    if (computerPlayer >= 0) StopAIWorker(&aiWorker);
+    if (physicsThreaded) StopPhysicsThread(&physicsThread);
+    if (tableLayer.loaded) UnloadRenderTexture(tableLayer.texture);
+    if (stripLayer.loaded) UnloadRenderTexture(stripLayer.texture);
+    UnloadRenderTexture(ballAtlas);
+    CloseWindow();
+    return 0;
+}
+
+void UpdateGame(Game *game, float frameTime) {
+
+    TRACE_BEGIN("UpdateGame");
+
+    if (frameTime > MAX_FRAME_TIME)
+        frameTime = MAX_FRAME_TIME;
+
+    // Handle keyboard & mouse input, and the computer's answer
+    PROFILE_BEGIN(PROFILE_INPUT);
+    HandleInput(game);
+    if (computerPlayer >= 0) PollComputerShot(game);
+    PROFILE_END(PROFILE_INPUT);
+
+    // Handle cue stick recoil animation after shot
+    if (game->stickRecoil) {
+
+        // Reduce recoil timer by the real frame time
+        game->recoilTimer -= frameTime;
+
+        // When recoil ends, reset stick pull
+        if (game->recoilTimer <= 0.0f) {
+            game->stickRecoil = false;
+            game->stickPullPixels = 0.0f;
+        } 
+        else {
+            // Gradually reduce pull distance visually (0.92 per 60 Hz frame)
+            game->stickPullPixels *= powf(0.92f, frameTime * BASE_FRAME_HZ);
+
+            // Update power based on pull distance
+            game->power = game->stickPullPixels / MAX_POWER_PIXELS;
+            if (game->power < 0) game->power = 0;
+        }
+    }
+
+    // The physics thread keeps its own clock. Until a restart or load
+    // reaches it, its frames show the old table and are not read.
+    if (physicsThreaded) {
+        if (physicsTablePending)
+            physicsTablePending = !SendPhysicsTable(&physicsThread, game);
+        if (!physicsTablePending) ReadPhysicsView(game);
+        TRACE_END("UpdateGame");
+        return;
+    }
+
+    // Run as many fixed physics steps as the elapsed time covers; the
+    // remainder carries over and is used to interpolate the drawing
+    float stepSeconds = 1.0f / game->physicsHz;
+    game->accumulator += frameTime;
+    while (game->accumulator >= stepSeconds) {
+        for (int i = 0; i < game->ballCount; i++)
+            game->previousPositions[i] = game->balls[i].position;
+
+        // Physics and end-of-shot rules
+        StepSimulation(game);
+        game->accumulator -= stepSeconds;
+    }
+
+    TRACE_END("UpdateGame");
+}
+
+void HandleInput(Game *game) {
+
+#ifdef PROFILE_ENABLED
+    if (IsKeyPressed(KEY_F3))
+        showProfiler = !showProfiler;
+#endif
+
+    if (IsKeyPressed(KEY_T))
+        currentTheme = (currentTheme + 1) % THEME_COUNT;
+
+    if (replaying) {
+        HandleReplayInput(game);
+        return;
+    }
+
+    // Quick save and load, at any moment, balls in motion included. A
+    // recording carries on: the next keyframe picks up the loaded table.
+    if (IsKeyPressed(KEY_F5)) {
+        strcpy(game->statusMessage, SaveSnapshotFile(game, QUICKSAVE_PATH) ?
+               "Game saved (F9 to load)" : "Could not save the game");
+        return;
+    }
+    if (IsKeyPressed(KEY_F9)) {
+        if (LoadSnapshotFile(game, QUICKSAVE_PATH)) {
+            TableReplaced(game);
+            if (recording) RecordRestart(&recorder);
+            CancelComputer();
+        }
+        else {
+            strcpy(game->statusMessage, "No saved game to load");
+        }
+        return;
+    }
+
+    // Restart game anytime by pressing R
+    if (IsKeyPressed(KEY_R)) {
+        InitGame(game);
+        SetComputerPlayer(game);
+        TableReplaced(game);
+        if (recording) RecordRestart(&recorder);
+        CancelComputer();
+        return;
+    }
+
+    if (game->players[game->currentPlayer].computer) {
+        HandleComputerTurn(game);
+        return;
+    }
+
+    Vector2 mousePos = GetMousePosition();
+
+    // -------- SCRATCH MODE --------
+    if (game->state == GAME_SCRATCH) {
+
+        // Player can place cue ball inside valid area
+
+        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
+            PlayPlacement(game, mousePos);
+        return;
+    }
+
+    // Ignore input if balls are moving
+    if (game->ballsMoving) return;
+    Vector2 cueBallPos = 
+        game->balls[0].pocketed ?
+        game->cueBallPos :
+        game->balls[0].position;
+
+    // Start drag if clicking near cue ball
+    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        if (Distance(mousePos, cueBallPos) <= BALL_RADIUS*1.6f) {
+            game->aiming = true;
+            game->dragStart = mousePos;
+            game->stickPullPixels = 0.0f;
+            game->power = 0.0f;
+        }
+    }
+
+    // While dragging mouse
+
+    if (IsMouseButtonDown(MOUSE_LEFT_BUTTON) && 
+        game->aiming) {
+        float d = Distance(mousePos, cueBallPos);
+        if (d > MAX_POWER_PIXELS)
+            d = MAX_POWER_PIXELS;
+        game->stickPullPixels = d;
+        game->power = d / MAX_POWER_PIXELS;
+    }
+
+    // Release mouse → shoot
+
+    if (game->aiming &&
+        IsMouseButtonReleased(MOUSE_LEFT_BUTTON)) {
+        game->aiming = false;
+        ShotParams shot;
+        if (!ShotFromDrag(cueBallPos, mousePos,
+                          game->stickPullPixels, &shot)) return;
+
+        // Apply velocity to cue ball
+        game->power = 0.0f;
+        if (!PlayShot(game, shot)) return;
+
+        // The computer plays next: it can start on where this stops
+        if (computerPlayer >= 0) PonderAIShot(&aiWorker, game);
+
+        // Start recoil animation
+
+        game->stickRecoil = true;
+        game->recoilTimer = 0.12f;
+    }
+}
+
+// Replay playback: shots play one after another as the table comes to
+// rest. P pauses, LEFT and RIGHT jump to the previous or next shot.
+void HandleReplayInput(Game *game) {
+
+    if (IsKeyPressed(KEY_P))
+        replayPaused = !replayPaused;
+
+    // A struck ball is awake before the first step sets ballsMoving. A
+    // game that ended mid-shot freezes, so it counts as done.
+    bool rolling = (game->ballsMoving || AreBallsMoving(game)) &&
+                   (game->state == GAME_PLAYING || game->state == GAME_SCRATCH);
+
+    // The shot on the table, or the one about to be played
+    int current = rolling ? player.nextShot - 1 : player.nextShot;
+    int target = -1;
+    if (IsKeyPressed(KEY_RIGHT) && current < player.shotCount)
+        target = current + 1;
+    if (IsKeyPressed(KEY_LEFT))
+        target = current > 0 ? current - 1 : 0;
+
+    if (target >= 0 && SeekReplay(&player, game, target)) {
+        rolling = false;
+        sprintf(game->statusMessage, "Replay: shot %d of %d",
+                target + 1, player.shotCount);
+    }
+
+    if (!replayPaused && !rolling && PlayNextShot(&player, game)) {
+        sprintf(game->statusMessage, "Replay: shot %d of %d",
+                player.nextShot, player.shotCount);
+    }
+}
+
+// The computer's turn: once the balls are at rest the table goes to the
+// AI thread, and PollComputerShot plays the answer when it comes back.
+void HandleComputerTurn(Game *game) {
+
+    if (aiThinking || game->ballsMoving || AreBallsMoving(game) ||
+        game->state == GAME_WON || game->state == GAME_LOST)
+        return;
+
+    // A full mailbox is tried again next frame
+    if (!RequestAIShot(&aiWorker, game, &aiRequest)) return;
+    aiThinking = true;
+    sprintf(game->statusMessage, "%s is thinking...",
+            game->players[game->currentPlayer].name);
+}
+
+// Plays the computer's shot if it has arrived. Answers to requests
+// that were cancelled or replaced are dropped, and so is one the physics
+// thread has no room for: HandleComputerTurn then asks again.
+void PollComputerShot(Game *game) {
+
+    AIResult result;
+    while (PollAIResult(&aiWorker, &result)) {
+        if (!aiThinking || result.id != aiRequest) continue;
+        aiThinking = false;
+
+        // The AI thread could not read the table: play a random shot
+        if (result.failed)
+            SampleAIShot(game, game->currentPlayer, &aiFallbackSeed,
+                         &result.shot);
+
+        // A placement the table refuses falls back to the spot, as in
+        // PlayAIShot, so the cue ball is never struck from a pocket
+        const AIShot *best = &result.shot;
+        if (best->placed && !PlayPlacement(game, best->placement) &&
+            !PlayPlacement(game, game->cueBallPos))
+            continue;
+        if (!PlayShot(game, best->shot)) continue;
+
+        game->stickRecoil = true;
+        game->recoilTimer = 0.12f;
+    }
+}
+
+// After a restart or a load: whatever the computer was working on no
+// longer applies
+void CancelComputer(void) {
+    if (computerPlayer < 0) return;
+    CancelAIShot(&aiWorker);
+    aiThinking = false;
+}
+
+// Marks the --ai player as the computer, again after every restart
+void SetComputerPlayer(Game *game) {
+    if (computerPlayer < 0) return;
+    game->players[computerPlayer].computer = true;
+    strcpy(game->players[computerPlayer].name, "Computer");
+}
+
+// Frame playback: one recorded frame per drawn frame, ten while RIGHT
+// is held; P pauses. The last frame stays on screen at the end.
+void PlayFrames(Game *game) {
+
+    if (IsKeyPressed(KEY_P))
+        replayPaused = !replayPaused;
+    if (replayPaused) return;
+
+    int count = IsKeyDown(KEY_RIGHT) ? FRAMES_FAST_FORWARD : 1;
+    for (int n = 0; n < count; n++) {
+        if (!DecodeTrajectoryFrame(&frameDecoder)) {
+            strcpy(game->statusMessage, "End of recording");
+            break;
+        }
+    }
+    ApplyTrajectoryFrame(&frameDecoder, game);
+    game->accumulator = 0.0f;
+}
+
+// Shots and cue placements go through these, so a physics thread plays
+// them too and a recording keeps them. The game's copy plays them at
+// once; the physics thread's frames are only read again once they
+// include them. When its queue is full, or a new table has not reached
+// it yet, the input is refused with a message and nothing is played or
+// recorded.
+bool PlayShot(Game *game, ShotParams shot) {
+    if (physicsThreaded && (physicsTablePending ||
+                            !SendPhysicsShot(&physicsThread, shot))) {
+        strcpy(game->statusMessage, "Physics busy, shoot again");
+        return false;
+    }
+    if (recording) RecordShot(&recorder, game, shot);
+    StrikeCueBall(game, shot.direction, shot.speed);
+    return true;
+}
+
+bool PlayPlacement(Game *game, Vector2 position) {
+    if (physicsThreaded && (physicsTablePending ||
+                            !SendPhysicsPlacement(&physicsThread, position))) {
+        strcpy(game->statusMessage, "Physics busy, place again");
+        return false;
+    }
+    if (recording) RecordPlacement(&recorder, game, position);
+    return PlaceCueBall(game, position);
+}
+
+// After a restart or a load: the physics thread takes the whole table.
+// If its queue is full, UpdateGame sends it again every frame until it
+// goes.
+void TableReplaced(Game *game) {
+    if (physicsThreaded)
+        physicsTablePending = !SendPhysicsTable(&physicsThread, game);
+}
+
+// Takes the newest step from the physics thread, keeping the cue stick,
+// the aim and who plays for the computer, which only this thread
+// changes. A status line from the rules replaces the game's own only
+// when it is new. The accumulator becomes the age of the step, which
+// DrawGame interpolates with as before.
+void ReadPhysicsView(Game *game) {
+
+    const PhysicsFrame *frame = ReadPhysicsFrame(&physicsThread);
+    if (frame != NULL) {
+        bool aiming = game->aiming;
+        Vector2 dragStart = game->dragStart;
+        float stickPullPixels = game->stickPullPixels;
+        float power = game->power;
+        bool stickRecoil = game->stickRecoil;
+        float recoilTimer = game->recoilTimer;
+        bool computer[2] = { game->players[0].computer,
+                             game->players[1].computer };
+        char status[sizeof game->statusMessage];
+        strcpy(status, game->statusMessage);
+
+        *game = frame->table;
+        game->aiming = aiming;
+        game->dragStart = dragStart;
+        game->stickPullPixels = stickPullPixels;
+        game->power = power;
+        game->stickRecoil = stickRecoil;
+        game->recoilTimer = recoilTimer;
+        for (int p = 0; p < 2; p++)
+            game->players[p].computer = computer[p];
+        if (strcmp(frame->table.statusMessage, physicsStatus) != 0)
+            strcpy(physicsStatus, frame->table.statusMessage);
+        else
+            strcpy(game->statusMessage, status);
+        physicsFrameTime = frame->time;
+    }
+
+    float age = (float)(PhysicsClock() - physicsFrameTime);
+    float stepSeconds = 1.0f / game->physicsHz;
+    game->accumulator = age < 0.0f ? 0.0f : age > stepSeconds ? stepSeconds : age;
+}
+
+// Copies the cached table and strip layers to the screen, redrawing
+// either first if its colours changed. Render textures are stored
+// upside down, hence the negative source height.
+void DrawTable() {
+    UpdateTableLayer();
+    BeginDrawing();
+    ClearBackground(themes[currentTheme].felt);
+
+    Texture2D table = tableLayer.texture.texture;
+    DrawTextureRec(table,
+                   (Rectangle){ 0, 0, (float)table.width, (float)-table.height },
+                   (Vector2){ 0, 0 },
+                   WHITE);
+    Texture2D strip = stripLayer.texture.texture;
+    DrawTextureRec(strip,
+                   (Rectangle){ 0, 0, (float)strip.width, (float)-strip.height },
+                   (Vector2){ 0, TABLE_HEIGHT },
+                   WHITE);
+}
+
+// The themes share a strip colour, so T redraws only the table layer
+void UpdateTableLayer(void) {
+    const TableTheme *theme = &themes[currentTheme];
+    Color table[] = { theme->rail, theme->felt, theme->pocket };
+    UpdateLayer(&tableLayer, TABLE_WIDTH, TABLE_HEIGHT, table, 3, DrawStaticTable);
+    UpdateLayer(&stripLayer, TABLE_WIDTH, 100, &theme->strip, 1, DrawStrip);
+}
+
+void UpdateLayer(TableLayer *layer, int width, int height, const Color *colors,
+                 int colorCount, void (*draw)(const TableTheme *theme)) {
+
+    bool stale = !layer->loaded;
+    for (int i = 0; i < colorCount; i++) {
+        if (ColorToInt(layer->colors[i]) != ColorToInt(colors[i]))
+            stale = true;
+        layer->colors[i] = colors[i];
+    }
+    if (!stale) return;
+
+    if (!layer->loaded) {
+        layer->texture = LoadRenderTexture(width, height);
+        layer->loaded = true;
+    }
+    BeginTextureMode(layer->texture);
+    draw(&themes[currentTheme]);
+    EndTextureMode();
+}
+
+// Draws the face of every ball on the table into its atlas cell, cell
+// n holding ball number n. Called once the window exists.
+void LoadBallAtlas(const Game *game) {
+
+    ballAtlas = LoadRenderTexture(MAX_BALLS * BALL_CELL, BALL_CELL);
+    SetTextureFilter(ballAtlas.texture, TEXTURE_FILTER_BILINEAR);
+
+    BeginTextureMode(ballAtlas);
+    ClearBackground(BLANK);
+    for (int i = 0; i < game->ballCount; i++) {
+        const Ball *ball = &game->balls[i];
+        if (ball->number >= MAX_BALLS) continue;
+        Vector2 center = { ball->number * BALL_CELL + BALL_CELL * 0.5f,
+                           BALL_CELL * 0.5f };
+
+        // Draw ball body
+        DrawCircleV(center, BALL_RADIUS, BallColor(ball));
+
+        // Draw stripe if striped ball
+        if (ball->isStriped)
+            DrawCircleLines(center.x, center.y, BALL_RADIUS, WHITE);
+
+        // Draw ball number (except cue ball)
+        if (ball->number != 0) {
+            char num[3];
+            sprintf(num, "%d", ball->number);
+            DrawText(num, center.x - 6, center.y - 6, 12, WHITE);
+        }
+    }
+    EndTextureMode();
+}
+
+// Everything on the table under the balls that does not move
+void DrawStaticTable(const TableTheme *theme) {
+    ClearBackground(theme->felt);
+
+    // Draw wooden outer border
+    DrawRectangle(0, 0, TABLE_WIDTH, TABLE_HEIGHT, theme->rail);
+
+    // Draw inner table (playing surface)
+    DrawRectangle(RAIL_WIDTH, RAIL_WIDTH,
+                  TABLE_WIDTH - 2*RAIL_WIDTH,
+                  TABLE_HEIGHT - 2*RAIL_WIDTH,
+                  theme->felt);
+
+    // Draw pockets (6 total)
+    Vector2 pockets[] = {
+        {RAIL_WIDTH, RAIL_WIDTH},
+        {TABLE_WIDTH*0.5f, RAIL_WIDTH},
+        {TABLE_WIDTH - RAIL_WIDTH, RAIL_WIDTH},
+        {RAIL_WIDTH, TABLE_HEIGHT - RAIL_WIDTH},
+        {TABLE_WIDTH*0.5f, TABLE_HEIGHT - RAIL_WIDTH},
+        {TABLE_WIDTH - RAIL_WIDTH, TABLE_HEIGHT - RAIL_WIDTH}
+    };
+
+    for (int i = 0; i < 6; i++) {
+        DrawCircleV(pockets[i], POCKET_RADIUS, theme->pocket);
+    }
+}
+
+// The UI area under the table, drawn at the top of its own layer
+void DrawStrip(const TableTheme *theme) {
+    ClearBackground(theme->strip);
+}
+
+//------------------------ Draws the power bar UI showing the current shot power-------------------
+
+void DrawPowerBar(Game *game) {
+
+    float barWidth = 300;
+    float barHeight = 20;
+    float x = (TABLE_WIDTH - barWidth) / 2;
+    float y = TABLE_HEIGHT + 40;
+
+    // Outline
+    DrawRectangleLines(x, y, barWidth, barHeight, WHITE);
+
+    // Fill based on power
+
+    DrawRectangle(x, y,
+                  barWidth * game->power,
+                  barHeight,
+                  RED);
+    DrawText("Power", x - 60, y,20,  WHITE);
+}
+
+//-----------------Draws the entire game scene: table, balls, aiming line, UI, status, and power bar-------------
+
+void DrawGame(Game *game) {
+    TRACE_BEGIN("DrawGame");
+    PROFILE_BEGIN(PROFILE_DRAW);
+    DrawTable();
+
+    // How far we are between the last two physics steps
+    float alpha = game->accumulator * game->physicsHz;
+    if (alpha > 1.0f) alpha = 1.0f;
+
+    // Draw balls, each a copy of its atlas cell
+    Texture2D atlas = ballAtlas.texture;
+    for (int i = 0; i < game->ballCount; i++) {
+        if (game->balls[i].pocketed)
+            continue;
+
+        Vector2 previous = game->previousPositions[i];
+        Vector2 position = {
+            previous.x + (game->balls[i].position.x - previous.x) * alpha,
+            previous.y + (game->balls[i].position.y - previous.y) * alpha
+        };
+
+        DrawTextureRec(atlas,
+                       (Rectangle){ (float)(game->balls[i].number * BALL_CELL), 0,
+                                    BALL_CELL, -BALL_CELL },
+                       (Vector2){ position.x - BALL_CELL * 0.5f,
+                                  position.y - BALL_CELL * 0.5f },
+                       WHITE);
+    }
+
+    // Draw aiming line
+    if (game->aiming && !game->ballsMoving)
+        DrawAimPreview(game);
+    else
+        aimPreview.valid = false;
+
+    // Draw status message
+    DrawText(game->statusMessage,
+             20,
+             TABLE_HEIGHT + 10,
+             20,
+             WHITE);
+
+    // Draw power bar
+    DrawPowerBar(game);
+
+#ifdef PROFILE_ENABLED
+    if (showProfiler)
+        DrawProfiler();
+#endif
+
+    // Stop before EndDrawing, which also waits out the frame limiter
+    PROFILE_END(PROFILE_DRAW);
+    EndDrawing();
+    TRACE_END("DrawGame");
+}
+
+//------------------------ Draws the aiming line and the shot preview -------------------
+
+void DrawAimPreview(Game *game) {
+
+    Vector2 cuePos = game->balls[0].position;
+    Vector2 mouse = GetMousePosition();
+    DrawLineV(cuePos, mouse, WHITE);
+
+    // The table is at rest while aiming, so only the aim can change it
+    AimPreview *aim = &aimPreview;
+    if (!aim->valid ||
+        mouse.x != aim->mouse.x || mouse.y != aim->mouse.y ||
+        cuePos.x != aim->cue.x || cuePos.y != aim->cue.y) {
+
+        ShotParams shot;
+        aim->valid = true;
+        aim->mouse = mouse;
+        aim->cue = cuePos;
+        aim->hasShot = ShotFromDrag(cuePos, mouse, game->stickPullPixels, &shot);
+        if (aim->hasShot) {
+            PredictRoll(game, cuePos,
+                        (Vector2){shot.direction.x * shot.speed,
+                                  shot.direction.y * shot.speed},
+                        &aim->roll);
+            aim->hit = PredictContact(game, 0, &aim->roll, &aim->contact);
+        }
+    }
+    if (!aim->hasShot) return;
+
+    const RollPrediction *roll = &aim->roll;
+    const ContactPrediction *contact = &aim->contact;
+
+    // Without a contact: where the cue ball would roll and stop
+    if (!aim->hit) {
+        for (int p = 1; p < roll->pointCount; p++)
+            DrawLineV(roll->points[p - 1], roll->points[p], Fade(WHITE, 0.35f));
+        DrawCircleLines(roll->stopPosition.x,
+                        roll->stopPosition.y,
+                        BALL_RADIUS,
+                        Fade(WHITE, 0.5f));
+        return;
+    }
+
+    // Path up to the ghost ball, then both balls' directions after the
+    // hit, each as long as its share of the speed
+    for (int p = 1; p <= contact->segment; p++)
+        DrawLineV(roll->points[p - 1], roll->points[p], Fade(WHITE, 0.35f));
+    DrawLineV(roll->points[contact->segment], contact->ghost, Fade(WHITE, 0.35f));
+    DrawCircleLines(contact->ghost.x,
+                    contact->ghost.y,
+                    BALL_RADIUS,
+                    Fade(WHITE, 0.7f));
+
+    Vector2 object = game->balls[contact->ball].position;
+    DrawLineV(contact->ghost,
+              (Vector2){contact->ghost.x + contact->cueAfter.x * AIM_LINE_LENGTH,
+                        contact->ghost.y + contact->cueAfter.y * AIM_LINE_LENGTH},
+              Fade(WHITE, 0.6f));
+    DrawLineV(object,
+              (Vector2){object.x + contact->objectAfter.x * AIM_LINE_LENGTH,
+                        object.y + contact->objectAfter.y * AIM_LINE_LENGTH},
+              Fade(YELLOW, 0.8f));
+}
+
+//------------------------ Draws the profiler overlay at the right of the UI strip -------------------
+
+#ifdef PROFILE_ENABLED
+void DrawProfiler(void) {
+    int x = TABLE_WIDTH - 235;
+    int y = TABLE_HEIGHT + 6;
+    char line[64];
+
+    DrawText("phase      last   min   avg   p99 (us)", x, y, 10, LIGHTGRAY);
+    y += 11;
+
+    for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+        ProfileStats stats;
+        GetPhaseStats(p, &stats);
+        sprintf(line, "%-8s %6.0f %5.0f %5.0f %5.0f",
+                ProfilePhaseName(p), stats.last, stats.min, stats.avg, stats.p99);
+        DrawText(line, x, y, 10, WHITE);
+        y += 10;
+    }
+
+    for (int c = 0; c < PROFILE_COUNTER_COUNT; c++) {
+        ProfileStats stats;
+        GetCounterStats(c, &stats);
+        sprintf(line, "%-8s %6.0f %5.0f %5.0f %5.0f",
+                ProfileCounterName(c), stats.last, stats.min, stats.avg, stats.p99);
+        DrawText(line, x, y, 10, YELLOW);
+        y += 10;
+    }
+}
+#endif
+
+// Maps a ball number to its face colour
+Color BallColor(const Ball *ball) {
+
+    // Define colors
+    Color solidColors[] = { YELLOW, BLUE, RED, PURPLE, 
+                            ORANGE, GREEN, MAROON };
+    Color stripeColors[] = { YELLOW, BLUE, RED, PURPLE, 
+                             ORANGE, GREEN, MAROON };
+
+    if (ball->type == BALL_CUE) return WHITE;
+    if (ball->type == BALL_EIGHT) return BLACK;
+    if (ball->type == BALL_SOLID) return solidColors[ball->number - 1];
+
+    int sidx = ball->number - 9;
+    if (sidx < 0) sidx = 0;
+    return stripeColors[sidx];
+}